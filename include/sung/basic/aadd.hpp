@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sung/basic/densify.hpp"
+#include "sung/basic/mapped_file.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    /*
+    With CompMethod::z the data array is replaced by
+
+        LEValue<uint64_t> chunk_elements
+        LEValue<uint64_t> index_offset
+        chunks
+        array<LEValue<uint64_t>, chunk_count + 1> index
+
+    Every chunk holds `chunk_elements` elements, except the last which can
+    be shorter. Chunks are byte shuffled (see lz.hpp) then LZ compressed.
+    A chunk that doesn't shrink is stored as is, telling from its size.
+    The index holds chunk start offsets and then the end of the last one.
+    Offsets, including `index_offset`, count from `chunk_elements`.
+    */
+
+    /*
+    Bulk conversion between any data type and float or double. Integers are
+    rounded and clamped to their range on encode, NaN becomes 0. float16 is
+    converted with F16C where the compiler targets it. The typed side needs
+    no alignment. False for unknown data types.
+    */
+
+    bool decode_aadd_values(
+        float* dst, const void* src, size_t count, AaddHeader::DataType type
+    );
+    bool decode_aadd_values(
+        double* dst, const void* src, size_t count, AaddHeader::DataType type
+    );
+    bool encode_aadd_values(
+        void* dst, AaddHeader::DataType type, const float* src, size_t count
+    );
+    bool encode_aadd_values(
+        void* dst, AaddHeader::DataType type, const double* src, size_t count
+    );
+
+
+    /*
+    Writes an AADD file front to back without holding the data in memory.
+    Dimensions and the description are set first, then data is appended in
+    any number of calls. The header goes out with a data count of 0 and is
+    rewritten with the real count on `close`.
+
+    Data is written in host byte order, and collected into a buffer of
+    `buffer_size` bytes so small appends don't each hit the file. With
+    compression, whole chunks are held instead, several at a time if there
+    is a task scheduler to compress them on.
+    */
+    class AaddWriter {
+
+    public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+        static constexpr size_t DEFAULT_CHUNK_ELEMENTS = 1 << 16;
+        // Chunks compressed together when there is a scheduler
+        static constexpr size_t CHUNK_BATCH = 16;
+
+        AaddWriter() = default;
+        ~AaddWriter();
+
+        AaddWriter(const AaddWriter&) = delete;
+        AaddWriter& operator=(const AaddWriter&) = delete;
+
+        // Truncates `path`. Fails for data types of unknown size.
+        bool open(
+            const std::string& path,
+            AaddHeader::DataType data_type,
+            size_t buffer_size = DEFAULT_BUFFER_SIZE
+        );
+        // Flushes and writes the final header. False if any write failed.
+        bool close();
+        bool is_open() const;
+
+        // Only before the first `write_data`
+        bool add_dimension(const AaddHeader::Dimension& dim);
+        bool add_dimension(
+            double min, double max, uint64_t count, const char* name
+        );
+        bool set_description(const std::string& desc);
+        bool set_compression(
+            AaddHeader::CompMethod method,
+            ITaskScheduler* sche = nullptr,
+            size_t chunk_elements = DEFAULT_CHUNK_ELEMENTS
+        );
+
+        // `count` elements of the data type
+        bool write_data(const void* data, size_t count);
+        // Converted to the data type first
+        bool write_values(const float* data, size_t count);
+        bool write_values(const double* data, size_t count);
+
+        uint64_t data_count() const { return data_count_; }
+        AaddHeader::DataType data_type() const { return data_type_; }
+
+    private:
+        AaddHeader make_header() const;
+        bool begin_data();
+        bool put(const void* data, size_t size);
+        bool flush();
+        // Compresses and writes the full chunks in `pending_`, and the
+        // partial one too if `last`
+        bool write_chunks(bool last);
+        bool finish_chunks();
+        template <typename T>
+        bool write_values_impl(const T* data, size_t count);
+
+        std::ofstream file_;
+        std::vector<AaddHeader::Dimension> dims_;
+        std::string desc_;
+        std::vector<byte8> buffer_;
+        size_t buffer_size_ = 0;
+        size_t type_size_ = 0;
+        uint64_t data_count_ = 0;
+        uint64_t written_ = 0;
+        AaddHeader::DataType data_type_ = AaddHeader::DataType::float32;
+        bool data_started_ = false;
+        bool failed_ = false;
+
+        // Compression
+        std::vector<byte8> pending_;
+        std::vector<uint64_t> chunk_offsets_;
+        ITaskScheduler* sche_ = nullptr;
+        size_t chunk_elements_ = 0;
+        uint64_t chunks_begin_ = 0;
+        AaddHeader::CompMethod comp_method_ = AaddHeader::CompMethod::none;
+    };
+
+
+    /*
+    Typed view over AADD data. Dimension 0 varies fastest, like x in images.
+    Strides are in elements and a view can be sliced down without copying.
+
+    The payload follows the description, so it's usually not aligned for
+    `T`. Reads go through memcpy, which compiles to plain loads.
+    */
+    template <typename T>
+    class AaddView {
+
+    public:
+        // Dense data with the given element count per dimension
+        void set(const byte8* data, const std::vector<uint64_t>& counts) {
+            data_ = data;
+            counts_ = counts;
+            strides_.resize(counts.size());
+            uint64_t stride = 1;
+            for (size_t i = 0; i < counts.size(); ++i) {
+                strides_[i] = stride;
+                stride *= counts[i];
+            }
+        }
+
+        size_t dim_count() const { return counts_.size(); }
+        uint64_t count(size_t axis) const { return counts_[axis]; }
+        uint64_t stride(size_t axis) const { return strides_[axis]; }
+
+        uint64_t size() const {
+            uint64_t out = counts_.empty() ? 0 : 1;
+            for (auto x : counts_) out *= x;
+            return out;
+        }
+
+        // One coordinate per dimension, not bound checked
+        T at(const uint64_t* coords) const {
+            uint64_t index = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+                index += coords[i] * strides_[i];
+            return this->load(index);
+        }
+
+        // Along dimension 0
+        T operator[](uint64_t i) const { return this->load(i * strides_[0]); }
+
+        // Fixes `axis` at `index` and drops that dimension
+        AaddView slice(size_t axis, uint64_t index) const {
+            AaddView out;
+            out.data_ = data_ + index * strides_[axis] * sizeof(T);
+            for (size_t i = 0; i < counts_.size(); ++i) {
+                if (i == axis)
+                    continue;
+                out.counts_.push_back(counts_[i]);
+                out.strides_.push_back(strides_[i]);
+            }
+            return out;
+        }
+
+        const byte8* data() const { return data_; }
+
+        // Null unless the data is aligned for `T`
+        const T* aligned_ptr() const {
+            const auto addr = reinterpret_cast<uintptr_t>(data_);
+            if (0 != addr % alignof(T))
+                return nullptr;
+            return reinterpret_cast<const T*>(data_);
+        }
+
+    private:
+        T load(uint64_t index) const {
+            T out;
+            std::memcpy(&out, data_ + index * sizeof(T), sizeof(T));
+            return out;
+        }
+
+        const byte8* data_ = nullptr;
+        std::vector<uint64_t> counts_;
+        std::vector<uint64_t> strides_;
+    };
+
+
+    /*
+    Memory mapped AADD file. `open` checks the header and that the file is
+    large enough, and nothing is copied. Dimension records and the data are
+    read in place.
+
+    Compressed data can't be viewed, it's decoded a chunk at a time or all
+    at once into a buffer of `data_size()` bytes.
+    */
+    class AaddReader {
+
+    public:
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const;
+
+        const AaddHeader& header() const;
+        const AaddHeader::Dimension& dimension(size_t index) const;
+        std::string description() const;
+
+        // Null for compressed files
+        const byte8* data() const;
+        uint64_t data_offset() const { return data_offset_; }
+        // Decoded size
+        uint64_t data_size() const { return data_size_; }
+
+        // Zero for uncompressed files
+        uint64_t chunk_count() const { return chunk_count_; }
+        uint64_t chunk_elements() const { return chunk_elements_; }
+        // Elements in chunk `index`, the last one can be short
+        uint64_t chunk_size(uint64_t index) const;
+        // Decodes one chunk into `dst`, of `chunk_size(index)` elements
+        bool read_chunk(uint64_t index, void* dst) const;
+        // Decodes or copies all data, chunks in parallel if `sche` is given
+        bool read_data(void* dst, ITaskScheduler* sche) const;
+        // All data converted to `dst`, with `header().data_count()` elements
+        bool read_values(float* dst, ITaskScheduler* sche) const;
+        bool read_values(double* dst, ITaskScheduler* sche) const;
+
+        // Fails if the size of `T` doesn't match the data type, or the
+        // dimension counts don't multiply up to the data count. Files
+        // without dimensions give a 1D view. float16 is read as uint16_t.
+        template <typename T>
+        bool make_view(AaddView<T>& out) const {
+            std::vector<uint64_t> counts;
+            if (!this->check_view(sizeof(T), counts))
+                return false;
+            out.set(this->data(), counts);
+            return true;
+        }
+
+        // Applies to the data only
+        void advise(AccessHint hint) const;
+        void advise(AccessHint hint, uint64_t first, uint64_t count) const;
+
+    private:
+        bool check_view(size_t type_size, std::vector<uint64_t>& counts) const;
+        bool open_chunks(uint64_t remaining);
+        template <typename T>
+        bool read_values_impl(T* dst, ITaskScheduler* sche) const;
+        uint64_t chunk_offset(uint64_t index) const;
+
+        MappedFile file_;
+        uint64_t data_offset_ = 0;
+        uint64_t data_size_ = 0;
+        uint64_t type_size_ = 0;
+        uint64_t chunk_count_ = 0;
+        uint64_t chunk_elements_ = 0;
+        uint64_t index_offset_ = 0;
+    };
+
+}  // namespace sung
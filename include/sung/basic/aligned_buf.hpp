@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sung {
+
+    // Cache line size and the widest SIMD register we care about
+    constexpr size_t SIMD_ALIGNMENT = 64;
+    // Transparent huge page size on x86-64 Linux
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+
+    /*
+    Returns nullptr on failure. `align` must be a power of two. If
+    `huge_pages` is true and the allocation is at least HUGE_PAGE_SIZE, it is
+    aligned to HUGE_PAGE_SIZE, and the whole huge pages in it are advised
+    for transparent huge pages on Linux. The size is not rounded up. The
+    hint is ignored on other platforms.
+    */
+    void* alloc_aligned(size_t bytes, size_t align, bool huge_pages);
+    // Frees memory from `alloc_aligned`, nullptr is allowed
+    void free_aligned(void* ptr) noexcept;
+
+
+    /*
+    Allocator for std::vector with over-aligned storage. Elements constructed
+    without arguments are default-initialized instead of value-initialized,
+    so `resize(n)` leaves trivial types uninitialized. Use `resize(n, T{})` to
+    zero them.
+    */
+    template <
+        typename T,
+        size_t Align = SIMD_ALIGNMENT,
+        bool HugePages = false>
+    class AlignedAllocator {
+
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Align, HugePages>;
+        };
+
+        AlignedAllocator() noexcept = default;
+
+        template <typename U>
+        AlignedAllocator(
+            const AlignedAllocator<U, Align, HugePages>&
+        ) noexcept {}
+
+        T* allocate(size_t n) {
+            if (n > static_cast<size_t>(-1) / sizeof(T))
+                throw std::bad_alloc{};
+
+            constexpr auto ALIGN = Align > alignof(T) ? Align : alignof(T);
+            const auto ptr = alloc_aligned(n * sizeof(T), ALIGN, HugePages);
+            if (nullptr == ptr)
+                throw std::bad_alloc{};
+            return static_cast<T*>(ptr);
+        }
+
+        void deallocate(T* ptr, size_t) noexcept { free_aligned(ptr); }
+
+        template <typename U>
+        void construct(U* ptr) noexcept(
+            std::is_nothrow_default_constructible<U>::value
+        ) {
+            ::new (static_cast<void*>(ptr)) U;
+        }
+
+        template <typename U, typename... Args>
+        void construct(U* ptr, Args&&... args) {
+            ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+        }
+    };
+
+    template <typename T, typename U, size_t Align, bool HugePages>
+    bool operator==(
+        const AlignedAllocator<T, Align, HugePages>&,
+        const AlignedAllocator<U, Align, HugePages>&
+    ) noexcept {
+        return true;
+    }
+
+    template <typename T, typename U, size_t Align, bool HugePages>
+    bool operator!=(
+        const AlignedAllocator<T, Align, HugePages>&,
+        const AlignedAllocator<U, Align, HugePages>&
+    ) noexcept {
+        return false;
+    }
+
+
+    // Storage of TAlignedImage3D, aligned for SIMD and huge page backed if
+    // large
+    template <typename T>
+    using ImageBuffer =
+        std::vector<T, AlignedAllocator<T, SIMD_ALIGNMENT, true>>;
+
+}  // namespace sung
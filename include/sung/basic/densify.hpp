@@ -1,15 +1,21 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "sung/basic/aabb.hpp"
 #include "sung/basic/bytes.hpp"
+#include "sung/basic/mapped_file.hpp"
+#include "sung/basic/threading.hpp"
 
 
 namespace sung {
 
+    class AaddWriter;
+
+
     class ValArrayAnalyzer {
 
     public:
@@ -21,9 +27,25 @@ namespace sung {
         // Apply abs to diff
         void notify_abs(double value);
 
-        void do_array(const double* data, size_t count);
+        /*
+        Same result as reset followed by notify on every value, but without
+        a branch per value so the loop vectorizes. Large arrays are split
+        across the scheduler's workers if one is given.
+        */
+        void do_array(
+            const double* data, size_t count, ITaskScheduler* sche = nullptr
+        );
+        void do_array(
+            const float* data, size_t count, ITaskScheduler* sche = nullptr
+        );
+        // Doubles `size` bytes apart, starting `offset` bytes into `data`.
+        // They need not be aligned.
         void do_array(
-            const byte8* data, size_t count, size_t size, size_t offset
+            const byte8* data,
+            size_t count,
+            size_t size,
+            size_t offset,
+            ITaskScheduler* sche = nullptr
         );
 
         size_t count() const;
@@ -42,6 +64,9 @@ namespace sung {
         double diff_theshold_ = 0;
 
     private:
+        template <typename TLoad>
+        void do_array_impl(const TLoad& load, size_t count, ITaskScheduler*);
+
         sung::Aabb1DLazyInit<double> value_range_;
         sung::Aabb1DLazyInit<double> diff_range_;
         size_t count_;
@@ -50,6 +75,114 @@ namespace sung {
     };
 
 
+    /*
+    Counts values into equal width bins over [mini, maxi). Values outside
+    go to the underflow and overflow counts, NaN is ignored. Histograms
+    with the same bins can be filled on separate threads and merged.
+    */
+    class FixedHistogram {
+
+    public:
+        FixedHistogram() = default;
+        FixedHistogram(double mini, double maxi, size_t bin_count);
+
+        void reset(double mini, double maxi, size_t bin_count);
+        void clear();
+
+        void notify(double value);
+        // False if the bins differ
+        bool merge(const FixedHistogram& other);
+
+        size_t bin_count() const { return bins_.size(); }
+        uint64_t bin(size_t index) const { return bins_[index]; }
+        double bin_width() const { return width_; }
+        // Lower edge of the bin
+        double bin_mini(size_t index) const;
+
+        uint64_t underflow() const { return underflow_; }
+        uint64_t overflow() const { return overflow_; }
+        // Every value but NaN, including those out of range
+        uint64_t total() const;
+
+        // Interpolated within the bin, clamped to [mini, maxi]
+        double quantile(double q) const;
+
+    private:
+        std::vector<uint64_t> bins_;
+        double mini_ = 0;
+        double maxi_ = 0;
+        double width_ = 0;
+        uint64_t underflow_ = 0;
+        uint64_t overflow_ = 0;
+    };
+
+
+    /*
+    KLL quantile sketch. Values are kept in levels of compactors, an item
+    at level h standing for 2^h values. A full level is sorted and every
+    other item is promoted, so memory stays at about 3k items plus a few
+    per level, and the rank error is roughly 1.7 / k. Sketches built on
+    separate threads can be merged.
+    */
+    class QuantileSketch {
+
+    public:
+        static constexpr size_t DEFAULT_K = 200;
+
+        explicit QuantileSketch(size_t k = DEFAULT_K);
+
+        void clear();
+
+        // NaN is ignored
+        void notify(double value);
+        void merge(const QuantileSketch& other);
+
+        uint64_t count() const { return count_; }
+        double mini() const { return mini_; }
+        double maxi() const { return maxi_; }
+        size_t k() const { return k_; }
+        // Items held, which bounds memory use
+        size_t retained() const { return size_; }
+
+        // Value with about `q` of all values below it, q in [0, 1]
+        double quantile(double q) const;
+        // Fraction of values at or below `value`
+        double rank(double value) const;
+
+    private:
+        size_t capacity(size_t level) const;
+        void update_size();
+        void compress();
+        bool next_bit();
+
+        std::vector<std::vector<double>> levels_;
+        uint64_t count_ = 0;
+        uint64_t rng_state_;
+        size_t k_;
+        // Items held and the sum of level capacities, kept up to date so
+        // notify doesn't walk the levels
+        size_t size_ = 0;
+        size_t max_size_ = 0;
+        double mini_ = 0;
+        double maxi_ = 0;
+    };
+
+
+    /*
+    Averages scattered samples into a dense grid and fills the cells that
+    got none. Grids of more than one dimension are stored flat with
+    dimension 0 varying fastest, like AADD data.
+
+    For many producer threads there are two ways without a lock. They can
+    share one builder through `add_val_atomic`, which is best when samples
+    are spread out. Or each can fill its own builder of the same shape, to
+    be combined with `merge` before finalizing, which is best when threads
+    keep hitting the same records.
+
+    Every record takes 16 bytes. Grids too big for RAM can be kept in a
+    scratch file with `resize_mapped`, and the result streamed out with
+    `write`, so only the pages in use need to be resident.
+    */
     class DenseDataBuilder {
 
     public:
@@ -62,20 +195,66 @@ namespace sung {
 
         DenseDataBuilder(size_t size);
 
+        // Copies always hold their records in memory, even if `other` is
+        // mapped, as a scratch file can't be shared
+        DenseDataBuilder(const DenseDataBuilder& other);
+        DenseDataBuilder& operator=(const DenseDataBuilder& other);
+        DenseDataBuilder(DenseDataBuilder&&) = default;
+        DenseDataBuilder& operator=(DenseDataBuilder&&) = default;
+
         bool empty() const;
         size_t size() const;
+        size_t dim_count() const;
+        const std::vector<size_t>& shape() const;
 
         void clear();
         void free_mem();
         void resize(size_t size);
+        // Element count per dimension
+        void resize_nd(const std::vector<size_t>& shape);
+        // Like resize_nd, but the records live in a memory mapped scratch
+        // file at `scratch_path` instead of RAM, for grids larger than
+        // memory. The file is gone once the builder is cleared, resized
+        // or destroyed, and the data with it. False if a file already
+        // exists at `scratch_path`, or the grid can't be addressed.
+        bool resize_mapped(
+            const std::vector<size_t>& shape, const std::string& scratch_path
+        );
+        bool is_mapped() const;
         void add_val(double val, size_t idx);
-
-        void finalize_1d();
+        // Safe to call from many threads at once, but not together with
+        // any other member function
+        void add_val_atomic(double val, size_t idx);
+        // One coordinate per dimension, ignored if out of range
+        void add_val_nd(double val, const size_t* coords);
+
+        // Adds the sums and counts of `other`, which needs the same size.
+        // Before finalizing either of them.
+        bool merge(const DenseDataBuilder& other, ITaskScheduler* sche);
+
+        // Fills gaps in one forward sweep. With `sche`, the array is split
+        // into chunks that are filled in parallel.
+        void finalize_1d(ITaskScheduler* sche = nullptr);
+        // Fails unless the grid is 2D
+        bool finalize_2d(ITaskScheduler* sche = nullptr);
+        // Interpolates along dimension 0 in every line that has samples,
+        // then fills what's left along dimension 1, and so on. Lines are
+        // done in parallel if `sche` is given.
+        void finalize_nd(ITaskScheduler* sche = nullptr);
 
         void copy(std::vector<float>& out) const;
+        // Streams the values into `writer` a block at a time, so they never
+        // need to fit in memory. Dimensions must already be added.
+        bool write(AaddWriter& writer) const;
 
     private:
-        std::vector<Record> records_;
+        Record* records();
+        const Record* records() const;
+        void advise(AccessHint hint) const;
+
+        std::vector<Record> memory_;
+        MappedScratchFile scratch_;
+        std::vector<size_t> shape_;
     };
 
 
@@ -151,7 +330,7 @@ namespace sung {
 
         // array<Dimension, dim_count_>
         // array<int8_t, desc_len_>
-        // array<data_type_, data_count_>
+        // array<data_type_, data_count_>, chunked as in aadd.hpp for z
     };
 
 }  // namespace sung
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sung {
+
+    /*
+    IEEE 754 binary16 stored as its raw bits. Conversion from float rounds
+    to nearest even, overflows to infinity and keeps NaNs quiet. Subnormals
+    are handled in both directions.
+    */
+
+    uint16_t float32_to_float16(float value);
+    float float16_to_float32(uint16_t value);
+
+    // Same results as the scalar functions. They use F16C if the compiler
+    // targets it (-mf16c, or /arch:AVX2 on MSVC).
+    void convert_float16_to_float32(
+        float* dst, const uint16_t* src, size_t count
+    );
+    void convert_float32_to_float16(
+        uint16_t* dst, const float* src, size_t count
+    );
+
+}  // namespace sung
@@ -122,6 +122,15 @@ namespace sung {
             return sung::nullopt;
         }
 
+        // Point on the triangle (including its interior) closest to `p`
+        Vec3 find_closest_point(const Vec3& p) const;
+        // `barycentric` gets weights of a, b and c, in that order. Components
+        // are exactly 0 when the point lies on an edge or a vertex.
+        Vec3 find_closest_point(const Vec3& p, Vec3& barycentric) const;
+
+        double calc_dist_sqr(const Vec3& p) const;
+        double calc_dist(const Vec3& p) const;
+
     private:
         bool radius_circumcircle(double& out) const;
         bool circumcenter(Vec3& out) const;
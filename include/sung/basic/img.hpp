@@ -2,12 +2,17 @@
 
 #include <vector>
 
+#include "sung/basic/aligned_buf.hpp"
 #include "sung/basic/bytes.hpp"
 #include "sung/basic/mamath.hpp"
 
 
 namespace sung {
 
+    template <typename DataType>
+    class TImageView3D;
+
+
     class ImageMetadata3D {
 
     public:
@@ -64,13 +69,25 @@ namespace sung {
     };
 
 
-    template <typename DataType>
+    // `Buffer` is a std::vector like container of DataType
+    template <typename DataType, typename Buffer = std::vector<DataType>>
     class TImage3D : public ImageMetadata3D {
 
     public:
+        // Texels are zero filled
         bool alloc(size_t channels, size_t x, size_t y = 1, size_t z = 1) {
             this->set_size(channels, x, y, z);
-            data_.resize(channels_ * x * y * z);
+            data_.resize(channels * x * y * z, DataType{});
+            return true;
+        }
+
+        // For data that is overwritten anyway. Texels are left uninitialized
+        // only if `Buffer` default-initializes, as ImageBuffer does.
+        bool alloc_uninit(
+            size_t channels, size_t x, size_t y = 1, size_t z = 1
+        ) {
+            this->set_size(channels, x, y, z);
+            data_.resize(channels * x * y * z);
             return true;
         }
 
@@ -95,10 +112,28 @@ namespace sung {
             return reinterpret_cast<const byte8*>(data_.data());
         }
 
-        std::vector<DataType> data_;
+        TImageView3D<DataType> make_view() const {
+            TImageView3D<DataType> view;
+            view.set(
+                data_.data(),
+                this->channels(),
+                this->width(),
+                this->height(),
+                this->depth()
+            );
+            return view;
+        }
+
+        Buffer data_;
     };
 
 
+    // SIMD aligned, huge page backed when large, and `alloc_uninit` really
+    // skips zero filling
+    template <typename DataType>
+    using TAlignedImage3D = TImage3D<DataType, ImageBuffer<DataType>>;
+
+
     template <typename DataType>
     class TImageView3D : public ImageMetadata3D {
 
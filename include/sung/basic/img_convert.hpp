@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    // How scalars of an Image2D are interpreted. ImageMetadata2D only knows
+    // their size, which can't tell uint16_t from float16.
+    enum class PixelScalar {
+        // Normalized to [0, 1]
+        unorm8,
+        unorm16,
+        float16,
+        float32,
+    };
+
+    size_t get_scalar_bytes(PixelScalar scalar);
+
+
+    struct PixelFormat {
+        PixelScalar scalar_ = PixelScalar::unorm8;
+        // Color channels are sRGB encoded. The last channel of 2 and 4
+        // channel images is alpha, which is always linear.
+        bool srgb_ = false;
+    };
+
+
+    /*
+    Source channel of each destination channel. SWIZZLE_ZERO and SWIZZLE_ONE
+    write constants instead, where one is the maximum for unorm scalars.
+    */
+    struct ChannelSwizzle {
+        static constexpr int SWIZZLE_ZERO = -1;
+        static constexpr int SWIZZLE_ONE = -2;
+
+        // Gray expands to RGB, missing alpha becomes one and extra channels
+        // are dropped
+        static ChannelSwizzle make_default(
+            size_t src_channels, size_t dst_channels
+        );
+
+        // RGBA <-> BGRA, or RGB <-> BGR
+        static ChannelSwizzle make_swap_rb();
+
+        std::array<int, 4> src_ = { 0, 1, 2, 3 };
+    };
+
+
+    /*
+    Converts the pixels of `src` into `dst`, both with 1 to 4 channels. Every
+    row is decoded to linear floats, swizzled, then encoded, except when both
+    formats are the same, in which case only the channels are shuffled.
+    8-bit sRGB goes through lookup tables, unorm8 and float16 have SIMD paths.
+
+    `dst` must already have its metadata set and data allocated, with the
+    same size as `src` and scalar bytes matching `dst_format`. Rows are
+    processed in bands on the task scheduler if one is given.
+    */
+    bool convert_image(
+        Image2D& dst,
+        const PixelFormat& dst_format,
+        const Image2D& src,
+        const PixelFormat& src_format,
+        const ChannelSwizzle& swizzle,
+        ITaskScheduler* sche
+    );
+
+    // Sets `dst` to be `dst_channels` without row padding, with the default
+    // swizzle
+    bool convert_image(
+        Image2D& dst,
+        const PixelFormat& dst_format,
+        size_t dst_channels,
+        const Image2D& src,
+        const PixelFormat& src_format,
+        ITaskScheduler* sche
+    );
+
+    /*
+    Converts `img` without another buffer. It fails if the new pixels are
+    larger than the old ones. Row padding is dropped, and rows are only done
+    in parallel if their size doesn't change.
+    */
+    bool convert_image_inplace(
+        Image2D& img,
+        const PixelFormat& dst_format,
+        size_t dst_channels,
+        const PixelFormat& src_format,
+        const ChannelSwizzle& swizzle,
+        ITaskScheduler* sche
+    );
+
+}  // namespace sung
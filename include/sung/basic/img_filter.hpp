@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    // Normalized Gaussian weights of length 2 * radius + 1. Radius of 0
+    // picks ceil(3 * sigma). Returns { 1 } if sigma is not positive.
+    std::vector<float> make_gaussian_kernel(double sigma, size_t radius = 0);
+
+
+    /*
+    Both filters below read from a view, write to `dst`, and work the same
+    way: each source row goes through the horizontal pass into a float
+    buffer, then the vertical pass writes the rows of `dst`. Edges are
+    clamped. `dst` gets the size and channels of `src`, with no row padding.
+
+    Rows are processed in bands on the task scheduler if one is given. `T`
+    can be uint8_t, uint16_t or float. Integer results are rounded and
+    clamped to their range.
+    */
+
+    // Kernels have odd length and are centered. They are not normalized.
+    template <typename T>
+    bool convolve_separable(
+        Image2D& dst,
+        const TImageView2D<T>& src,
+        const std::vector<float>& kernel_x,
+        const std::vector<float>& kernel_y,
+        ITaskScheduler* sche
+    );
+
+    // Mean of a (2 * radius_x + 1) by (2 * radius_y + 1) window, with
+    // running sums so the cost doesn't depend on the radius
+    template <typename T>
+    bool box_blur(
+        Image2D& dst,
+        const TImageView2D<T>& src,
+        size_t radius_x,
+        size_t radius_y,
+        ITaskScheduler* sche
+    );
+
+}  // namespace sung
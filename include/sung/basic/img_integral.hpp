@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sung/basic/aabb.hpp"
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    // Pixel regions are half open, [x_min, x_max) by [y_min, y_max), so
+    // width and height are the pixel counts
+    using PixelRegion = Aabb2D<int64_t>;
+
+
+    /*
+    Summed-area table of a TImageView2D. Each entry holds the sum of all
+    pixels above and to the left of it, so the sum over any rectangle is
+    four lookups.
+
+    `Acc` is int64_t or double. int64_t is exact for uint8_t and uint16_t
+    images, double is for float images or when a mean is all that's needed.
+    The table has a zero row and column in front so queries don't branch.
+    */
+    template <typename Acc>
+    class TSummedAreaTable {
+
+    public:
+        // Rows are summed in parallel, then columns in parallel bands. `T`
+        // can be uint8_t or uint16_t, and float if `Acc` is double.
+        template <typename T>
+        bool build(const TImageView2D<T>& src, ITaskScheduler* sche);
+
+        void clear();
+        bool empty() const;
+
+        size_t channels() const { return channels_; }
+        size_t width() const { return x_; }
+        size_t height() const { return y_; }
+
+        // Sum of the pixels [0, x) by [0, y)
+        Acc prefix(size_t x, size_t y, size_t channel) const {
+            return data_[(y * (x_ + 1) + x) * channels_ + channel];
+        }
+
+        // Regions are clipped to the image, empty ones sum to zero
+        Acc sum(const PixelRegion& region, size_t channel) const;
+        // `out` gets `channels()` values
+        void sum(Acc* out, const PixelRegion& region) const;
+        // Mean over the clipped region, zero if it's empty
+        double mean(const PixelRegion& region, size_t channel) const;
+
+        const std::vector<Acc>& data() const { return data_; }
+
+    private:
+        bool clip(const PixelRegion& region, size_t (&out)[4]) const;
+
+        std::vector<Acc> data_;
+        size_t channels_ = 0;
+        size_t x_ = 0;
+        size_t y_ = 0;
+    };
+
+    using SummedAreaTableI64 = TSummedAreaTable<int64_t>;
+    using SummedAreaTableF64 = TSummedAreaTable<double>;
+
+}  // namespace sung
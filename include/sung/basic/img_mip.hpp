@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+
+#include "sung/basic/img_resize.hpp"
+
+
+namespace sung {
+
+    /*
+    Mip chain of an image, with every level stored back to back in a single
+    allocation and without row padding. Level 0 is a copy of the source, and
+    each level is half the size of the previous one, rounded down, down to
+    1x1.
+
+    Levels are filtered from the previous level in linear float, so rounding
+    doesn't build up. With `srgb`, values are decoded from sRGB before
+    filtering and encoded back afterwards. The last channel of 2 and 4
+    channel images is alpha and is always linear.
+
+    `T` can be uint8_t, uint16_t or float. Integer values are normalized to
+    [0, 1] while filtering.
+    */
+    template <typename T>
+    class TMipChain2D {
+
+    public:
+        // `filter` would usually be box or kaiser
+        bool build(
+            const Image2D& src,
+            ResizeFilter filter,
+            bool srgb,
+            ITaskScheduler* sche
+        );
+        void clear();
+
+        bool empty() const { return levels_.empty(); }
+        size_t level_count() const { return levels_.size(); }
+        size_t channels() const { return channels_; }
+        const std::vector<T>& data() const { return data_; }
+        // Stays valid until the chain is rebuilt, cleared or destroyed
+        TImageView2D<T> level(size_t i) const;
+
+        /*
+        Level of detail for a pixel footprint, given the UV derivatives along
+        screen x and y. It is log2 of the longer side of the footprint in
+        level 0 texels.
+        */
+        double calc_lod(double dudx, double dvdx, double dudy, double dvdy)
+            const;
+
+        /*
+        Blends bilinear samples of the two levels around `lod`. `out` gets
+        `channels()` values as they are stored, not decoded from sRGB.
+        Addressing matches sample_bilinear_clamp.
+        */
+        void sample_trilinear(float* out, double u, double v, double lod)
+            const;
+
+        /*
+        Takes up to `max_aniso` trilinear samples along the longer axis of the
+        footprint, at the level of detail of its shorter axis.
+        */
+        void sample_aniso(
+            float* out,
+            double u,
+            double v,
+            double dudx,
+            double dvdx,
+            double dudy,
+            double dvdy,
+            size_t max_aniso
+        ) const;
+
+    private:
+        struct Level {
+            size_t offset_ = 0;
+            size_t x_ = 0;
+            size_t y_ = 0;
+        };
+
+        // These add `weight` times the sample to `out`
+        void accum_bilinear(
+            float* out, size_t level, double u, double v, float weight
+        ) const;
+        void accum_trilinear(
+            float* out, double u, double v, double lod, float weight
+        ) const;
+
+        std::vector<T> data_;
+        std::vector<Level> levels_;
+        size_t channels_ = 0;
+    };
+
+}  // namespace sung
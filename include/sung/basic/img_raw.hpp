@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+
+#include "sung/basic/img.hpp"
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/img_convert.hpp"
+#include "sung/basic/mapped_file.hpp"
+
+
+namespace sung {
+
+    /*
+    Raw image files are a 64 byte little-endian header followed by tightly
+    packed pixels, x fastest then y then z. The payload starts at a 64 byte
+    offset so views over a page aligned mapping are SIMD aligned.
+
+    Scalars are stored in native byte order, since the views point straight
+    into the file.
+    */
+
+    bool write_raw_image(
+        const std::string& path,
+        const byte8* data,
+        PixelScalar scalar,
+        size_t channels,
+        size_t x,
+        size_t y,
+        size_t z = 1
+    );
+
+    // Row padding is skipped
+    bool write_raw_image(
+        const std::string& path, const Image2D& img, PixelScalar scalar
+    );
+
+    template <typename T>
+    bool write_raw_image(
+        const std::string& path, const TImage3D<T>& img, PixelScalar scalar
+    ) {
+        if (get_scalar_bytes(scalar) != sizeof(T))
+            return false;
+        return write_raw_image(
+            path,
+            img.buffer_data(),
+            scalar,
+            img.channels(),
+            img.width(),
+            img.height(),
+            img.depth()
+        );
+    }
+
+
+    /*
+    Opens a raw image file with a read-only memory map, so nothing is read
+    until pixels are touched. Views returned by `make_view` are valid until
+    the MappedImage is closed or destroyed.
+    */
+    class MappedImage {
+
+    public:
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const;
+
+        PixelScalar scalar() const { return scalar_; }
+        size_t channels() const { return channels_; }
+        size_t width() const { return x_; }
+        size_t height() const { return y_; }
+        size_t depth() const { return z_; }
+
+        const byte8* data() const;
+        size_t size_bytes() const;
+
+        // Fails if the scalar size doesn't match `T` or depth is not 1
+        template <typename T>
+        bool make_view(TImageView2D<T>& out) const {
+            if (!this->check_view(sizeof(T)) || 1 != z_)
+                return false;
+            const auto ptr = reinterpret_cast<const T*>(this->data());
+            out.set(ptr, channels_, x_, y_);
+            return true;
+        }
+
+        // Fails if the scalar size doesn't match `T`
+        template <typename T>
+        bool make_view(TImageView3D<T>& out) const {
+            if (!this->check_view(sizeof(T)))
+                return false;
+            const auto ptr = reinterpret_cast<const T*>(this->data());
+            out.set(ptr, channels_, x_, y_, z_);
+            return true;
+        }
+
+        // Applies to the pixels only
+        void advise(AccessHint hint) const;
+        // Starts reading z slices [begin, end) in, or rows if depth is 1
+        void prefetch_slices(size_t begin, size_t end) const;
+
+    private:
+        bool check_view(size_t scalar_bytes) const;
+        size_t slice_bytes() const;
+
+        MappedFile file_;
+        PixelScalar scalar_ = PixelScalar::unorm8;
+        size_t channels_ = 0;
+        size_t x_ = 0;
+        size_t y_ = 0;
+        size_t z_ = 0;
+    };
+
+}  // namespace sung
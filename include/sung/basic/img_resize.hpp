@@ -0,0 +1,61 @@
+#pragma once
+
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    enum class ResizeFilter {
+        box,
+        // Tent filter, same as bilinear when magnifying
+        bilinear,
+        // Catmull-Rom
+        bicubic,
+        // Lanczos with 3 lobes
+        lanczos,
+        // Kaiser windowed sinc with 3 lobes, alpha 4. Softer than Lanczos,
+        // it is a good choice for mipmaps.
+        kaiser,
+    };
+
+
+    /*
+    Resizes `src` into `dst` with separable passes: every source row is
+    filtered horizontally into a float buffer, then the columns of that buffer
+    are filtered vertically into `dst`. Filters are widened when minifying so
+    they don't alias. Edges are clamped.
+
+    Rows are processed in bands on the task scheduler if one is given. Row
+    padding of both images is respected.
+
+    `T` is the scalar type of the images. It can be uint8_t, uint16_t or
+    float. Integer results are rounded and clamped to their range.
+    */
+
+    // `dst` must already have its metadata set and data allocated, with the
+    // same channel count and scalar type as `src`.
+    template <typename T>
+    bool resize_image(
+        Image2D& dst,
+        const Image2D& src,
+        ResizeFilter filter,
+        ITaskScheduler* sche
+    );
+
+    // Sets `dst` to be `x` by `y` without row padding
+    template <typename T>
+    bool resize_image(
+        Image2D& dst,
+        const Image2D& src,
+        size_t x,
+        size_t y,
+        ResizeFilter filter,
+        ITaskScheduler* sche
+    ) {
+        dst.set_metadata<T>(src.channels(), x, y);
+        dst.resize_data_to_fit();
+        return resize_image<T>(dst, src, filter, sche);
+    }
+
+}  // namespace sung
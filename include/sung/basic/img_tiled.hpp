@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "sung/basic/img.hpp"
+#include "sung/basic/img2d.hpp"
+
+
+namespace sung {
+
+    /*
+    Image2D stored in 8x8 pixel tiles. Tiles are in row-major order and so
+    are the pixels within a tile, so a 2D neighborhood mostly falls in one or
+    two tiles instead of spanning many rows. It has the same metadata and
+    `pixel_ptr` semantics as Image2D, except that there is no row padding.
+    Partial tiles at the right and bottom edges are allocated in full.
+    */
+    class TiledImage2D : public ImageMetadata2D {
+
+    public:
+        static constexpr size_t TILE_SIZE = 8;
+
+        void clear();
+        // Row padding of the metadata is ignored
+        void resize_data_to_fit();
+
+        byte8* pixel_ptr(size_t x, size_t y);
+        const byte8* pixel_ptr(size_t x, size_t y) const;
+
+        template <typename T>
+        T* pixel_ptr(size_t x, size_t y) {
+            return reinterpret_cast<T*>(this->pixel_ptr(x, y));
+        }
+
+        template <typename T>
+        const T* pixel_ptr(size_t x, size_t y) const {
+            return reinterpret_cast<const T*>(this->pixel_ptr(x, y));
+        }
+
+        size_t tile_count_x() const;
+        size_t tile_count_y() const;
+        size_t tile_bytes() const;
+        size_t tiled_size_bytes() const;
+
+        // These hide the row-major versions of ImageMetadata2D, which still
+        // answer for the metadata alone when called through the base class
+        size_t padding_bytes() const;
+        // Same as `tiled_size_bytes`, partial edge tiles count in full
+        size_t size_bytes() const;
+
+        // Takes the metadata of `src` except the row padding
+        void copy_from(const Image2D& src);
+        // `dst` gets the same metadata without row padding
+        void copy_to(Image2D& dst) const;
+
+    public:
+        std::vector<byte8> data_;
+
+    private:
+        size_t make_tiled_idx(size_t x, size_t y) const;
+    };
+
+
+    /*
+    TImage3D stored in 4x4x4 texel bricks, for access patterns that move
+    along all three axes like trilinear sampling or slicing along x or y.
+    `texel_ptr` clamps coordinates like TImage3D does.
+    */
+    template <typename DataType>
+    class TTiledImage3D : public ImageMetadata3D {
+
+    public:
+        static constexpr size_t BRICK_SIZE = 4;
+
+        bool alloc(size_t channels, size_t x, size_t y = 1, size_t z = 1) {
+            this->set_size(channels, x, y, z);
+            bricks_x_ = (x + BRICK_SIZE - 1) / BRICK_SIZE;
+            bricks_y_ = (y + BRICK_SIZE - 1) / BRICK_SIZE;
+            const auto bricks_z = (z + BRICK_SIZE - 1) / BRICK_SIZE;
+            const auto brick_texels = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+            data_.resize(
+                bricks_x_ * bricks_y_ * bricks_z * brick_texels * channels
+            );
+            return true;
+        }
+
+        void clear() {
+            data_.clear();
+            bricks_x_ = 0;
+            bricks_y_ = 0;
+            this->ImageMetadata3D::clear();
+        }
+
+        size_t value_type_size() const { return sizeof(DataType); }
+
+        DataType* texel_ptr(size_t x, size_t y = 0, size_t z = 0) {
+            return data_.data() + this->make_brick_idx_clamp(x, y, z);
+        }
+
+        const DataType* texel_ptr(size_t x, size_t y = 0, size_t z = 0) const {
+            return data_.data() + this->make_brick_idx_clamp(x, y, z);
+        }
+
+        void copy_from(const TImage3D<DataType>& src) {
+            this->alloc(src.channels(), src.width(), src.height(), src.depth());
+            this->copy_runs([&](size_t x, size_t y, size_t z, size_t len) {
+                const auto from = src.texel_ptr(x, y, z);
+                std::copy(from, from + len, this->texel_ptr(x, y, z));
+            });
+        }
+
+        void copy_to(TImage3D<DataType>& dst) const {
+            dst.alloc(
+                this->channels(), this->width(), this->height(), this->depth()
+            );
+            this->copy_runs([&](size_t x, size_t y, size_t z, size_t len) {
+                const auto from = this->texel_ptr(x, y, z);
+                std::copy(from, from + len, dst.texel_ptr(x, y, z));
+            });
+        }
+
+        std::vector<DataType> data_;
+
+    private:
+        size_t make_brick_idx_clamp(size_t x, size_t y, size_t z) const {
+            constexpr size_t MASK = BRICK_SIZE - 1;
+            x = (std::min)(x, this->width() - 1);
+            y = (std::min)(y, this->height() - 1);
+            z = (std::min)(z, this->depth() - 1);
+
+            const auto bx = x / BRICK_SIZE;
+            const auto by = y / BRICK_SIZE;
+            const auto bz = z / BRICK_SIZE;
+            const auto brick = (bz * bricks_y_ + by) * bricks_x_ + bx;
+
+            const auto ix = x & MASK;
+            const auto iy = y & MASK;
+            const auto iz = z & MASK;
+            const auto inner = (iz * BRICK_SIZE + iy) * BRICK_SIZE + ix;
+
+            const auto brick_texels = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+            return (brick * brick_texels + inner) * this->channels();
+        }
+
+        // Calls `func` for every run of texels that is contiguous in both
+        // layouts, which is a row segment within a brick
+        template <typename Func>
+        void copy_runs(Func&& func) const {
+            const auto ch = this->channels();
+            for (size_t z = 0; z < this->depth(); ++z) {
+                for (size_t y = 0; y < this->height(); ++y) {
+                    for (size_t x = 0; x < this->width(); x += BRICK_SIZE) {
+                        const auto len = (std::min)(
+                            BRICK_SIZE, this->width() - x
+                        );
+                        func(x, y, z, len * ch);
+                    }
+                }
+            }
+        }
+
+        size_t bricks_x_ = 0;
+        size_t bricks_y_ = 0;
+    };
+
+    template <typename DataType>
+    constexpr size_t TTiledImage3D<DataType>::BRICK_SIZE;
+
+}  // namespace sung
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "sung/basic/linalg.hpp"
+#include "sung/basic/optional.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    /*
+    Static k-d tree over 3D points. The tree is laid out implicitly: the node
+    of the range [lo, hi) is the element at lo + (hi - lo) / 2, its left child
+    is the range below it and the right child the range above. Each node keeps
+    the axis it splits on, so no pointers or extra node arrays are needed.
+    */
+    template <typename T>
+    class KdTree3 {
+
+    public:
+        using Vec3 = TVec3<T>;
+
+        struct Neighbor {
+            // Index to the array given to `build`
+            uint32_t idx_ = 0;
+            T dist_sqr_ = 0;
+        };
+
+        void build(const Vec3* points, size_t count, ITaskScheduler* sche) {
+            items_.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                items_[i].pos_ = points[i];
+                items_[i].idx_ = static_cast<uint32_t>(i);
+                items_[i].axis_ = 0;
+            }
+
+            // Split the top levels here, then build the subtrees in parallel
+            std::vector<Range> ranges{ Range{ 0, count } };
+            std::vector<Range> next;
+            while (sche && ranges.size() < 64) {
+                next.clear();
+                for (auto& r : ranges) {
+                    if (r.hi_ - r.lo_ < 4096) {
+                        next.push_back(r);
+                        continue;
+                    }
+                    const auto mid = this->split(r.lo_, r.hi_);
+                    next.push_back(Range{ r.lo_, mid });
+                    next.push_back(Range{ mid + 1, r.hi_ });
+                }
+                if (next.size() == ranges.size())
+                    break;
+                ranges.swap(next);
+            }
+
+            parallel_for(
+                ranges.size(),
+                1,
+                [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                        this->build_rec(ranges[i].lo_, ranges[i].hi_);
+                },
+                sche
+            );
+        }
+
+        void build(const Vec3* points, size_t count) {
+            this->build(points, count, nullptr);
+        }
+
+        void build(const std::vector<Vec3>& points, ITaskScheduler* sche) {
+            this->build(points.data(), points.size(), sche);
+        }
+
+        void build(const std::vector<Vec3>& points) {
+            this->build(points.data(), points.size(), nullptr);
+        }
+
+        void clear() { items_.clear(); }
+        bool empty() const { return items_.empty(); }
+        size_t size() const { return items_.size(); }
+
+        Optional<Neighbor> find_nearest(const Vec3& query) const {
+            if (items_.empty())
+                return sung::nullopt;
+
+            Neighbor best;
+            best.dist_sqr_ = std::numeric_limits<T>::max();
+            this->nearest_rec(best, query, 0, items_.size());
+            return best;
+        }
+
+        // Sorted from the closest
+        void find_knn(std::vector<Neighbor>& out, const Vec3& query, size_t k)
+            const {
+            out.clear();
+            if (0 == k || items_.empty())
+                return;
+
+            out.reserve(k);
+            this->knn_rec(out, query, k, 0, items_.size());
+            std::sort_heap(out.begin(), out.end(), &KdTree3::is_closer);
+        }
+
+        // Not sorted
+        void find_in_radius(
+            std::vector<Neighbor>& out, const Vec3& query, T radius
+        ) const {
+            out.clear();
+            this->radius_rec(out, query, radius * radius, 0, items_.size());
+        }
+
+    private:
+        struct Item {
+            Vec3 pos_;
+            uint32_t idx_;
+            uint8_t axis_;
+        };
+
+        struct Range {
+            size_t lo_;
+            size_t hi_;
+        };
+
+        static bool is_closer(const Neighbor& a, const Neighbor& b) {
+            return a.dist_sqr_ < b.dist_sqr_;
+        }
+
+        // Places the median of [lo, hi) and returns its index
+        size_t split(size_t lo, size_t hi) {
+            Vec3 mini = items_[lo].pos_;
+            Vec3 maxi = items_[lo].pos_;
+            for (size_t i = lo + 1; i < hi; ++i) {
+                for (size_t a = 0; a < 3; ++a) {
+                    mini[a] = (std::min)(mini[a], items_[i].pos_[a]);
+                    maxi[a] = (std::max)(maxi[a], items_[i].pos_[a]);
+                }
+            }
+
+            const auto extent = maxi - mini;
+            uint8_t axis = 0;
+            if (extent[1] > extent[axis])
+                axis = 1;
+            if (extent[2] > extent[axis])
+                axis = 2;
+
+            const auto mid = lo + (hi - lo) / 2;
+            std::nth_element(
+                items_.begin() + lo,
+                items_.begin() + mid,
+                items_.begin() + hi,
+                [axis](const Item& a, const Item& b) {
+                    return a.pos_[axis] < b.pos_[axis];
+                }
+            );
+            items_[mid].axis_ = axis;
+            return mid;
+        }
+
+        void build_rec(size_t lo, size_t hi) {
+            if (hi - lo <= 1)
+                return;
+
+            const auto mid = this->split(lo, hi);
+            this->build_rec(lo, mid);
+            this->build_rec(mid + 1, hi);
+        }
+
+        void nearest_rec(Neighbor& best, const Vec3& q, size_t lo, size_t hi)
+            const {
+            if (lo >= hi)
+                return;
+
+            const auto mid = lo + (hi - lo) / 2;
+            const auto& item = items_[mid];
+            const auto dist_sqr = item.pos_.distance_sqr(q);
+            if (dist_sqr < best.dist_sqr_) {
+                best.dist_sqr_ = dist_sqr;
+                best.idx_ = item.idx_;
+            }
+            if (hi - lo == 1)
+                return;
+
+            const auto diff = q[item.axis_] - item.pos_[item.axis_];
+            if (diff < 0) {
+                this->nearest_rec(best, q, lo, mid);
+                if (diff * diff < best.dist_sqr_)
+                    this->nearest_rec(best, q, mid + 1, hi);
+            } else {
+                this->nearest_rec(best, q, mid + 1, hi);
+                if (diff * diff < best.dist_sqr_)
+                    this->nearest_rec(best, q, lo, mid);
+            }
+        }
+
+        // `heap` is a max-heap of at most k elements
+        void knn_rec(
+            std::vector<Neighbor>& heap,
+            const Vec3& q,
+            size_t k,
+            size_t lo,
+            size_t hi
+        ) const {
+            if (lo >= hi)
+                return;
+
+            const auto mid = lo + (hi - lo) / 2;
+            const auto& item = items_[mid];
+            const auto dist_sqr = item.pos_.distance_sqr(q);
+            if (heap.size() < k) {
+                heap.push_back(Neighbor{ item.idx_, dist_sqr });
+                std::push_heap(heap.begin(), heap.end(), &KdTree3::is_closer);
+            } else if (dist_sqr < heap.front().dist_sqr_) {
+                std::pop_heap(heap.begin(), heap.end(), &KdTree3::is_closer);
+                heap.back() = Neighbor{ item.idx_, dist_sqr };
+                std::push_heap(heap.begin(), heap.end(), &KdTree3::is_closer);
+            }
+            if (hi - lo == 1)
+                return;
+
+            const auto diff = q[item.axis_] - item.pos_[item.axis_];
+            const auto near_lo = diff < 0 ? lo : mid + 1;
+            const auto near_hi = diff < 0 ? mid : hi;
+            const auto far_lo = diff < 0 ? mid + 1 : lo;
+            const auto far_hi = diff < 0 ? hi : mid;
+
+            this->knn_rec(heap, q, k, near_lo, near_hi);
+            if (heap.size() < k || diff * diff < heap.front().dist_sqr_)
+                this->knn_rec(heap, q, k, far_lo, far_hi);
+        }
+
+        void radius_rec(
+            std::vector<Neighbor>& out,
+            const Vec3& q,
+            T radius_sqr,
+            size_t lo,
+            size_t hi
+        ) const {
+            if (lo >= hi)
+                return;
+
+            const auto mid = lo + (hi - lo) / 2;
+            const auto& item = items_[mid];
+            const auto dist_sqr = item.pos_.distance_sqr(q);
+            if (dist_sqr <= radius_sqr)
+                out.push_back(Neighbor{ item.idx_, dist_sqr });
+            if (hi - lo == 1)
+                return;
+
+            const auto diff = q[item.axis_] - item.pos_[item.axis_];
+            if (diff <= 0 || diff * diff <= radius_sqr)
+                this->radius_rec(out, q, radius_sqr, lo, mid);
+            if (diff >= 0 || diff * diff <= radius_sqr)
+                this->radius_rec(out, q, radius_sqr, mid + 1, hi);
+        }
+
+        std::vector<Item> items_;
+    };
+
+}  // namespace sung
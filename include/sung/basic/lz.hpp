@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+#include "sung/basic/bytes.hpp"
+
+
+namespace sung {
+
+    /*
+    Small LZ77 block codec in the style of LZ4. A block is a run of
+    sequences, each a token byte (literal length in the high nibble, match
+    length minus 4 in the low one, 15 meaning more length bytes follow),
+    the literals, then a 2 byte little endian match offset. The last
+    sequence has literals only.
+
+    Blocks don't carry their decoded size, the caller keeps it.
+    */
+
+    // Worst case compressed size for `size` input bytes
+    size_t lz_compress_bound(size_t size);
+
+    // Returns the compressed size, or 0 if it didn't fit in `dst_capacity`
+    size_t lz_compress(
+        byte8* dst, size_t dst_capacity, const byte8* src, size_t src_size
+    );
+
+    // Fails on malformed input, or if the block doesn't decode to exactly
+    // `dst_size` bytes. Never reads or writes out of bounds.
+    bool lz_decompress(
+        byte8* dst, size_t dst_size, const byte8* src, size_t src_size
+    );
+
+
+    // Groups byte 0 of every element, then byte 1, and so on. Numeric arrays
+    // compress much better this way, as high bytes tend to repeat.
+    void shuffle_bytes(
+        byte8* dst, const byte8* src, size_t count, size_t type_size
+    );
+    void unshuffle_bytes(
+        byte8* dst, const byte8* src, size_t count, size_t type_size
+    );
+
+}  // namespace sung
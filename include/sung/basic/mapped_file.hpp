@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "sung/basic/bytes.hpp"
+#include "sung/basic/os_detect.hpp"
+
+
+namespace sung {
+
+    enum class AccessHint {
+        normal,
+        // Aggressive read-ahead, pages behind may be dropped early
+        sequential,
+        // No read-ahead
+        random,
+        // Start reading the pages in now
+        willneed,
+    };
+
+
+    /*
+    Read-only memory map of a whole file, on POSIX with mmap and on Windows
+    with file mapping objects. The mapping stays valid until `close` or the
+    destructor. Empty files open with a null `data()`.
+    */
+    class MappedFile {
+
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool open(const std::string& path);
+        void close();
+
+        bool is_open() const;
+        const byte8* data() const { return data_; }
+        size_t size() const { return size_; }
+
+        // Hints for the OS, ignored where they are not supported. Ranges
+        // are widened to page boundaries and clipped to the file.
+        void advise(AccessHint hint) const;
+        void advise(AccessHint hint, size_t offset, size_t size) const;
+
+    private:
+        const byte8* data_ = nullptr;
+        size_t size_ = 0;
+        bool open_ = false;
+#ifdef SUNG_OS_WINDOWS
+        void* file_ = nullptr;
+        void* mapping_ = nullptr;
+#endif
+    };
+
+
+    /*
+    Read-write memory map of a new zero filled file, used as scratch space
+    for data larger than RAM. Pages are written back by the OS as it needs
+    the memory. The file is removed as soon as it's mapped on POSIX, and
+    when it's closed on Windows, so it never outlives the process.
+    */
+    class MappedScratchFile {
+
+    public:
+        MappedScratchFile() = default;
+        ~MappedScratchFile();
+
+        MappedScratchFile(const MappedScratchFile&) = delete;
+        MappedScratchFile& operator=(const MappedScratchFile&) = delete;
+        MappedScratchFile(MappedScratchFile&& other) noexcept;
+        MappedScratchFile& operator=(MappedScratchFile&& other) noexcept;
+
+        // Fails if a file already exists at `path`, it's never touched
+        bool create(const std::string& path, size_t size);
+        void close();
+
+        bool is_open() const;
+        byte8* data() const { return data_; }
+        size_t size() const { return size_; }
+
+        // Hints for the OS, ignored where they are not supported. Ranges
+        // are widened to page boundaries and clipped to the file.
+        void advise(AccessHint hint) const;
+        void advise(AccessHint hint, size_t offset, size_t size) const;
+
+    private:
+        byte8* data_ = nullptr;
+        size_t size_ = 0;
+        bool open_ = false;
+#ifdef SUNG_OS_WINDOWS
+        void* file_ = nullptr;
+        void* mapping_ = nullptr;
+#endif
+    };
+
+}  // namespace sung
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+    #include <immintrin.h>
+    #define SUNG_MORTON_BMI2
+#endif
+
+
+namespace sung {
+
+    // Spreads the lower 32 bits of `x` so there is a zero bit between each
+    constexpr uint64_t morton_spread_2d(uint64_t x) {
+        x &= 0xffffffff;
+        x = (x | (x << 16)) & 0x0000ffff0000ffff;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ff;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0f;
+        x = (x | (x << 2)) & 0x3333333333333333;
+        x = (x | (x << 1)) & 0x5555555555555555;
+        return x;
+    }
+
+    // Inverse of morton_spread_2d
+    constexpr uint32_t morton_compact_2d(uint64_t x) {
+        x &= 0x5555555555555555;
+        x = (x ^ (x >> 1)) & 0x3333333333333333;
+        x = (x ^ (x >> 2)) & 0x0f0f0f0f0f0f0f0f;
+        x = (x ^ (x >> 4)) & 0x00ff00ff00ff00ff;
+        x = (x ^ (x >> 8)) & 0x0000ffff0000ffff;
+        x = (x ^ (x >> 16)) & 0x00000000ffffffff;
+        return static_cast<uint32_t>(x);
+    }
+
+    constexpr uint64_t morton_encode_2d(uint32_t x, uint32_t y) {
+        return morton_spread_2d(x) | (morton_spread_2d(y) << 1);
+    }
+
+    constexpr uint32_t morton_decode_2d_x(uint64_t code) {
+        return morton_compact_2d(code);
+    }
+    constexpr uint32_t morton_decode_2d_y(uint64_t code) {
+        return morton_compact_2d(code >> 1);
+    }
+
+    // Spreads the lower 21 bits of `x` so there are 2 zero bits between each
+    constexpr uint64_t morton_spread_3d(uint64_t x) {
+        x &= 0x1fffff;
+        x = (x | (x << 32)) & 0x1f00000000ffff;
+        x = (x | (x << 16)) & 0x1f0000ff0000ff;
+        x = (x | (x << 8)) & 0x100f00f00f00f00f;
+        x = (x | (x << 4)) & 0x10c30c30c30c30c3;
+        x = (x | (x << 2)) & 0x1249249249249249;
+        return x;
+    }
+
+    // Inverse of morton_spread_3d
+    constexpr uint32_t morton_compact_3d(uint64_t x) {
+        x &= 0x1249249249249249;
+        x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3;
+        x = (x ^ (x >> 4)) & 0x100f00f00f00f00f;
+        x = (x ^ (x >> 8)) & 0x1f0000ff0000ff;
+        x = (x ^ (x >> 16)) & 0x1f00000000ffff;
+        x = (x ^ (x >> 32)) & 0x1fffff;
+        return static_cast<uint32_t>(x);
+    }
+
+    // Each coordinate can use up to 21 bits
+    constexpr uint64_t morton_encode_3d(uint32_t x, uint32_t y, uint32_t z) {
+        return morton_spread_3d(x) | (morton_spread_3d(y) << 1) |
+               (morton_spread_3d(z) << 2);
+    }
+
+    constexpr uint32_t morton_decode_3d_x(uint64_t code) {
+        return morton_compact_3d(code);
+    }
+    constexpr uint32_t morton_decode_3d_y(uint64_t code) {
+        return morton_compact_3d(code >> 1);
+    }
+    constexpr uint32_t morton_decode_3d_z(uint64_t code) {
+        return morton_compact_3d(code >> 2);
+    }
+
+
+    /*
+    Same results as the functions above. They use BMI2 pdep/pext if the
+    compiler targets it (e.g. -mbmi2 or /arch:AVX2), which is faster on Intel
+    and AMD Zen 3 or later. Other CPUs get the portable bit tricks.
+    */
+
+    inline uint64_t morton_encode_2d_fast(uint32_t x, uint32_t y) {
+#ifdef SUNG_MORTON_BMI2
+        return _pdep_u64(x, 0x5555555555555555) |
+               _pdep_u64(y, 0xaaaaaaaaaaaaaaaa);
+#else
+        return morton_encode_2d(x, y);
+#endif
+    }
+
+    inline void morton_decode_2d_fast(
+        uint64_t code, uint32_t& x, uint32_t& y
+    ) {
+#ifdef SUNG_MORTON_BMI2
+        x = static_cast<uint32_t>(_pext_u64(code, 0x5555555555555555));
+        y = static_cast<uint32_t>(_pext_u64(code, 0xaaaaaaaaaaaaaaaa));
+#else
+        x = morton_decode_2d_x(code);
+        y = morton_decode_2d_y(code);
+#endif
+    }
+
+    inline uint64_t morton_encode_3d_fast(uint32_t x, uint32_t y, uint32_t z) {
+#ifdef SUNG_MORTON_BMI2
+        return _pdep_u64(x, 0x1249249249249249) |
+               _pdep_u64(y, 0x2492492492492492) |
+               _pdep_u64(z, 0x4924924924924924);
+#else
+        return morton_encode_3d(x, y, z);
+#endif
+    }
+
+    inline void morton_decode_3d_fast(
+        uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z
+    ) {
+#ifdef SUNG_MORTON_BMI2
+        x = static_cast<uint32_t>(_pext_u64(code, 0x1249249249249249));
+        y = static_cast<uint32_t>(_pext_u64(code, 0x2492492492492492));
+        z = static_cast<uint32_t>(_pext_u64(code, 0x4924924924924924));
+#else
+        x = morton_decode_3d_x(code);
+        y = morton_decode_3d_y(code);
+        z = morton_decode_3d_z(code);
+#endif
+    }
+
+
+    // `bits` per coordinate, up to 32
+    constexpr uint64_t hilbert_encode_2d(
+        uint32_t x, uint32_t y, uint32_t bits
+    ) {
+        uint64_t d = 0;
+        for (uint32_t i = bits; i-- > 0;) {
+            const uint32_t s = uint32_t{ 1 } << i;
+            const uint32_t rx = (x & s) ? 1 : 0;
+            const uint32_t ry = (y & s) ? 1 : 0;
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+            // Rotate the quadrant
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = s - 1 - (x & (s - 1));
+                    y = s - 1 - (y & (s - 1));
+                }
+                const auto t = x;
+                x = y;
+                y = t;
+            }
+        }
+        return d;
+    }
+
+    inline void hilbert_decode_2d(
+        uint64_t d, uint32_t bits, uint32_t& x, uint32_t& y
+    ) {
+        x = 0;
+        y = 0;
+        for (uint32_t i = 0; i < bits; ++i) {
+            const uint32_t s = uint32_t{ 1 } << i;
+            const uint32_t rx = 1 & static_cast<uint32_t>(d >> 1);
+            const uint32_t ry = 1 & static_cast<uint32_t>(d ^ rx);
+
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+                const auto t = x;
+                x = y;
+                y = t;
+            }
+
+            x += s * rx;
+            y += s * ry;
+            d >>= 2;
+        }
+    }
+
+    /*
+    `bits` per coordinate, up to 21. Based on John Skilling, "Programming the
+    Hilbert curve", 2004. The transposed form is interleaved with x as the most
+    significant axis.
+    */
+    uint64_t hilbert_encode_3d(
+        uint32_t x, uint32_t y, uint32_t z, uint32_t bits
+    );
+    void hilbert_decode_3d(
+        uint64_t code, uint32_t bits, uint32_t& x, uint32_t& y, uint32_t& z
+    );
+
+}  // namespace sung
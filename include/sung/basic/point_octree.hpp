@@ -0,0 +1,173 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sung/basic/aabb.hpp"
+#include "sung/basic/mapped_file.hpp"
+#include "sung/basic/morton.hpp"
+
+
+namespace sung {
+
+    /*
+    Sparse linear octree over points. Points are stored sorted by their Morton
+    code within the root box, so every octree node is a contiguous range in
+    each sorted run and no node objects are stored at all. Nodes at level `l`
+    are identified by the top `3 * l` bits of the 63-bit codes.
+
+    Points added with `insert` are buffered, and `flush` sorts the buffer
+    into a new run. Runs are merged like a log-structured merge tree: only
+    while the older run is no bigger than the newer one. That keeps
+    O(log n) runs and merges each point O(log n) times, however small the
+    batches are. Queries look at every run, and `compact` merges them into
+    one.
+
+    With `set_scratch_path`, every run lives in a memory mapped scratch file
+    instead of RAM, so point clouds larger than memory can be streamed in.
+    Only the insert buffer and a sparse index of every run are kept in RAM,
+    and the OS pages in what queries touch.
+    */
+    class PointOctree {
+
+    public:
+        using Vec3 = TVec3<double>;
+        using Aabb3 = Aabb3D<double>;
+
+        static constexpr uint32_t MAX_LEVEL = 21;
+
+        struct Node {
+            Aabb3 aabb_;
+            // Points in the node over all runs
+            size_t count_ = 0;
+            uint64_t code_ = 0;
+            uint32_t level_ = 0;
+        };
+
+        struct Record {
+            uint64_t code_;
+            Vec3 point_;
+        };
+
+        // Returns true to descend into the children of the node
+        using RefineFunc = std::function<bool(const Node&)>;
+
+        // Points outside of `aabb` are clamped onto its boundary
+        bool build(const Vec3* points, size_t count, const Aabb3& aabb);
+        // Bounds are computed from the points
+        bool build(const Vec3* points, size_t count);
+        // Clears and sets the root box, for when it's filled by `insert` only
+        void reset(const Aabb3& aabb);
+
+        // Runs made after this go to files named `path_prefix` followed by a
+        // serial number. Empty keeps them in memory, which is the default.
+        // Flushes fail rather than touch a file that already has the name.
+        void set_scratch_path(const std::string& path_prefix);
+        // `insert` flushes by itself once this many points are buffered.
+        // 0, the default, only flushes on `flush`.
+        void set_buffer_size(size_t count);
+
+        // False if an automatic flush failed, the points stay buffered
+        bool insert(const Vec3* points, size_t count);
+        bool insert(const Vec3& point) { return this->insert(&point, 1); }
+        // Sorts the points buffered by `insert` into a run, then merges runs.
+        // False if a scratch file couldn't be made, nothing is lost then.
+        bool flush();
+        // Merges all runs into one, which makes queries cheaper
+        bool compact();
+
+        void clear();
+
+        // Points in runs, not counting the buffered ones
+        size_t size() const;
+        size_t pending_size() const;
+        size_t run_count() const;
+        const Aabb3& aabb() const;
+
+        Node root() const;
+        Node make_node(uint64_t code, uint32_t level) const;
+        // Empty children are skipped
+        void get_children(std::vector<Node>& out, const Node& node) const;
+        // All points of the node in Morton order. Points with the same code
+        // come in insertion order.
+        void get_points(std::vector<Vec3>& out, const Node& node) const;
+
+        /*
+        Selects a cut of the tree for level of detail. Starting from the root,
+        a node is refined while `refine` says so and it has children. The
+        chosen nodes are disjoint, in Morton order, and together cover every
+        point.
+        */
+        void select_lod(
+            std::vector<Node>& out, const RefineFunc& refine, size_t leaf_size
+        ) const;
+        // Refines nodes whose box looks bigger than `threshold` from `eye`.
+        // The size is measured as the box diagonal divided by the distance.
+        void select_lod(
+            std::vector<Node>& out,
+            const Vec3& eye,
+            double threshold,
+            size_t leaf_size
+        ) const;
+
+        // Picks up to `max_count` points spread evenly across the node. Each
+        // run is in Morton order, so it is a spatially even subsample.
+        void sample_node(
+            std::vector<Vec3>& out, const Node& node, size_t max_count
+        ) const;
+
+    private:
+        /*
+        Records sorted by code, in memory or in a scratch file. Every
+        `FENCE_STRIDE`th code is copied to `fences_` so a search only
+        touches a page or two of the records.
+        */
+        class Run {
+
+        public:
+            static constexpr size_t FENCE_STRIDE = 512;
+
+            Run() = default;
+            // Copies always hold their records in memory
+            Run(const Run& other);
+            Run& operator=(const Run& other);
+            Run(Run&&) = default;
+            Run& operator=(Run&&) = default;
+
+            // Empty `path` allocates in memory
+            bool alloc(size_t count, const std::string& path);
+            // Call once the records are written
+            void make_fences();
+
+            size_t size() const { return size_; }
+            Record* data();
+            const Record* data() const;
+            size_t lower_bound(uint64_t code) const;
+            void advise(AccessHint hint) const;
+
+        private:
+            std::vector<Record> memory_;
+            MappedScratchFile scratch_;
+            std::vector<uint64_t> fences_;
+            size_t size_ = 0;
+        };
+
+        uint64_t calc_code(const Vec3& p) const;
+        void set_aabb(const Aabb3& aabb);
+        bool add_run(std::vector<Record>& sorted);
+        // Merges `runs_[first]` and all after it into one run
+        bool merge_runs(size_t first);
+        std::string make_scratch_path() const;
+
+        std::vector<Run> runs_;
+        std::vector<Record> pending_;
+        std::string scratch_prefix_;
+        size_t buffer_size_ = 0;
+        size_t size_ = 0;
+
+        Aabb3 aabb_;
+        Vec3 scale_;
+    };
+
+}  // namespace sung
@@ -3,6 +3,7 @@
 #include <array>
 
 #include "sung/basic/img2d.hpp"
+#include "sung/basic/linalg.hpp"
 #include "sung/basic/mamath.hpp"
 
 
@@ -74,4 +75,62 @@ namespace sung {
         return lerp_arr<T, Channels>(p0, p1, y_frac);
     }
 
+
+    /*
+    Batched versions of sample_bilinear_clamp with the same texel addressing.
+    `out` gets `view.channels()` values per sample.
+
+    uint8 images are blended with 8 bit fixed-point weights, as texture units
+    do, and uint16 images in float. Results are rounded rather than
+    truncated, so they can be off by one or two from the scalar path, which
+    truncates after each lerp. 4 channel uint8 and float images use SSE2 if
+    the compiler targets it.
+    */
+
+    void sample_bilinear_clamp_batch(
+        uint8_t* out,
+        const TImageView2D<uint8_t>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    );
+    void sample_bilinear_clamp_batch(
+        uint16_t* out,
+        const TImageView2D<uint16_t>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    );
+    void sample_bilinear_clamp_batch(
+        float* out,
+        const TImageView2D<float>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    );
+
+    // Samples at `(u0 + i * du, v)` for i in [0, count). The vertical taps
+    // and weights are computed once for the whole row.
+    void sample_bilinear_clamp_row(
+        uint8_t* out,
+        const TImageView2D<uint8_t>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    );
+    void sample_bilinear_clamp_row(
+        uint16_t* out,
+        const TImageView2D<uint16_t>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    );
+    void sample_bilinear_clamp_row(
+        float* out,
+        const TImageView2D<float>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    );
+
 }  // namespace sung
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "sung/basic/aabb.hpp"
+#include "sung/basic/mesh_builder.hpp"
+#include "sung/basic/morton.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    enum class SpaceCurve { morton, hilbert };
+
+
+    // Cell coordinates can use up to 21 bits
+    uint64_t calc_curve_code(
+        uint32_t x, uint32_t y, uint32_t z, SpaceCurve curve
+    );
+
+    /*
+    Stable LSD radix sort of `keys`, moving `values` along. It is 8 bits per
+    pass, and passes where every key has the same digit are skipped, so small
+    keys are cheap. Both vectors must have the same size.
+    */
+    void radix_sort_pairs(
+        std::vector<uint64_t>& keys,
+        std::vector<uint32_t>& values,
+        ITaskScheduler* sche
+    );
+
+    // Afterwards `items[i]` is what was at `items[order[i]]`
+    template <typename T>
+    void apply_order(
+        std::vector<T>& items, const std::vector<uint32_t>& order
+    ) {
+        std::vector<T> sorted(order.size());
+        for (size_t i = 0; i < order.size(); ++i) sorted[i] = items[order[i]];
+        items.swap(sorted);
+    }
+
+
+    /*
+    Makes the order of visiting the points along a space-filling curve through
+    their bounding box, with 21 bits per axis. `out[i]` is the index of the
+    i-th point to visit. Points with NaN or infinite coordinates are left out
+    of the box, and clamped onto it.
+    */
+    template <typename T>
+    void make_curve_order(
+        std::vector<uint32_t>& out,
+        const TVec3<T>* points,
+        size_t count,
+        SpaceCurve curve,
+        ITaskScheduler* sche
+    ) {
+        constexpr double MAX_CELL = (1 << 21) - 1;
+
+        out.resize(count);
+        if (0 == count)
+            return;
+
+        Aabb3DLazyInit<T> bounds;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& p = points[i];
+            if (std::isfinite(p.x()) && std::isfinite(p.y()) &&
+                std::isfinite(p.z()))
+                bounds.set_or_expand(p);
+        }
+
+        const auto mini = bounds.mini();
+        const auto extent = bounds.maxi() - mini;
+        double scale[3];
+        for (size_t i = 0; i < 3; ++i) {
+            if (extent[i] > 0)
+                scale[i] = MAX_CELL / static_cast<double>(extent[i]);
+            else
+                scale[i] = 0;
+        }
+
+        std::vector<uint64_t> keys(count);
+        parallel_for(
+            count,
+            4096,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    uint32_t cell[3];
+                    for (size_t a = 0; a < 3; ++a) {
+                        const auto d = points[i][a] - mini[a];
+                        const auto t = static_cast<double>(d) * scale[a];
+                        // The cast is undefined for NaN and out of range
+                        if (!(t > 0))
+                            cell[a] = 0;
+                        else if (t >= MAX_CELL)
+                            cell[a] = static_cast<uint32_t>(MAX_CELL);
+                        else
+                            cell[a] = static_cast<uint32_t>(t + 0.5);
+                    }
+                    keys[i] = calc_curve_code(cell[0], cell[1], cell[2], curve);
+                    out[i] = static_cast<uint32_t>(i);
+                }
+            },
+            sche
+        );
+
+        radix_sort_pairs(keys, out, sche);
+    }
+
+    template <typename T>
+    void make_curve_order(
+        std::vector<uint32_t>& out,
+        const std::vector<TVec3<T>>& points,
+        SpaceCurve curve,
+        ITaskScheduler* sche
+    ) {
+        make_curve_order(out, points.data(), points.size(), curve, sche);
+    }
+
+    template <typename T>
+    void reorder_along_curve(
+        std::vector<TVec3<T>>& points, SpaceCurve curve, ITaskScheduler* sche
+    ) {
+        std::vector<uint32_t> order;
+        make_curve_order(order, points, curve, sche);
+        apply_order(points, order);
+    }
+
+    /*
+    Sorts the vertices along the curve by their positions and remaps the
+    indices. Triangles are then sorted by their smallest vertex index, so both
+    vertex fetches and index reads walk memory mostly forward. The winding of
+    each triangle is kept.
+    */
+    void reorder_along_curve(
+        MeshData& mesh, SpaceCurve curve, ITaskScheduler* sche
+    );
+
+}  // namespace sung
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "sung/basic/aabb.hpp"
+#include "sung/basic/geometry3d.hpp"
+
+
+namespace sung {
+
+    /*
+    Uniform grid over unbounded space. Cells are hashed into a table of
+    buckets and items are counting-sorted by bucket, so each bucket is a
+    contiguous run in the cell-ordered arrays. Meant to be rebuilt every frame;
+    internal buffers keep their capacity between builds.
+    */
+    class SpatialHashGrid3 {
+
+    public:
+        using Vec3 = TVec3<double>;
+        using Aabb3 = Aabb3D<double>;
+
+        SpatialHashGrid3() = default;
+        // An invalid `cell_size` leaves the default of 1
+        SpatialHashGrid3(double cell_size);
+
+        // Keep it around the typical query radius. False and no change if
+        // it's not positive and finite, or so small its inverse overflows.
+        bool set_cell_size(double cell_size);
+        double cell_size() const;
+
+        void build(const Vec3* points, size_t count);
+        void build(const std::vector<Vec3>& points) {
+            this->build(points.data(), points.size());
+        }
+        void build(const Sphere3* spheres, size_t count);
+        void build(const std::vector<Sphere3>& spheres) {
+            this->build(spheres.data(), spheres.size());
+        }
+
+        void clear();
+
+        size_t size() const;
+        size_t bucket_count() const;
+
+        // Indices to the array given to `build`. Spheres are reported if they
+        // touch the query volume.
+        void query_radius(
+            std::vector<uint32_t>& out, const Vec3& center, double radius
+        ) const;
+        void query_sphere(std::vector<uint32_t>& out, const Sphere3& s) const {
+            this->query_radius(out, s.pos_, s.radius_);
+        }
+        void query_aabb(std::vector<uint32_t>& out, const Aabb3& aabb) const;
+
+    private:
+        size_t calc_bucket(int64_t x, int64_t y, int64_t z) const;
+        size_t calc_bucket(const Vec3& p) const;
+        void prepare_table(size_t item_count);
+        void finish_counting(size_t item_count);
+        bool collect_buckets(std::vector<size_t>& out, const Aabb3& aabb) const;
+
+        // Cell-ordered storage
+        std::vector<Vec3> pos_;
+        std::vector<double> radius_;
+        std::vector<uint32_t> idx_;
+
+        // Bucket b spans [start_[b], start_[b + 1])
+        std::vector<uint32_t> start_;
+        std::vector<uint32_t> item_bucket_;
+
+        double cell_size_ = 1;
+        double inv_cell_size_ = 1;
+        double max_radius_ = 0;
+    };
+
+}  // namespace sung
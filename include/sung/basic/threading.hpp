@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -71,4 +72,20 @@ namespace sung {
     HTaskSche create_task_scheduler();
     HTaskSche create_task_scheduler(size_t thread_count);
 
+
+    using ParallelForFunc = std::function<void(size_t begin, size_t end)>;
+
+    /*
+    Splits [0, count) into chunks of `grain` elements and calls `func` with
+    each chunk's [begin, end). Chunks are handed to the scheduler's workers and
+    the calling thread takes some too, so it returns only after every chunk is
+    done. Everything runs on the calling thread if `sche` is null.
+    */
+    void parallel_for(
+        size_t count,
+        size_t grain,
+        const ParallelForFunc& func,
+        ITaskScheduler* sche
+    );
+
 }  // namespace sung
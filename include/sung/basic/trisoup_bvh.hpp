@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sung/basic/geometry3d.hpp"
+#include "sung/basic/threading.hpp"
+
+
+namespace sung {
+
+    // `tri_idx_` of batch results where nothing was found
+    constexpr uint32_t INVALID_TRI_IDX = 0xFFFFFFFF;
+
+    struct ClosestPointInfo {
+        bool is_valid() const { return INVALID_TRI_IDX != tri_idx_; }
+
+        TVec3<double> pos_;
+        double distance_ = 0;
+        // Index of the triangle in TriSoup3, which is `TriSoup3::idx_[i * 3]`
+        uint32_t tri_idx_ = 0;
+    };
+    using OptClosestPoint = sung::Optional<ClosestPointInfo>;
+
+
+    /*
+    Bounding volume hierarchy over a snapshot of TriSoup3, for closest point
+    and distance queries. Rebuild it if the soup changes.
+
+    Signed distance uses angle-weighted pseudo-normals, so the sign is reliable
+    only for closed meshes with consistent CCW winding. Positive is outside,
+    which is the side the triangle normals point to.
+    */
+    class TriSoupBvh3 {
+
+    public:
+        using Vec3 = TriSoup3::Vec3;
+
+        void build(const TriSoup3& soup);
+        void clear();
+
+        bool empty() const;
+        size_t tri_count() const;
+
+        bool find_closest(ClosestPointInfo& out, const Vec3& p) const;
+        OptClosestPoint find_closest(const Vec3& p) const {
+            ClosestPointInfo out;
+            if (this->find_closest(out, p))
+                return out;
+            return sung::nullopt;
+        }
+
+        // Returns 0 if there are no triangles or `p` is not finite
+        double calc_signed_dist(const Vec3& p) const;
+
+        // Points for which `find_closest` fails get INVALID_TRI_IDX
+        void find_closest_batch(
+            std::vector<ClosestPointInfo>& out,
+            const Vec3* points,
+            size_t count,
+            ITaskScheduler* sche
+        ) const;
+        void calc_signed_dist_batch(
+            std::vector<double>& out,
+            const Vec3* points,
+            size_t count,
+            ITaskScheduler* sche
+        ) const;
+
+    private:
+        struct Node {
+            Vec3 min_;
+            Vec3 max_;
+            // Children are at `first_` and `first_ + 1` if `count_` is 0,
+            // otherwise it is a leaf of triangles [first_, first_ + count_)
+            uint32_t first_ = 0;
+            uint32_t count_ = 0;
+        };
+
+        void build_rec(uint32_t node, uint32_t first, uint32_t count);
+        // `leaf_tri` is in the leaf order
+        bool find_closest_impl(
+            ClosestPointInfo& out,
+            uint32_t& leaf_tri,
+            Vec3& barycentric,
+            const Vec3& p
+        ) const;
+        Vec3 select_pseudo_normal(uint32_t tri, const Vec3& barycentric) const;
+
+        std::vector<Node> nodes_;
+        // In the leaf order
+        std::vector<Triangle3> tris_;
+        std::vector<uint32_t> tri_idx_;
+
+        // Pseudo-normals for the signed distance, indexed in the leaf order
+        std::vector<Vec3> face_normals_;
+        // 3 per triangle: ab, bc, ca
+        std::vector<Vec3> edge_normals_;
+        // 3 per triangle: a, b, c
+        std::vector<Vec3> vtx_normals_;
+    };
+
+}  // namespace sung
@@ -0,0 +1,852 @@
+#include "sung/basic/aadd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "sung/basic/float16.hpp"
+#include "sung/basic/lz.hpp"
+
+
+namespace {
+
+    // chunk_elements and index_offset
+    constexpr uint64_t CHUNK_HEADER_SIZE = 16;
+
+
+    // Shuffled and compressed, or the bytes as they are if that's no smaller
+    void encode_chunk(
+        std::vector<sung::byte8>& out,
+        const sung::byte8* src,
+        size_t count,
+        size_t type_size
+    ) {
+        const auto size = count * type_size;
+        std::vector<sung::byte8> shuffled(size);
+        sung::shuffle_bytes(shuffled.data(), src, count, type_size);
+
+        out.resize(sung::lz_compress_bound(size));
+        const auto packed = sung::lz_compress(
+            out.data(), out.size(), shuffled.data(), size
+        );
+        if (0 == packed || packed >= size)
+            out.assign(src, src + size);
+        else
+            out.resize(packed);
+    }
+
+    bool decode_chunk(
+        sung::byte8* dst,
+        size_t count,
+        size_t type_size,
+        const sung::byte8* src,
+        size_t src_size
+    ) {
+        const auto size = count * type_size;
+        if (src_size == size) {
+            std::memcpy(dst, src, size);
+            return true;
+        }
+
+        std::vector<sung::byte8> shuffled(size);
+        if (!sung::lz_decompress(shuffled.data(), size, src, src_size))
+            return false;
+        sung::unshuffle_bytes(dst, shuffled.data(), count, type_size);
+        return true;
+    }
+
+    // Fields in the data area are not aligned
+    uint64_t read_u64(const sung::byte8* p) {
+        alignas(uint64_t) sung::byte8 buf[sizeof(uint64_t)];
+        std::memcpy(buf, p, sizeof(buf));
+        return sung::assemble_le_data<uint64_t>(buf);
+    }
+
+
+    // Elements converted at a time through stack buffers
+    constexpr size_t VALUE_BLOCK = 1024;
+    // Elements per task when converting mapped data
+    constexpr size_t VALUE_GRAIN = 1 << 16;
+
+
+    template <typename S, typename F>
+    typename std::enable_if<std::is_integral<S>::value, S>::type to_stored(
+        F v
+    ) {
+        constexpr auto LOWEST = std::numeric_limits<S>::lowest();
+        constexpr auto HIGHEST = (std::numeric_limits<S>::max)();
+        if (std::isnan(v))
+            return 0;
+
+        // The limits of 64 bit types round up to a power of two as doubles,
+        // so the comparisons catch everything that wouldn't fit
+        const auto r = std::round(static_cast<double>(v));
+        if (r <= static_cast<double>(LOWEST))
+            return LOWEST;
+        if (r >= static_cast<double>(HIGHEST))
+            return HIGHEST;
+        return static_cast<S>(r);
+    }
+
+    template <typename S, typename F>
+    typename std::enable_if<std::is_floating_point<S>::value, S>::type
+    to_stored(F v) {
+        return static_cast<S>(v);
+    }
+
+    template <typename S, typename D>
+    void decode_as(D* dst, const sung::byte8* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            S v;
+            std::memcpy(&v, src + i * sizeof(S), sizeof(S));
+            dst[i] = static_cast<D>(v);
+        }
+    }
+
+    template <typename S, typename F>
+    void encode_as(sung::byte8* dst, const F* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const auto v = ::to_stored<S>(src[i]);
+            std::memcpy(dst + i * sizeof(S), &v, sizeof(S));
+        }
+    }
+
+    template <typename D>
+    void decode_float16(D* dst, const sung::byte8* src, size_t count) {
+        uint16_t bits[VALUE_BLOCK];
+        float values[VALUE_BLOCK];
+        for (size_t i = 0; i < count; i += VALUE_BLOCK) {
+            const auto n = (std::min)(VALUE_BLOCK, count - i);
+            std::memcpy(bits, src + i * sizeof(uint16_t), n * sizeof(uint16_t));
+            sung::convert_float16_to_float32(values, bits, n);
+            std::copy(values, values + n, dst + i);
+        }
+    }
+
+    template <typename F>
+    void encode_float16(sung::byte8* dst, const F* src, size_t count) {
+        uint16_t bits[VALUE_BLOCK];
+        float values[VALUE_BLOCK];
+        for (size_t i = 0; i < count; i += VALUE_BLOCK) {
+            const auto n = (std::min)(VALUE_BLOCK, count - i);
+            for (size_t j = 0; j < n; ++j)
+                values[j] = static_cast<float>(src[i + j]);
+            sung::convert_float32_to_float16(bits, values, n);
+            std::memcpy(dst + i * sizeof(uint16_t), bits, n * sizeof(uint16_t));
+        }
+    }
+
+    template <typename D>
+    bool decode_values(
+        D* dst, const void* src, size_t count, sung::AaddHeader::DataType type
+    ) {
+        using DataType = sung::AaddHeader::DataType;
+        const auto p = reinterpret_cast<const sung::byte8*>(src);
+        switch (type) {
+            case DataType::int8:
+                ::decode_as<int8_t>(dst, p, count);
+                return true;
+            case DataType::int16:
+                ::decode_as<int16_t>(dst, p, count);
+                return true;
+            case DataType::int32:
+                ::decode_as<int32_t>(dst, p, count);
+                return true;
+            case DataType::int64:
+                ::decode_as<int64_t>(dst, p, count);
+                return true;
+            case DataType::uint8:
+                ::decode_as<uint8_t>(dst, p, count);
+                return true;
+            case DataType::uint16:
+                ::decode_as<uint16_t>(dst, p, count);
+                return true;
+            case DataType::uint32:
+                ::decode_as<uint32_t>(dst, p, count);
+                return true;
+            case DataType::uint64:
+                ::decode_as<uint64_t>(dst, p, count);
+                return true;
+            case DataType::float16:
+                ::decode_float16(dst, p, count);
+                return true;
+            case DataType::float32:
+                ::decode_as<float>(dst, p, count);
+                return true;
+            case DataType::float64:
+                ::decode_as<double>(dst, p, count);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template <typename F>
+    bool encode_values(
+        void* dst, sung::AaddHeader::DataType type, const F* src, size_t count
+    ) {
+        using DataType = sung::AaddHeader::DataType;
+        const auto p = reinterpret_cast<sung::byte8*>(dst);
+        switch (type) {
+            case DataType::int8:
+                ::encode_as<int8_t>(p, src, count);
+                return true;
+            case DataType::int16:
+                ::encode_as<int16_t>(p, src, count);
+                return true;
+            case DataType::int32:
+                ::encode_as<int32_t>(p, src, count);
+                return true;
+            case DataType::int64:
+                ::encode_as<int64_t>(p, src, count);
+                return true;
+            case DataType::uint8:
+                ::encode_as<uint8_t>(p, src, count);
+                return true;
+            case DataType::uint16:
+                ::encode_as<uint16_t>(p, src, count);
+                return true;
+            case DataType::uint32:
+                ::encode_as<uint32_t>(p, src, count);
+                return true;
+            case DataType::uint64:
+                ::encode_as<uint64_t>(p, src, count);
+                return true;
+            case DataType::float16:
+                ::encode_float16(p, src, count);
+                return true;
+            case DataType::float32:
+                ::encode_as<float>(p, src, count);
+                return true;
+            case DataType::float64:
+                ::encode_as<double>(p, src, count);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+}  // namespace
+
+
+// Typed conversion
+namespace sung {
+
+    bool decode_aadd_values(
+        float* dst, const void* src, size_t count, AaddHeader::DataType type
+    ) {
+        return ::decode_values(dst, src, count, type);
+    }
+
+    bool decode_aadd_values(
+        double* dst, const void* src, size_t count, AaddHeader::DataType type
+    ) {
+        return ::decode_values(dst, src, count, type);
+    }
+
+    bool encode_aadd_values(
+        void* dst, AaddHeader::DataType type, const float* src, size_t count
+    ) {
+        return ::encode_values(dst, type, src, count);
+    }
+
+    bool encode_aadd_values(
+        void* dst, AaddHeader::DataType type, const double* src, size_t count
+    ) {
+        return ::encode_values(dst, type, src, count);
+    }
+
+}  // namespace sung
+
+
+// AaddWriter
+namespace sung {
+
+    AaddWriter::~AaddWriter() { this->close(); }
+
+    bool AaddWriter::open(
+        const std::string& path,
+        AaddHeader::DataType data_type,
+        size_t buffer_size
+    ) {
+        this->close();
+
+        type_size_ = AaddHeader::get_data_type_size(data_type);
+        if (0 == type_size_)
+            return false;
+
+        // The stream's own buffer would only copy our chunks once more
+        file_.rdbuf()->pubsetbuf(nullptr, 0);
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_)
+            return false;
+
+        dims_.clear();
+        desc_.clear();
+        buffer_size_ = (std::max<size_t>)(buffer_size, type_size_);
+        buffer_.clear();
+        buffer_.reserve(buffer_size_);
+        data_count_ = 0;
+        written_ = 0;
+        data_type_ = data_type;
+        data_started_ = false;
+        failed_ = false;
+
+        pending_.clear();
+        chunk_offsets_.clear();
+        sche_ = nullptr;
+        chunk_elements_ = 0;
+        chunks_begin_ = 0;
+        comp_method_ = AaddHeader::CompMethod::none;
+        return true;
+    }
+
+    bool AaddWriter::close() {
+        if (!this->is_open())
+            return false;
+
+        this->begin_data();
+        if (AaddHeader::CompMethod::z == comp_method_)
+            this->finish_chunks();
+        this->flush();
+
+        // Back-patch the header now that the data count is known
+        const auto header = this->make_header();
+        file_.seekp(0);
+        file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (AaddHeader::CompMethod::z == comp_method_ && !failed_) {
+            // Data shorter than a chunk is one chunk of all of it, and
+            // the index follows the end of the last chunk
+            uint64_t chunk = chunk_elements_;
+            if (0 != data_count_ && data_count_ < chunk)
+                chunk = data_count_;
+            const LEValue<uint64_t> chunk_elements{ chunk };
+            const LEValue<uint64_t> index_offset{ chunk_offsets_.back() };
+            file_.seekp(static_cast<std::streamoff>(chunks_begin_));
+            file_.write(
+                reinterpret_cast<const char*>(chunk_elements.data()),
+                chunk_elements.size()
+            );
+            file_.write(
+                reinterpret_cast<const char*>(index_offset.data()),
+                index_offset.size()
+            );
+        }
+        if (!file_)
+            failed_ = true;
+
+        file_.close();
+        buffer_ = {};
+        pending_ = {};
+        chunk_offsets_ = {};
+        return !failed_;
+    }
+
+    bool AaddWriter::is_open() const { return file_.is_open(); }
+
+    bool AaddWriter::add_dimension(const AaddHeader::Dimension& dim) {
+        if (!this->is_open() || data_started_)
+            return false;
+        dims_.push_back(dim);
+        return true;
+    }
+
+    bool AaddWriter::add_dimension(
+        double min, double max, uint64_t count, const char* name
+    ) {
+        AaddHeader::Dimension dim;
+        dim.init(min, max, count, name);
+        return this->add_dimension(dim);
+    }
+
+    bool AaddWriter::set_description(const std::string& desc) {
+        if (!this->is_open() || data_started_)
+            return false;
+        desc_ = desc;
+        return true;
+    }
+
+    bool AaddWriter::set_compression(
+        AaddHeader::CompMethod method,
+        ITaskScheduler* sche,
+        size_t chunk_elements
+    ) {
+        if (!this->is_open() || data_started_)
+            return false;
+        if (AaddHeader::CompMethod::z == method && 0 == chunk_elements)
+            return false;
+
+        comp_method_ = method;
+        sche_ = sche;
+        chunk_elements_ = chunk_elements;
+        return true;
+    }
+
+    bool AaddWriter::write_data(const void* data, size_t count) {
+        if (!this->is_open() || !this->begin_data())
+            return false;
+
+        const auto size = count * type_size_;
+        if (AaddHeader::CompMethod::z != comp_method_) {
+            if (!this->put(data, size))
+                return false;
+            data_count_ += count;
+            return true;
+        }
+
+        const auto src = reinterpret_cast<const byte8*>(data);
+        pending_.insert(pending_.end(), src, src + size);
+        data_count_ += count;
+
+        const auto batch = nullptr != sche_ ? CHUNK_BATCH : 1;
+        if (pending_.size() >= batch * chunk_elements_ * type_size_)
+            return this->write_chunks(false);
+        return !failed_;
+    }
+
+    bool AaddWriter::write_values(const float* data, size_t count) {
+        return this->write_values_impl(data, count);
+    }
+
+    bool AaddWriter::write_values(const double* data, size_t count) {
+        return this->write_values_impl(data, count);
+    }
+
+    AaddHeader AaddWriter::make_header() const {
+        AaddHeader header;
+        header.init(
+            dims_.size(),
+            desc_.size(),
+            data_count_,
+            data_type_,
+            comp_method_
+        );
+        return header;
+    }
+
+    bool AaddWriter::begin_data() {
+        if (data_started_)
+            return !failed_;
+        data_started_ = true;
+
+        const auto header = this->make_header();
+        this->put(&header, sizeof(header));
+        this->put(dims_.data(), dims_.size() * sizeof(AaddHeader::Dimension));
+        this->put(desc_.data(), desc_.size());
+
+        if (AaddHeader::CompMethod::z == comp_method_) {
+            // The index offset is filled in on close
+            chunks_begin_ = written_;
+            const LEValue<uint64_t> chunk_elements{ chunk_elements_ };
+            const LEValue<uint64_t> index_offset{ 0 };
+            this->put(chunk_elements.data(), chunk_elements.size());
+            this->put(index_offset.data(), index_offset.size());
+        }
+        return !failed_;
+    }
+
+    bool AaddWriter::put(const void* data, size_t size) {
+        if (failed_)
+            return false;
+        written_ += size;
+
+        const auto src = reinterpret_cast<const byte8*>(data);
+        if (buffer_.size() + size <= buffer_size_) {
+            buffer_.insert(buffer_.end(), src, src + size);
+            return true;
+        }
+
+        // Doesn't fit, so flush and buffer it or write it through
+        if (!this->flush())
+            return false;
+        if (size < buffer_size_) {
+            buffer_.insert(buffer_.end(), src, src + size);
+            return true;
+        }
+
+        file_.write(
+            reinterpret_cast<const char*>(src),
+            static_cast<std::streamsize>(size)
+        );
+        if (!file_)
+            failed_ = true;
+        return !failed_;
+    }
+
+    bool AaddWriter::flush() {
+        if (failed_)
+            return false;
+        if (buffer_.empty())
+            return true;
+
+        file_.write(
+            reinterpret_cast<const char*>(buffer_.data()),
+            static_cast<std::streamsize>(buffer_.size())
+        );
+        buffer_.clear();
+        if (!file_)
+            failed_ = true;
+        return !failed_;
+    }
+
+    bool AaddWriter::write_chunks(bool last) {
+        const auto chunk_bytes = chunk_elements_ * type_size_;
+        auto count = pending_.size() / chunk_bytes;
+        if (last && 0 != pending_.size() % chunk_bytes)
+            ++count;
+
+        std::vector<std::vector<byte8>> encoded(count);
+        parallel_for(
+            count,
+            1,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const auto offset = i * chunk_bytes;
+                    const auto size = (std::min)(
+                        chunk_bytes, pending_.size() - offset
+                    );
+                    ::encode_chunk(
+                        encoded[i],
+                        pending_.data() + offset,
+                        size / type_size_,
+                        type_size_
+                    );
+                }
+            },
+            sche_
+        );
+
+        for (const auto& chunk : encoded) {
+            chunk_offsets_.push_back(written_ - chunks_begin_);
+            this->put(chunk.data(), chunk.size());
+        }
+
+        const auto consumed = (std::min)(count * chunk_bytes, pending_.size());
+        pending_.erase(pending_.begin(), pending_.begin() + consumed);
+        return !failed_;
+    }
+
+    template <typename T>
+    bool AaddWriter::write_values_impl(const T* data, size_t count) {
+        if (!this->is_open())
+            return false;
+
+        std::vector<byte8> block(::VALUE_BLOCK * type_size_);
+        for (size_t i = 0; i < count; i += ::VALUE_BLOCK) {
+            const auto n = (std::min)(::VALUE_BLOCK, count - i);
+            ::encode_values(block.data(), data_type_, data + i, n);
+            if (!this->write_data(block.data(), n))
+                return false;
+        }
+        return true;
+    }
+
+    bool AaddWriter::finish_chunks() {
+        this->write_chunks(true);
+
+        // One past the last chunk, which is also where the index starts
+        chunk_offsets_.push_back(written_ - chunks_begin_);
+        for (const auto offset : chunk_offsets_) {
+            const LEValue<uint64_t> value{ offset };
+            this->put(value.data(), value.size());
+        }
+        return !failed_;
+    }
+
+}  // namespace sung
+
+
+// AaddReader
+namespace sung {
+
+    bool AaddReader::open(const std::string& path) {
+        this->close();
+        if (!file_.open(path))
+            return false;
+
+        const auto file_size = static_cast<uint64_t>(file_.size());
+        if (file_size < sizeof(AaddHeader)) {
+            this->close();
+            return false;
+        }
+
+        const auto& header = this->header();
+        const auto type_size = AaddHeader::get_data_type_size(
+            header.data_type()
+        );
+        const auto method = header.comp_method();
+        const auto valid = header.is_magic_valid() && 0 != type_size &&
+                           (AaddHeader::CompMethod::none == method ||
+                            AaddHeader::CompMethod::z == method) &&
+                           header.data_count() <= UINT64_MAX / type_size;
+        if (!valid) {
+            this->close();
+            return false;
+        }
+
+        // Each step is checked against what's left of the file, so corrupt
+        // counts can't overflow the offsets
+        auto remaining = file_size - sizeof(AaddHeader);
+        const auto dim_count = header.dim_count();
+        const auto dim_size = sizeof(AaddHeader::Dimension);
+        if (dim_count > remaining / dim_size) {
+            this->close();
+            return false;
+        }
+        remaining -= dim_count * dim_size;
+
+        if (header.desc_len() > remaining) {
+            this->close();
+            return false;
+        }
+        remaining -= header.desc_len();
+        data_offset_ = file_size - remaining;
+        data_size_ = header.data_count() * type_size;
+        type_size_ = type_size;
+
+        if (AaddHeader::CompMethod::z == method) {
+            if (!this->open_chunks(remaining)) {
+                this->close();
+                return false;
+            }
+        } else if (header.data_count() > remaining / type_size) {
+            this->close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void AaddReader::close() {
+        file_.close();
+        data_offset_ = 0;
+        data_size_ = 0;
+        type_size_ = 0;
+        chunk_count_ = 0;
+        chunk_elements_ = 0;
+        index_offset_ = 0;
+    }
+
+    bool AaddReader::is_open() const { return file_.is_open(); }
+
+    const AaddHeader& AaddReader::header() const {
+        return *reinterpret_cast<const AaddHeader*>(file_.data());
+    }
+
+    const AaddHeader::Dimension& AaddReader::dimension(size_t index) const {
+        const auto dims = reinterpret_cast<const AaddHeader::Dimension*>(
+            file_.data() + sizeof(AaddHeader)
+        );
+        return dims[index];
+    }
+
+    std::string AaddReader::description() const {
+        if (!this->is_open())
+            return {};
+
+        const auto len = static_cast<size_t>(this->header().desc_len());
+        const auto ptr = file_.data() + data_offset_ - len;
+        return std::string(reinterpret_cast<const char*>(ptr), len);
+    }
+
+    const byte8* AaddReader::data() const {
+        if (!this->is_open() || 0 != chunk_elements_)
+            return nullptr;
+        return file_.data() + data_offset_;
+    }
+
+    uint64_t AaddReader::chunk_size(uint64_t index) const {
+        if (index >= chunk_count_)
+            return 0;
+        const auto begin = index * chunk_elements_;
+        return (std::min)(chunk_elements_, this->header().data_count() - begin);
+    }
+
+    bool AaddReader::read_chunk(uint64_t index, void* dst) const {
+        if (index >= chunk_count_)
+            return false;
+
+        const auto begin = this->chunk_offset(index);
+        const auto end = this->chunk_offset(index + 1);
+        return ::decode_chunk(
+            reinterpret_cast<byte8*>(dst),
+            static_cast<size_t>(this->chunk_size(index)),
+            static_cast<size_t>(type_size_),
+            file_.data() + data_offset_ + begin,
+            static_cast<size_t>(end - begin)
+        );
+    }
+
+    bool AaddReader::read_data(void* dst, ITaskScheduler* sche) const {
+        if (!this->is_open())
+            return false;
+        if (0 == chunk_elements_) {
+            std::memcpy(dst, this->data(), static_cast<size_t>(data_size_));
+            return true;
+        }
+
+        const auto out = reinterpret_cast<byte8*>(dst);
+        const auto chunk_bytes = chunk_elements_ * type_size_;
+        std::atomic<bool> ok{ true };
+        parallel_for(
+            static_cast<size_t>(chunk_count_),
+            1,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (!this->read_chunk(i, out + i * chunk_bytes))
+                        ok = false;
+                }
+            },
+            sche
+        );
+        return ok;
+    }
+
+    bool AaddReader::read_values(float* dst, ITaskScheduler* sche) const {
+        return this->read_values_impl(dst, sche);
+    }
+
+    bool AaddReader::read_values(double* dst, ITaskScheduler* sche) const {
+        return this->read_values_impl(dst, sche);
+    }
+
+    void AaddReader::advise(AccessHint hint) const {
+        file_.advise(
+            hint,
+            static_cast<size_t>(data_offset_),
+            static_cast<size_t>(data_size_)
+        );
+    }
+
+    void AaddReader::advise(AccessHint hint, uint64_t first, uint64_t count)
+        const {
+        if (!this->is_open())
+            return;
+
+        const auto type_size = AaddHeader::get_data_type_size(
+            this->header().data_type()
+        );
+        file_.advise(
+            hint,
+            static_cast<size_t>(data_offset_ + first * type_size),
+            static_cast<size_t>(count * type_size)
+        );
+    }
+
+    bool AaddReader::check_view(
+        size_t type_size, std::vector<uint64_t>& counts
+    ) const {
+        if (!this->is_open())
+            return false;
+
+        const auto& header = this->header();
+        if (AaddHeader::CompMethod::none != header.comp_method())
+            return false;
+        if (AaddHeader::get_data_type_size(header.data_type()) != type_size)
+            return false;
+
+        counts.clear();
+        const auto dim_count = static_cast<size_t>(header.dim_count());
+        if (0 == dim_count) {
+            counts.push_back(header.data_count());
+            return true;
+        }
+
+        uint64_t total = 1;
+        for (size_t i = 0; i < dim_count; ++i) {
+            const auto count = this->dimension(i).count();
+            counts.push_back(count);
+            // Stops once past the data count so the product can't wrap
+            if (0 == count || total > header.data_count() / count)
+                return false;
+            total *= count;
+        }
+        return total == header.data_count();
+    }
+
+    bool AaddReader::open_chunks(uint64_t remaining) {
+        if (remaining < CHUNK_HEADER_SIZE)
+            return false;
+
+        const auto base = file_.data() + data_offset_;
+        const auto data_count = this->header().data_count();
+        chunk_elements_ = ::read_u64(base);
+        index_offset_ = ::read_u64(base + 8);
+        if (0 == chunk_elements_)
+            return false;
+        // A chunk is decoded whole, so it can't be bigger than the data, and
+        // its byte size must fit. Empty data is written with the default.
+        if (0 != data_count && chunk_elements_ > data_count)
+            return false;
+        if (chunk_elements_ > SIZE_MAX / type_size_)
+            return false;
+        chunk_count_ = data_count / chunk_elements_ +
+                       (0 != data_count % chunk_elements_ ? 1 : 0);
+
+        if (index_offset_ < CHUNK_HEADER_SIZE || index_offset_ > remaining)
+            return false;
+        // chunk_count + 1 entries
+        if (chunk_count_ >= (remaining - index_offset_) / 8)
+            return false;
+
+        // Offsets must run in order between the chunk header and the index
+        auto prev = CHUNK_HEADER_SIZE;
+        for (uint64_t i = 0; i <= chunk_count_; ++i) {
+            const auto offset = this->chunk_offset(i);
+            if (offset < prev)
+                return false;
+            prev = offset;
+        }
+        return prev == index_offset_;
+    }
+
+    template <typename T>
+    bool AaddReader::read_values_impl(T* dst, ITaskScheduler* sche) const {
+        if (!this->is_open())
+            return false;
+
+        const auto type = this->header().data_type();
+        const auto ts = static_cast<size_t>(type_size_);
+        if (0 == chunk_elements_) {
+            parallel_for(
+                static_cast<size_t>(this->header().data_count()),
+                ::VALUE_GRAIN,
+                [&](size_t begin, size_t end) {
+                    const auto src = this->data() + begin * ts;
+                    ::decode_values(dst + begin, src, end - begin, type);
+                },
+                sche
+            );
+            return true;
+        }
+
+        std::atomic<bool> ok{ true };
+        parallel_for(
+            static_cast<size_t>(chunk_count_),
+            1,
+            [&](size_t begin, size_t end) {
+                std::vector<byte8> raw(chunk_elements_ * ts);
+                for (size_t i = begin; i < end; ++i) {
+                    if (!this->read_chunk(i, raw.data())) {
+                        ok = false;
+                        continue;
+                    }
+                    const auto n = static_cast<size_t>(this->chunk_size(i));
+                    const auto out = dst + i * chunk_elements_;
+                    ::decode_values(out, raw.data(), n, type);
+                }
+            },
+            sche
+        );
+        return ok;
+    }
+
+    uint64_t AaddReader::chunk_offset(uint64_t index) const {
+        const auto base = file_.data() + data_offset_ + index_offset_;
+        return ::read_u64(base + index * 8);
+    }
+
+}  // namespace sung
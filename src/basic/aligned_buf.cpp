@@ -0,0 +1,73 @@
+#include "sung/basic/aligned_buf.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "sung/basic/os_detect.hpp"
+
+#if defined(SUNG_OS_WINDOWS)
+    #include <malloc.h>
+#elif defined(SUNG_OS_LINUX) || defined(SUNG_OS_ANDROID)
+    #include <sys/mman.h>
+#endif
+
+
+namespace {
+
+    void advise_huge_pages(void* ptr, size_t bytes) {
+#if defined(MADV_HUGEPAGE)
+        // Only whole huge pages within the allocation
+        const auto begin = reinterpret_cast<uintptr_t>(ptr);
+        const auto end = begin + bytes / sung::HUGE_PAGE_SIZE *
+                                     sung::HUGE_PAGE_SIZE;
+        if (end > begin) {
+            // Failure only means the kernel ignores the hint
+            const auto addr = reinterpret_cast<void*>(begin);
+            ::madvise(addr, end - begin, MADV_HUGEPAGE);
+        }
+#else
+        (void)ptr;
+        (void)bytes;
+#endif
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    void* alloc_aligned(size_t bytes, size_t align, bool huge_pages) {
+        if (0 == align || 0 != (align & (align - 1)))
+            return nullptr;
+        if (align < sizeof(void*))
+            align = sizeof(void*);
+
+        const auto use_huge = huge_pages && bytes >= HUGE_PAGE_SIZE;
+        if (use_huge && align < HUGE_PAGE_SIZE)
+            align = HUGE_PAGE_SIZE;
+        // Zero sized requests still get a unique pointer. Neither allocator
+        // needs the size to be a multiple of the alignment.
+        const auto size = bytes ? bytes : 1;
+
+#if defined(SUNG_OS_WINDOWS)
+        void* ptr = ::_aligned_malloc(size, align);
+#else
+        void* ptr = nullptr;
+        if (0 != ::posix_memalign(&ptr, align, size))
+            return nullptr;
+#endif
+
+        if (use_huge && nullptr != ptr)
+            ::advise_huge_pages(ptr, size);
+        return ptr;
+    }
+
+    void free_aligned(void* ptr) noexcept {
+#if defined(SUNG_OS_WINDOWS)
+        ::_aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+}  // namespace sung
@@ -1,31 +1,268 @@
 #include "sung/basic/densify.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "sung/basic/aadd.hpp"
+#include "sung/basic/os_detect.hpp"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 
 namespace {
 
-    sung::Optional<size_t> find_next_non_zero(
-        const size_t idx,
-        const std::vector<sung::DenseDataBuilder::Record>& records
+    using Record = sung::DenseDataBuilder::Record;
+
+    constexpr size_t NONE = SIZE_MAX;
+    constexpr size_t LINE_GRAIN = 64;
+    constexpr size_t RECORD_GRAIN = 1 << 16;
+    // Records per task when filling a 1D array in parallel
+    constexpr size_t FILL_CHUNK = 1 << 20;
+    // Values converted at a time when writing to AADD
+    constexpr size_t WRITE_BLOCK = 1 << 16;
+    // Values per task and independent accumulators in ValArrayAnalyzer
+    constexpr size_t REDUCE_GRAIN = 1 << 20;
+    constexpr size_t REDUCE_LANES = 8;
+
+
+    // Keeps `current` unless `value` compares below it, so a NaN `value`
+    // is ignored. Maps to a single minsd / minpd on x86.
+    double min_of(double value, double current) {
+        return value < current ? value : current;
+    }
+
+    double max_of(double value, double current) {
+        return value > current ? value : current;
+    }
+
+
+    /*
+    Fills records [lo, hi) from the samples at `prev` and `next`, either of
+    which can be NONE. Between two samples the values are interpolated,
+    next to only one they are copied.
+    */
+    void fill_gap(
+        Record* records,
+        size_t stride,
+        size_t lo,
+        size_t hi,
+        size_t prev,
+        size_t next
     ) {
-        for (size_t i = idx + 1; idx < records.size(); ++i) {
-            if (records[i].count_ != 0)
-                return i;
+        if (lo >= hi || (NONE == prev && NONE == next))
+            return;
+
+        if (NONE == prev || NONE == next) {
+            const auto src = records[(NONE == prev ? next : prev) * stride];
+            for (size_t i = lo; i < hi; ++i) records[i * stride] = src;
+            return;
         }
 
-        return sung::nullopt;
+        // No division per record, so the loop is multiply-adds only
+        const auto a = records[prev * stride].val_;
+        const auto b = records[next * stride].val_;
+        const auto step = (b - a) / static_cast<double>(next - prev);
+        auto t = static_cast<double>(lo - prev);
+        for (size_t i = lo; i < hi; ++i, t += 1) {
+            auto& r = records[i * stride];
+            r.val_ = a + step * t;
+            r.count_ = 1;
+        }
     }
 
-    sung::Optional<size_t> find_prev_non_zero(
-        const size_t idx,
-        const std::vector<sung::DenseDataBuilder::Record>& records
+    /*
+    Fills the gaps in [begin, end) in one sweep. `prev` is the last sample
+    before `begin` and `next` the first one at or after `end`, NONE if
+    there is none. Only empty records are written, so neighbouring ranges
+    can be filled at the same time.
+    */
+    void fill_range(
+        Record* records,
+        size_t stride,
+        size_t begin,
+        size_t end,
+        size_t prev,
+        size_t next
     ) {
-        for (size_t i = 0; i < idx; ++i) {
-            const auto curr_idx = idx - i - 1;
-            if (records[curr_idx].count_ != 0)
-                return curr_idx;
+        const auto gap_begin = [&]() {
+            return NONE == prev ? begin : (std::max)(prev + 1, begin);
+        };
+
+        for (size_t i = begin; i < end; ++i) {
+            if (0 == records[i * stride].count_)
+                continue;
+            ::fill_gap(records, stride, gap_begin(), i, prev, i);
+            prev = i;
         }
+        ::fill_gap(records, stride, gap_begin(), end, prev, next);
+    }
+
+    // One line of `count` records `stride` apart. Lines without samples
+    // are left empty.
+    void fill_line(Record* records, size_t count, size_t stride) {
+        ::fill_range(records, stride, 0, count, NONE, NONE);
+    }
+
+    size_t product(const std::vector<size_t>& shape) {
+        size_t out = shape.empty() ? 0 : 1;
+        for (const auto x : shape) out *= x;
+        return out;
+    }
+
+    // False if the byte size of the records doesn't fit in size_t
+    bool calc_bytes(
+        const std::vector<size_t>& shape, size_t record_size, size_t& out
+    ) {
+        const auto max_size = (std::numeric_limits<size_t>::max)();
+        size_t count = shape.empty() ? 0 : 1;
+        for (const auto x : shape) {
+            if (0 != x && count > max_size / x)
+                return false;
+            count *= x;
+        }
+        if (count > max_size / record_size)
+            return false;
+        out = count * record_size;
+        return true;
+    }
+
+    // Lock-free add to a plain double, with a compare and swap loop
+    void atomic_add(double& target, double value) {
+        static_assert(sizeof(double) == sizeof(int64_t), "");
+#if defined(_MSC_VER)
+        auto ptr = reinterpret_cast<volatile __int64*>(&target);
+        __int64 expected = *ptr;
+        while (true) {
+            double current, next;
+            std::memcpy(&current, &expected, sizeof(double));
+            next = current + value;
+            __int64 desired;
+            std::memcpy(&desired, &next, sizeof(double));
+            const auto seen = _InterlockedCompareExchange64(
+                ptr, desired, expected
+            );
+            if (seen == expected)
+                return;
+            expected = seen;
+        }
+#else
+        double expected;
+        __atomic_load(&target, &expected, __ATOMIC_RELAXED);
+        double desired = expected + value;
+        while (!__atomic_compare_exchange(
+            &target,
+            &expected,
+            &desired,
+            true,
+            __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED
+        )) {
+            desired = expected + value;
+        }
+#endif
+    }
+
+    void atomic_increment(int& target) {
+#if defined(_MSC_VER)
+        static_assert(sizeof(int) == sizeof(long), "");
+        _InterlockedIncrement(reinterpret_cast<volatile long*>(&target));
+#else
+        __atomic_fetch_add(&target, 1, __ATOMIC_RELAXED);
+#endif
+    }
+
+
+    /*
+    Ranges of values and of differences between neighbours, with the same
+    comparisons as Aabb1DLazyInit so NaN values are skipped the same way.
+    An empty diff range has its minimum above its maximum.
+    */
+    struct RangeStats {
+        void merge(const RangeStats& other) {
+            mini_ = ::min_of(other.mini_, mini_);
+            maxi_ = ::max_of(other.maxi_, maxi_);
+            diff_mini_ = ::min_of(other.diff_mini_, diff_mini_);
+            diff_maxi_ = ::max_of(other.diff_maxi_, diff_maxi_);
+        }
+
+        double mini_ = std::numeric_limits<double>::infinity();
+        double maxi_ = -std::numeric_limits<double>::infinity();
+        double diff_mini_ = std::numeric_limits<double>::infinity();
+        double diff_maxi_ = -std::numeric_limits<double>::infinity();
+    };
+
+    /*
+    Reduces values [begin, end) and their differences from the previous
+    value, so `begin` must be at least 1. Each of the REDUCE_LANES
+    accumulators only depends on itself and there are no branches, which
+    lets the compiler turn the inner loop into vector min and max.
+    */
+    template <typename TLoad>
+    RangeStats reduce_ranges(
+        const TLoad& load, size_t begin, size_t end, double threshold
+    ) {
+        constexpr auto INF = std::numeric_limits<double>::infinity();
+        double mini[REDUCE_LANES], maxi[REDUCE_LANES];
+        double diff_mini[REDUCE_LANES], diff_maxi[REDUCE_LANES];
+        for (size_t j = 0; j < REDUCE_LANES; ++j) {
+            mini[j] = diff_mini[j] = INF;
+            maxi[j] = diff_maxi[j] = -INF;
+        }
+
+        size_t i = begin;
+        for (; i + REDUCE_LANES <= end; i += REDUCE_LANES) {
+            for (size_t j = 0; j < REDUCE_LANES; ++j) {
+                const auto v = load(i + j);
+                const auto d = v - load(i + j - 1);
+                const auto keep = threshold <= std::abs(d);
+                mini[j] = ::min_of(v, mini[j]);
+                maxi[j] = ::max_of(v, maxi[j]);
+                diff_mini[j] = ::min_of(keep ? d : INF, diff_mini[j]);
+                diff_maxi[j] = ::max_of(keep ? d : -INF, diff_maxi[j]);
+            }
+        }
+
+        RangeStats out;
+        for (size_t j = 0; j < REDUCE_LANES; ++j) {
+            out.mini_ = ::min_of(mini[j], out.mini_);
+            out.maxi_ = ::max_of(maxi[j], out.maxi_);
+            out.diff_mini_ = ::min_of(diff_mini[j], out.diff_mini_);
+            out.diff_maxi_ = ::max_of(diff_maxi[j], out.diff_maxi_);
+        }
+        for (; i < end; ++i) {
+            const auto v = load(i);
+            const auto d = v - load(i - 1);
+            out.mini_ = ::min_of(v, out.mini_);
+            out.maxi_ = ::max_of(v, out.maxi_);
+            if (threshold <= std::abs(d)) {
+                out.diff_mini_ = ::min_of(d, out.diff_mini_);
+                out.diff_maxi_ = ::max_of(d, out.diff_maxi_);
+            }
+        }
+        return out;
+    }
 
-        return sung::nullopt;
+
+    void divide(Record* records, size_t size, sung::ITaskScheduler* sche) {
+        sung::parallel_for(
+            size,
+            RECORD_GRAIN,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    auto& x = records[i];
+                    if (x.count_ > 1) {
+                        x.val_ = x.val_ / x.count_;
+                        x.count_ = 1;
+                    }
+                }
+            },
+            sche
+        );
     }
 
 }  // namespace
@@ -75,21 +312,78 @@ namespace sung {
         ++count_;
     }
 
-    void ValArrayAnalyzer::do_array(const double* data, size_t count) {
-        this->reset();
-        for (size_t i = 0; i < count; ++i) {
-            this->notify(*(data + i));
-        }
+    void ValArrayAnalyzer::do_array(
+        const double* data, size_t count, ITaskScheduler* sche
+    ) {
+        this->do_array_impl(
+            [data](size_t i) { return data[i]; }, count, sche
+        );
     }
 
     void ValArrayAnalyzer::do_array(
-        const byte8* data, size_t count, size_t size, size_t offset
+        const float* data, size_t count, ITaskScheduler* sche
+    ) {
+        this->do_array_impl(
+            [data](size_t i) { return static_cast<double>(data[i]); },
+            count,
+            sche
+        );
+    }
+
+    void ValArrayAnalyzer::do_array(
+        const byte8* data,
+        size_t count,
+        size_t size,
+        size_t offset,
+        ITaskScheduler* sche
+    ) {
+        const auto base = data + offset;
+        this->do_array_impl(
+            [base, size](size_t i) {
+                double out;
+                std::memcpy(&out, base + i * size, sizeof(out));
+                return out;
+            },
+            count,
+            sche
+        );
+    }
+
+    template <typename TLoad>
+    void ValArrayAnalyzer::do_array_impl(
+        const TLoad& load, size_t count, ITaskScheduler* sche
     ) {
         this->reset();
-        for (size_t i = 0; i < count; ++i) {
-            const auto curr_value = *(const double*)(data + i * size + offset);
-            this->notify(curr_value);
+        if (0 == count)
+            return;
+
+        // Value 0 seeds the value range and every chunk covers [1, count)
+        const auto chunk_count = (count - 1 + REDUCE_GRAIN - 1) / REDUCE_GRAIN;
+        std::vector<::RangeStats> partials(chunk_count);
+        sung::parallel_for(
+            count - 1,
+            REDUCE_GRAIN,
+            [&](size_t begin, size_t end) {
+                partials[begin / REDUCE_GRAIN] = ::reduce_ranges(
+                    load, begin + 1, end + 1, diff_theshold_
+                );
+            },
+            sche
+        );
+
+        ::RangeStats total;
+        total.mini_ = total.maxi_ = load(0);
+        for (const auto& x : partials) total.merge(x);
+
+        value_range_.set_or_expand(total.mini_);
+        value_range_.set_or_expand(total.maxi_);
+        if (total.diff_mini_ <= total.diff_maxi_) {
+            diff_range_.set_or_expand(total.diff_mini_);
+            diff_range_.set_or_expand(total.diff_maxi_);
         }
+        last_value_ = load(count - 1);
+        last_value_set_ = true;
+        count_ = count;
     }
 
     size_t ValArrayAnalyzer::count() const { return count_; }
@@ -130,90 +424,508 @@ namespace sung {
 }  // namespace sung
 
 
+// FixedHistogram
+namespace sung {
+
+    FixedHistogram::FixedHistogram(double mini, double maxi, size_t bin_count) {
+        this->reset(mini, maxi, bin_count);
+    }
+
+    void FixedHistogram::reset(double mini, double maxi, size_t bin_count) {
+        if (0 == bin_count || !(mini < maxi)) {
+            bin_count = 0;
+            maxi = mini;
+        }
+
+        bins_.assign(bin_count, 0);
+        mini_ = mini;
+        maxi_ = maxi;
+        width_ = bin_count ? (maxi - mini) / bin_count : 0;
+        underflow_ = 0;
+        overflow_ = 0;
+    }
+
+    void FixedHistogram::clear() {
+        std::fill(bins_.begin(), bins_.end(), 0);
+        underflow_ = 0;
+        overflow_ = 0;
+    }
+
+    void FixedHistogram::notify(double value) {
+        if (std::isnan(value))
+            return;
+        if (value < mini_) {
+            ++underflow_;
+        } else if (value >= maxi_) {
+            ++overflow_;
+        } else {
+            // Rounding can land a value just under maxi past the last bin
+            const auto index = static_cast<size_t>((value - mini_) / width_);
+            ++bins_[(std::min)(index, bins_.size() - 1)];
+        }
+    }
+
+    bool FixedHistogram::merge(const FixedHistogram& other) {
+        if (bins_.size() != other.bins_.size())
+            return false;
+        if (mini_ != other.mini_ || maxi_ != other.maxi_)
+            return false;
+
+        for (size_t i = 0; i < bins_.size(); ++i) bins_[i] += other.bins_[i];
+        underflow_ += other.underflow_;
+        overflow_ += other.overflow_;
+        return true;
+    }
+
+    double FixedHistogram::bin_mini(size_t index) const {
+        return mini_ + width_ * static_cast<double>(index);
+    }
+
+    uint64_t FixedHistogram::total() const {
+        uint64_t out = underflow_ + overflow_;
+        for (const auto x : bins_) out += x;
+        return out;
+    }
+
+    double FixedHistogram::quantile(double q) const {
+        const auto target = q * static_cast<double>(this->total());
+        double cumulative = static_cast<double>(underflow_);
+        if (target <= cumulative)
+            return mini_;
+
+        for (size_t i = 0; i < bins_.size(); ++i) {
+            const auto count = static_cast<double>(bins_[i]);
+            if (count > 0 && cumulative + count >= target) {
+                const auto frac = (target - cumulative) / count;
+                return this->bin_mini(i) + frac * width_;
+            }
+            cumulative += count;
+        }
+        return maxi_;
+    }
+
+}  // namespace sung
+
+
+// QuantileSketch
+namespace sung {
+
+    QuantileSketch::QuantileSketch(size_t k)
+        : rng_state_(0x9E3779B97F4A7C15), k_((std::max<size_t>)(k, 8)) {
+        this->clear();
+    }
+
+    void QuantileSketch::clear() {
+        levels_.assign(1, {});
+        count_ = 0;
+        mini_ = 0;
+        maxi_ = 0;
+        this->update_size();
+    }
+
+    void QuantileSketch::notify(double value) {
+        if (std::isnan(value))
+            return;
+
+        if (0 == count_) {
+            mini_ = maxi_ = value;
+        } else {
+            mini_ = (std::min)(mini_, value);
+            maxi_ = (std::max)(maxi_, value);
+        }
+        ++count_;
+
+        levels_[0].push_back(value);
+        ++size_;
+        if (size_ >= max_size_)
+            this->compress();
+    }
+
+    void QuantileSketch::merge(const QuantileSketch& other) {
+        if (0 == other.count_)
+            return;
+        if (&other == this) {
+            const auto copy = other;
+            return this->merge(copy);
+        }
+
+        if (0 == count_) {
+            mini_ = other.mini_;
+            maxi_ = other.maxi_;
+        } else {
+            mini_ = (std::min)(mini_, other.mini_);
+            maxi_ = (std::max)(maxi_, other.maxi_);
+        }
+        count_ += other.count_;
+
+        if (levels_.size() < other.levels_.size())
+            levels_.resize(other.levels_.size());
+        for (size_t h = 0; h < other.levels_.size(); ++h) {
+            const auto& src = other.levels_[h];
+            levels_[h].insert(levels_[h].end(), src.begin(), src.end());
+        }
+
+        this->update_size();
+        while (size_ >= max_size_) this->compress();
+    }
+
+    double QuantileSketch::quantile(double q) const {
+        if (0 == count_ || q <= 0)
+            return mini_;
+        if (q >= 1)
+            return maxi_;
+
+        std::vector<std::pair<double, uint64_t>> items;
+        items.reserve(size_);
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            for (const auto x : levels_[h])
+                items.emplace_back(x, uint64_t(1) << h);
+        }
+        std::sort(items.begin(), items.end());
+
+        const auto target = q * static_cast<double>(count_);
+        uint64_t cumulative = 0;
+        for (const auto& x : items) {
+            cumulative += x.second;
+            if (static_cast<double>(cumulative) >= target)
+                return x.first;
+        }
+        return maxi_;
+    }
+
+    double QuantileSketch::rank(double value) const {
+        if (0 == count_)
+            return 0;
+
+        uint64_t weight = 0;
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            for (const auto x : levels_[h]) {
+                if (x <= value)
+                    weight += uint64_t(1) << h;
+            }
+        }
+        return static_cast<double>(weight) / static_cast<double>(count_);
+    }
+
+    size_t QuantileSketch::capacity(size_t level) const {
+        // Shrinks by 2/3 per level below the top one
+        const auto depth = levels_.size() - 1 - level;
+        const auto cap = std::ceil(k_ * std::pow(2.0 / 3.0, depth));
+        return (std::max<size_t>)(2, static_cast<size_t>(cap));
+    }
+
+    void QuantileSketch::update_size() {
+        size_ = 0;
+        max_size_ = 0;
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            size_ += levels_[h].size();
+            max_size_ += this->capacity(h);
+        }
+    }
+
+    // Halves the lowest full level into the one above it
+    void QuantileSketch::compress() {
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            if (levels_[h].size() < this->capacity(h))
+                continue;
+            if (h + 1 == levels_.size())
+                levels_.emplace_back();
+
+            auto& level = levels_[h];
+            auto& above = levels_[h + 1];
+            std::sort(level.begin(), level.end());
+
+            // An odd item out stays behind
+            const auto even = level.size() & ~size_t(1);
+            for (size_t i = this->next_bit() ? 1 : 0; i < even; i += 2)
+                above.push_back(level[i]);
+            if (even < level.size())
+                level[0] = level.back();
+            level.resize(level.size() - even);
+            break;
+        }
+        this->update_size();
+    }
+
+    // Xorshift, picking which half of a level survives
+    bool QuantileSketch::next_bit() {
+        rng_state_ ^= rng_state_ << 13;
+        rng_state_ ^= rng_state_ >> 7;
+        rng_state_ ^= rng_state_ << 17;
+        return rng_state_ & 1;
+    }
+
+}  // namespace sung
+
+
 // DenseDataBuilder
 namespace sung {
 
-    DenseDataBuilder::DenseDataBuilder(size_t size) : records_(size) {}
+    DenseDataBuilder::DenseDataBuilder(size_t size)
+        : memory_(size), shape_{ size } {}
 
-    bool DenseDataBuilder::empty() const { return records_.empty(); }
+    DenseDataBuilder::DenseDataBuilder(const DenseDataBuilder& other)
+        : shape_(other.shape_) {
+        const auto src = other.records();
+        memory_.assign(src, src + other.size());
+    }
+
+    DenseDataBuilder& DenseDataBuilder::operator=(
+        const DenseDataBuilder& other
+    ) {
+        if (this == &other)
+            return *this;
+
+        scratch_.close();
+        const auto src = other.records();
+        memory_.assign(src, src + other.size());
+        shape_ = other.shape_;
+        return *this;
+    }
 
-    size_t DenseDataBuilder::size() const { return records_.size(); }
+    bool DenseDataBuilder::empty() const { return 0 == this->size(); }
 
-    void DenseDataBuilder::clear() { records_.clear(); }
+    size_t DenseDataBuilder::size() const {
+        if (scratch_.is_open())
+            return scratch_.size() / sizeof(Record);
+        return memory_.size();
+    }
 
-    void DenseDataBuilder::free_mem() { records_ = {}; }
+    size_t DenseDataBuilder::dim_count() const { return shape_.size(); }
 
-    void DenseDataBuilder::resize(size_t size) { records_.resize(size); }
+    bool DenseDataBuilder::is_mapped() const { return scratch_.is_open(); }
+
+    const std::vector<size_t>& DenseDataBuilder::shape() const {
+        return shape_;
+    }
+
+    void DenseDataBuilder::clear() {
+        memory_.clear();
+        scratch_.close();
+        shape_.clear();
+    }
+
+    void DenseDataBuilder::free_mem() {
+        memory_ = {};
+        scratch_.close();
+        shape_ = {};
+    }
+
+    void DenseDataBuilder::resize(size_t size) {
+        scratch_.close();
+        memory_.resize(size);
+        shape_ = { size };
+    }
+
+    void DenseDataBuilder::resize_nd(const std::vector<size_t>& shape) {
+        scratch_.close();
+        memory_.resize(::product(shape));
+        shape_ = shape;
+    }
+
+    bool DenseDataBuilder::resize_mapped(
+        const std::vector<size_t>& shape, const std::string& scratch_path
+    ) {
+        this->free_mem();
+        size_t bytes = 0;
+        if (!::calc_bytes(shape, sizeof(Record), bytes))
+            return false;
+        if (!scratch_.create(scratch_path, bytes))
+            return false;
+
+        // Samples tend to land all over the grid, so read-ahead is wasted
+        scratch_.advise(AccessHint::random);
+        shape_ = shape;
+        return true;
+    }
 
     void DenseDataBuilder::add_val(double val, size_t idx) {
-        if (idx >= records_.size())
+        if (idx >= this->size())
             return;
-        auto& r = records_[idx];
+        auto& r = this->records()[idx];
         r.val_ += val;
         r.count_ += 1;
     }
 
-    void DenseDataBuilder::finalize_1d() {
-        if (this->empty())
+    void DenseDataBuilder::add_val_atomic(double val, size_t idx) {
+        if (idx >= this->size())
             return;
+        auto& r = this->records()[idx];
+        ::atomic_add(r.val_, val);
+        ::atomic_increment(r.count_);
+    }
 
-        // Perform divisions
-        for (auto& x : records_) {
-            if (x.count_ > 1) {
-                x.val_ = x.val_ / x.count_;
-                x.count_ = 1;
-            }
-        }
-
-        // For the case the first record is empty
-        if (0 == records_[0].count_) {
-            auto next_idx = ::find_next_non_zero(0, records_);
-            if (!next_idx)
+    void DenseDataBuilder::add_val_nd(double val, const size_t* coords) {
+        size_t idx = 0;
+        size_t stride = 1;
+        for (size_t i = 0; i < shape_.size(); ++i) {
+            if (coords[i] >= shape_[i])
                 return;
-            auto& next_r = records_[*next_idx];
-            for (size_t i = 0; i < *next_idx; ++i) {
-                records_[i] = next_r;
-            }
+            idx += coords[i] * stride;
+            stride *= shape_[i];
         }
+        this->add_val(val, idx);
+    }
 
-        // For the case the last record is empty
-        if (0 == records_.back().count_) {
-            auto prev_idx = ::find_prev_non_zero(records_.size() - 1, records_);
-            if (!prev_idx)
-                return;
-            auto& prev_r = records_[*prev_idx];
-            for (size_t i = *prev_idx + 1; i < records_.size(); ++i) {
-                records_[i] = prev_r;
-            }
+    bool DenseDataBuilder::merge(
+        const DenseDataBuilder& other, ITaskScheduler* sche
+    ) {
+        if (other.size() != this->size())
+            return false;
+
+        const auto dst = this->records();
+        const auto src = other.records();
+        parallel_for(
+            this->size(),
+            RECORD_GRAIN,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    dst[i].val_ += src[i].val_;
+                    dst[i].count_ += src[i].count_;
+                }
+            },
+            sche
+        );
+        return true;
+    }
+
+    void DenseDataBuilder::finalize_1d(ITaskScheduler* sche) {
+        if (this->empty())
+            return;
+
+        const auto records = this->records();
+        const auto size = this->size();
+        this->advise(AccessHint::sequential);
+        ::divide(records, size, sche);
+
+        const auto chunk_count = (size + FILL_CHUNK - 1) / FILL_CHUNK;
+        if (nullptr == sche || chunk_count <= 1) {
+            ::fill_line(records, size, 1);
+            return;
         }
 
-        // Fill in the gaps
-        for (size_t i = 0; i < records_.size(); ++i) {
-            if (records_[i].count_ == 0) {
-                // Since we've already handled the first and last records,
-                // this should always find a non-zero record
-                const auto next_idx = ::find_next_non_zero(i, records_);
-                const auto& next_r = records_[*next_idx];
-                const auto& prev_r = records_[i - 1];
-
-                for (size_t j = i; j < *next_idx; ++j) {
-                    const auto t = static_cast<double>(j - i + 1) /
-                                   (*next_idx - i + 1);
-                    records_[j].val_ = prev_r.val_ +
-                                       (next_r.val_ - prev_r.val_) * t;
-                    records_[j].count_ = 1;
+        // First and last sample of every chunk, so each chunk knows its
+        // neighbouring samples without scanning the others
+        std::vector<size_t> first(chunk_count, NONE);
+        std::vector<size_t> last(chunk_count, NONE);
+        parallel_for(
+            chunk_count,
+            1,
+            [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    const auto lo = c * FILL_CHUNK;
+                    const auto hi = (std::min)(lo + FILL_CHUNK, size);
+                    for (size_t i = lo; i < hi; ++i) {
+                        if (0 == records[i].count_)
+                            continue;
+                        if (NONE == first[c])
+                            first[c] = i;
+                        last[c] = i;
+                    }
                 }
+            },
+            sche
+        );
+
+        std::vector<size_t> prev(chunk_count, NONE);
+        std::vector<size_t> next(chunk_count, NONE);
+        for (size_t c = 1; c < chunk_count; ++c)
+            prev[c] = NONE != last[c - 1] ? last[c - 1] : prev[c - 1];
+        for (size_t c = chunk_count - 1; c-- > 0;)
+            next[c] = NONE != first[c + 1] ? first[c + 1] : next[c + 1];
+
+        parallel_for(
+            chunk_count,
+            1,
+            [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    const auto lo = c * FILL_CHUNK;
+                    const auto hi = (std::min)(lo + FILL_CHUNK, size);
+                    ::fill_range(records, 1, lo, hi, prev[c], next[c]);
+                }
+            },
+            sche
+        );
+    }
 
-                continue;
-            }
+    bool DenseDataBuilder::finalize_2d(ITaskScheduler* sche) {
+        if (2 != shape_.size())
+            return false;
+        this->finalize_nd(sche);
+        return true;
+    }
+
+    void DenseDataBuilder::finalize_nd(ITaskScheduler* sche) {
+        if (this->empty())
+            return;
+
+        const auto records = this->records();
+        const auto size = this->size();
+        this->advise(AccessHint::sequential);
+        ::divide(records, size, sche);
+
+        // Lines along `axis` are independent. Neighbouring lines are next to
+        // each other in memory, so a task's lines share cache lines, and
+        // tasks sweep the grid front to back.
+        size_t stride = 1;
+        for (const auto count : shape_) {
+            const auto line_count = size / count;
+            parallel_for(
+                line_count,
+                LINE_GRAIN,
+                [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        const auto inner = i % stride;
+                        const auto outer = i / stride;
+                        const auto base = outer * stride * count + inner;
+                        ::fill_line(records + base, count, stride);
+                    }
+                },
+                sche
+            );
+            stride *= count;
         }
     }
 
     void DenseDataBuilder::copy(std::vector<float>& out) const {
-        out.resize(records_.size());
-        for (size_t i = 0; i < records_.size(); ++i) {
-            out[i] = static_cast<float>(records_[i].val_);
+        const auto records = this->records();
+        out.resize(this->size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = static_cast<float>(records[i].val_);
+        }
+    }
+
+    bool DenseDataBuilder::write(AaddWriter& writer) const {
+        const auto records = this->records();
+        const auto size = this->size();
+        this->advise(AccessHint::sequential);
+
+        std::vector<double> block((std::min)(size, WRITE_BLOCK));
+        for (size_t begin = 0; begin < size; begin += block.size()) {
+            const auto count = (std::min)(block.size(), size - begin);
+            for (size_t i = 0; i < count; ++i)
+                block[i] = records[begin + i].val_;
+            if (!writer.write_values(block.data(), count))
+                return false;
         }
+        return true;
+    }
+
+    DenseDataBuilder::Record* DenseDataBuilder::records() {
+        if (scratch_.is_open())
+            return reinterpret_cast<Record*>(scratch_.data());
+        return memory_.data();
+    }
+
+    const DenseDataBuilder::Record* DenseDataBuilder::records() const {
+        if (scratch_.is_open())
+            return reinterpret_cast<const Record*>(scratch_.data());
+        return memory_.data();
+    }
+
+    void DenseDataBuilder::advise(AccessHint hint) const {
+        if (scratch_.is_open())
+            scratch_.advise(hint);
     }
 
 }  // namespace sung
@@ -300,8 +1012,22 @@ namespace sung {
         switch (type) {
             case DataType::int8:
                 return sizeof(int8_t);
+            case DataType::int16:
+                return sizeof(int16_t);
+            case DataType::int32:
+                return sizeof(int32_t);
+            case DataType::int64:
+                return sizeof(int64_t);
             case DataType::uint8:
                 return sizeof(uint8_t);
+            case DataType::uint16:
+                return sizeof(uint16_t);
+            case DataType::uint32:
+                return sizeof(uint32_t);
+            case DataType::uint64:
+                return sizeof(uint64_t);
+            case DataType::float16:
+                return sizeof(uint16_t);
             case DataType::float32:
                 return sizeof(float);
             case DataType::float64:
@@ -0,0 +1,125 @@
+#include "sung/basic/float16.hpp"
+
+#include <cstring>
+
+// GCC and Clang define __F16C__ for -mf16c or -march with it. MSVC has
+// no such macro, but every CPU with AVX2 has F16C.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+    #include <immintrin.h>
+    #define SUNG_FLOAT16_F16C
+#endif
+
+
+namespace {
+
+    uint32_t float_bits(float value) {
+        uint32_t out;
+        std::memcpy(&out, &value, sizeof(out));
+        return out;
+    }
+
+    float bits_float(uint32_t bits) {
+        float out;
+        std::memcpy(&out, &bits, sizeof(out));
+        return out;
+    }
+
+    // Shifts `value` right, rounding to nearest even
+    uint32_t shift_round_even(uint32_t value, uint32_t shift) {
+        const auto out = value >> shift;
+        const auto rem = value & ((1u << shift) - 1);
+        const auto half = 1u << (shift - 1);
+        if (rem > half || (rem == half && (out & 1)))
+            return out + 1;
+        return out;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    uint16_t float32_to_float16(float value) {
+        const auto bits = ::float_bits(value);
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const auto abs = bits & 0x7FFFFFFF;
+
+        // Inf or NaN
+        if (abs >= 0x7F800000) {
+            if (abs == 0x7F800000)
+                return sign | 0x7C00;
+            return sign | 0x7E00 | ((abs >> 13) & 0x3FF);
+        }
+        // Rounds to 65520 or more, which is past the largest finite value
+        if (abs >= 0x477FF000)
+            return sign | 0x7C00;
+        // Subnormal, 2^-25 and below round to zero
+        if (abs < 0x38800000) {
+            if (abs <= 0x33000000)
+                return sign;
+            const auto exponent = abs >> 23;
+            const auto mantissa = (abs & 0x7FFFFF) | 0x800000;
+            const auto h = ::shift_round_even(mantissa, 126 - exponent);
+            return sign | static_cast<uint16_t>(h);
+        }
+
+        // Rebias the exponent, a carry from rounding moves into it correctly
+        const auto h = ::shift_round_even(abs - 0x38000000, 13);
+        return sign | static_cast<uint16_t>(h);
+    }
+
+    float float16_to_float32(uint16_t value) {
+        const auto sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+
+        if (0x1F == exponent)
+            return ::bits_float(sign | 0x7F800000 | (mantissa << 13));
+        if (0 != exponent) {
+            const auto e = (exponent + 112) << 23;
+            return ::bits_float(sign | e | (mantissa << 13));
+        }
+        if (0 == mantissa)
+            return ::bits_float(sign);
+
+        // Normalize the subnormal
+        exponent = 113;
+        while (0 == (mantissa & 0x400)) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        mantissa &= 0x3FF;
+        return ::bits_float(sign | (exponent << 23) | (mantissa << 13));
+    }
+
+    void convert_float16_to_float32(
+        float* dst, const uint16_t* src, size_t count
+    ) {
+        size_t i = 0;
+#ifdef SUNG_FLOAT16_F16C
+        for (; i + 4 <= count; i += 4) {
+            const auto h = _mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(src + i)
+            );
+            _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+        }
+#endif
+        for (; i < count; ++i) dst[i] = float16_to_float32(src[i]);
+    }
+
+    void convert_float32_to_float16(
+        uint16_t* dst, const float* src, size_t count
+    ) {
+        size_t i = 0;
+#ifdef SUNG_FLOAT16_F16C
+        for (; i + 4 <= count; i += 4) {
+            const auto h = _mm_cvtps_ph(
+                _mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT
+            );
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), h);
+        }
+#endif
+        for (; i < count; ++i) dst[i] = float32_to_float16(src[i]);
+    }
+
+}  // namespace sung
@@ -1,6 +1,55 @@
 #include "sung/basic/geometry3d.hpp"
 
 
+namespace {
+
+    using Vec3 = sung::TVec3<double>;
+
+    // Parameter in [0, 1] of the point on segment `a`-`b` closest to `p`
+    double closest_seg_param(const Vec3& a, const Vec3& b, const Vec3& p) {
+        const auto ab = b - a;
+        const auto len_sqr = ab.dot(ab);
+        if (len_sqr <= 0)
+            return 0;
+        const auto t = (p - a).dot(ab) / len_sqr;
+        return t < 0 ? 0 : (t > 1 ? 1 : t);
+    }
+
+    // For triangles of zero area, which are a segment or a point. The
+    // closest point is on one of the edges.
+    Vec3 closest_on_edges(
+        const Vec3& a,
+        const Vec3& b,
+        const Vec3& c,
+        const Vec3& p,
+        Vec3& barycentric
+    ) {
+        const auto t_ab = ::closest_seg_param(a, b, p);
+        const auto t_ac = ::closest_seg_param(a, c, p);
+        const auto t_bc = ::closest_seg_param(b, c, p);
+        const Vec3 points[3] = {
+            a + (b - a) * t_ab,
+            a + (c - a) * t_ac,
+            b + (c - b) * t_bc,
+        };
+        const Vec3 weights[3] = {
+            Vec3{ 1 - t_ab, t_ab, 0 },
+            Vec3{ 1 - t_ac, 0, t_ac },
+            Vec3{ 0, 1 - t_bc, t_bc },
+        };
+
+        size_t best = 0;
+        for (size_t i = 1; i < 3; ++i) {
+            if (points[i].distance_sqr(p) < points[best].distance_sqr(p))
+                best = i;
+        }
+        barycentric = weights[best];
+        return points[best];
+    }
+
+}  // namespace
+
+
 // Plane3
 namespace sung {
 
@@ -143,6 +192,94 @@ namespace sung {
         return false;
     }
 
+    Triangle3::Vec3 Triangle3::find_closest_point(const Vec3& p) const {
+        Vec3 barycentric;
+        return this->find_closest_point(p, barycentric);
+    }
+
+    // Real-Time Collision Detection by Christer Ericson, section 5.1.5
+    Triangle3::Vec3 Triangle3::find_closest_point(
+        const Vec3& p, Vec3& barycentric
+    ) const {
+        const auto ab = b_ - a_;
+        const auto ac = c_ - a_;
+
+        // The regions below would divide by zero
+        const auto normal = ab.cross(ac);
+        if (0 == normal.dot(normal))
+            return ::closest_on_edges(a_, b_, c_, p, barycentric);
+
+        // Vertex region of a
+        const auto ap = p - a_;
+        const auto d1 = ab.dot(ap);
+        const auto d2 = ac.dot(ap);
+        if (d1 <= 0 && d2 <= 0) {
+            barycentric = Vec3{ 1, 0, 0 };
+            return a_;
+        }
+
+        // Vertex region of b
+        const auto bp = p - b_;
+        const auto d3 = ab.dot(bp);
+        const auto d4 = ac.dot(bp);
+        if (d3 >= 0 && d4 <= d3) {
+            barycentric = Vec3{ 0, 1, 0 };
+            return b_;
+        }
+
+        // Edge region of ab
+        const auto vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+            const auto v = d1 / (d1 - d3);
+            barycentric = Vec3{ 1 - v, v, 0 };
+            return a_ + ab * v;
+        }
+
+        // Vertex region of c
+        const auto cp = p - c_;
+        const auto d5 = ab.dot(cp);
+        const auto d6 = ac.dot(cp);
+        if (d6 >= 0 && d5 <= d6) {
+            barycentric = Vec3{ 0, 0, 1 };
+            return c_;
+        }
+
+        // Edge region of ac
+        const auto vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+            const auto w = d2 / (d2 - d6);
+            barycentric = Vec3{ 1 - w, 0, w };
+            return a_ + ac * w;
+        }
+
+        // Edge region of bc
+        const auto va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+            const auto w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            barycentric = Vec3{ 0, 1 - w, w };
+            return b_ + (c_ - b_) * w;
+        }
+
+        // Inside the face. The sum is the squared length of the normal, which
+        // can still underflow for tiny triangles.
+        const auto sum = va + vb + vc;
+        if (!(sum > 0))
+            return ::closest_on_edges(a_, b_, c_, p, barycentric);
+        const auto denom = 1.0 / sum;
+        const auto v = vb * denom;
+        const auto w = vc * denom;
+        barycentric = Vec3{ 1 - v - w, v, w };
+        return a_ + ab * v + ac * w;
+    }
+
+    double Triangle3::calc_dist_sqr(const Vec3& p) const {
+        return this->find_closest_point(p).distance_sqr(p);
+    }
+
+    double Triangle3::calc_dist(const Vec3& p) const {
+        return std::sqrt(this->calc_dist_sqr(p));
+    }
+
 }  // namespace sung
 
 
@@ -0,0 +1,563 @@
+#include "sung/basic/img_convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "sung/basic/float16.hpp"
+#include "sung/basic/mamath.hpp"
+
+#include "img_internal.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SUNG_IMG_CONVERT_SSE2
+#endif
+
+
+namespace {
+
+    using sung::byte8;
+    using sung::ChannelSwizzle;
+    using sung::PixelFormat;
+    using sung::PixelScalar;
+    using sung::internal::is_alpha;
+    using sung::internal::linear_to_srgb;
+    using sung::internal::srgb_to_linear;
+
+    constexpr size_t ROW_GRAIN = 16;
+    constexpr size_t MAX_CHANNELS = 4;
+    constexpr float INV_255 = 1.f / 255.f;
+    constexpr float INV_65535 = 1.f / 65535.f;
+
+
+    /*
+    Encoding to 8-bit sRGB is exact by comparing against the linear values
+    halfway between neighboring codes. A coarse table indexed by the linear
+    value gives a starting code, which is at most a couple of steps away.
+    */
+    class Srgb8Tables {
+
+    public:
+        static const Srgb8Tables& get() {
+            static const Srgb8Tables tables;
+            return tables;
+        }
+
+        float decode(uint8_t v) const { return decode_[v]; }
+
+        uint8_t encode(float l) const {
+            if (!(l > 0))
+                return 0;
+            if (l >= 1)
+                return 255;
+
+            const auto idx = static_cast<size_t>(l * COARSE_SIZE);
+            auto code = coarse_[idx];
+            while (code < 255 && l >= thresholds_[code]) ++code;
+            return code;
+        }
+
+    private:
+        static constexpr size_t COARSE_SIZE = 4096;
+
+        Srgb8Tables() {
+            for (size_t i = 0; i < 256; ++i) {
+                const auto f = static_cast<float>(i) * INV_255;
+                decode_[i] = ::srgb_to_linear(f);
+            }
+            for (size_t i = 0; i < 255; ++i) {
+                const auto mid = (static_cast<float>(i) + 0.5f) * INV_255;
+                thresholds_[i] = ::srgb_to_linear(mid);
+            }
+
+            uint8_t code = 0;
+            for (size_t i = 0; i <= COARSE_SIZE; ++i) {
+                const auto l = static_cast<float>(i) / COARSE_SIZE;
+                while (code < 255 && l >= thresholds_[code]) ++code;
+                coarse_[i] = code;
+            }
+        }
+
+        float decode_[256];
+        float thresholds_[255];
+        uint8_t coarse_[COARSE_SIZE + 1];
+    };
+
+
+    void decode_unorm8(float* out, const uint8_t* src, size_t count) {
+        size_t i = 0;
+#ifdef SUNG_IMG_CONVERT_SSE2
+        const auto zero = _mm_setzero_si128();
+        const auto scale = _mm_set1_ps(INV_255);
+        for (; i + 16 <= count; i += 16) {
+            const auto v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i)
+            );
+            const auto lo = _mm_unpacklo_epi8(v, zero);
+            const auto hi = _mm_unpackhi_epi8(v, zero);
+            const __m128i parts[4] = {
+                _mm_unpacklo_epi16(lo, zero),
+                _mm_unpackhi_epi16(lo, zero),
+                _mm_unpacklo_epi16(hi, zero),
+                _mm_unpackhi_epi16(hi, zero),
+            };
+            for (size_t j = 0; j < 4; ++j) {
+                const auto f = _mm_cvtepi32_ps(parts[j]);
+                _mm_storeu_ps(out + i + j * 4, _mm_mul_ps(f, scale));
+            }
+        }
+#endif
+        for (; i < count; ++i) out[i] = src[i] * INV_255;
+    }
+
+    void encode_unorm8(uint8_t* out, const float* src, size_t count) {
+        size_t i = 0;
+#ifdef SUNG_IMG_CONVERT_SSE2
+        const auto scale = _mm_set1_ps(255.f);
+        const auto lo = _mm_setzero_ps();
+        const auto hi = _mm_set1_ps(255.f);
+        for (; i + 16 <= count; i += 16) {
+            __m128i parts[4];
+            for (size_t j = 0; j < 4; ++j) {
+                auto f = _mm_mul_ps(_mm_loadu_ps(src + i + j * 4), scale);
+                f = _mm_min_ps(_mm_max_ps(f, lo), hi);
+                // Rounds to nearest even like std::nearbyint
+                parts[j] = _mm_cvtps_epi32(f);
+            }
+            const auto a = _mm_packs_epi32(parts[0], parts[1]);
+            const auto b = _mm_packs_epi32(parts[2], parts[3]);
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b)
+            );
+        }
+#endif
+        for (; i < count; ++i) {
+            const auto f = sung::clamp<float>(src[i] * 255.f, 0, 255);
+            out[i] = static_cast<uint8_t>(std::nearbyint(f));
+        }
+    }
+
+    // Applies `func` to the color channels, skipping alpha
+    template <typename Func>
+    void map_colors(float* data, size_t pixels, size_t channels, Func func) {
+        for (size_t c = 0; c < channels; ++c) {
+            if (::is_alpha(c, channels))
+                continue;
+            for (size_t i = 0; i < pixels; ++i) {
+                auto& v = data[i * channels + c];
+                v = func(v);
+            }
+        }
+    }
+
+
+    class RowConverter {
+
+    public:
+        RowConverter(
+            const PixelFormat& dst_format,
+            size_t dst_channels,
+            const PixelFormat& src_format,
+            size_t src_channels,
+            const ChannelSwizzle& swizzle,
+            size_t pixels
+        )
+            : swizzle_(swizzle)
+            , dst_format_(dst_format)
+            , src_format_(src_format)
+            , dst_channels_(dst_channels)
+            , src_channels_(src_channels)
+            , pixels_(pixels) {
+            same_format_ = dst_format.scalar_ == src_format.scalar_ &&
+                           dst_format.srgb_ == src_format.srgb_;
+
+            identity_ = dst_channels == src_channels;
+            for (size_t c = 0; c < dst_channels; ++c) {
+                if (swizzle.src_[c] != static_cast<int>(c))
+                    identity_ = false;
+            }
+        }
+
+        size_t buffer_size() const { return pixels_ * MAX_CHANNELS; }
+
+        // `a` and `b` need `buffer_size()` floats. The whole source row is
+        // read before writing, and pixels are done in order, so it works in
+        // place as long as the destination pixels are not larger.
+        void convert(byte8* dst, const byte8* src, float* a, float* b) const {
+            if (same_format_) {
+                this->shuffle_row(dst, src);
+                return;
+            }
+
+            this->decode_row(a, src);
+            if (!identity_) {
+                this->swizzle_row(b, a);
+                std::swap(a, b);
+            }
+            this->encode_row(dst, a);
+        }
+
+    private:
+        void shuffle_row(byte8* dst, const byte8* src) const {
+            switch (src_format_.scalar_) {
+                case PixelScalar::unorm8:
+                    return this->shuffle_pixels<uint8_t>(dst, src, 255);
+                case PixelScalar::unorm16:
+                    return this->shuffle_pixels<uint16_t>(dst, src, 65535);
+                case PixelScalar::float16:
+                    return this->shuffle_pixels<uint16_t>(dst, src, 0x3C00);
+                case PixelScalar::float32:
+                    return this->shuffle_pixels<float>(dst, src, 1);
+            }
+        }
+
+        template <typename T>
+        void shuffle_pixels(byte8* dst, const byte8* src, T one) const {
+            if (identity_) {
+                const auto bytes = pixels_ * src_channels_ * sizeof(T);
+                if (dst != src)
+                    std::memmove(dst, src, bytes);
+                return;
+            }
+
+            auto out = reinterpret_cast<T*>(dst);
+            auto in = reinterpret_cast<const T*>(src);
+            for (size_t i = 0; i < pixels_; ++i) {
+                T pixel[MAX_CHANNELS];
+                for (size_t c = 0; c < src_channels_; ++c) pixel[c] = in[c];
+                for (size_t c = 0; c < dst_channels_; ++c) {
+                    const auto s = swizzle_.src_[c];
+                    if (s >= 0)
+                        out[c] = pixel[s];
+                    else if (ChannelSwizzle::SWIZZLE_ONE == s)
+                        out[c] = one;
+                    else
+                        out[c] = T{ 0 };
+                }
+                in += src_channels_;
+                out += dst_channels_;
+            }
+        }
+
+        void swizzle_row(float* dst, const float* src) const {
+            for (size_t i = 0; i < pixels_; ++i) {
+                const auto in = src + i * src_channels_;
+                auto out = dst + i * dst_channels_;
+                for (size_t c = 0; c < dst_channels_; ++c) {
+                    const auto s = swizzle_.src_[c];
+                    if (s >= 0)
+                        out[c] = in[s];
+                    else
+                        out[c] = ChannelSwizzle::SWIZZLE_ONE == s ? 1 : 0;
+                }
+            }
+        }
+
+        void decode_row(float* out, const byte8* src) const {
+            const auto ch = src_channels_;
+            const auto count = pixels_ * ch;
+            const auto srgb = src_format_.srgb_;
+
+            switch (src_format_.scalar_) {
+                case PixelScalar::unorm8: {
+                    const auto in = reinterpret_cast<const uint8_t*>(src);
+                    if (!srgb)
+                        return ::decode_unorm8(out, in, count);
+
+                    const auto& tables = Srgb8Tables::get();
+                    for (size_t i = 0; i < count; i += ch) {
+                        for (size_t c = 0; c < ch; ++c) {
+                            const auto v = in[i + c];
+                            out[i + c] = ::is_alpha(c, ch) ? v * INV_255
+                                                           : tables.decode(v);
+                        }
+                    }
+                    return;
+                }
+                case PixelScalar::unorm16: {
+                    const auto in = reinterpret_cast<const uint16_t*>(src);
+                    for (size_t i = 0; i < count; ++i)
+                        out[i] = in[i] * INV_65535;
+                    break;
+                }
+                case PixelScalar::float16: {
+                    const auto in = reinterpret_cast<const uint16_t*>(src);
+                    sung::convert_float16_to_float32(out, in, count);
+                    break;
+                }
+                case PixelScalar::float32:
+                    std::memmove(out, src, count * sizeof(float));
+                    break;
+            }
+
+            if (srgb)
+                ::map_colors(out, pixels_, ch, ::srgb_to_linear);
+        }
+
+        // Clobbers `src` when encoding sRGB
+        void encode_row(byte8* dst, float* src) const {
+            const auto ch = dst_channels_;
+            const auto count = pixels_ * ch;
+            const auto srgb = dst_format_.srgb_;
+
+            if (PixelScalar::unorm8 == dst_format_.scalar_) {
+                const auto out = reinterpret_cast<uint8_t*>(dst);
+                if (!srgb)
+                    return ::encode_unorm8(out, src, count);
+
+                const auto& tables = Srgb8Tables::get();
+                for (size_t i = 0; i < count; i += ch) {
+                    for (size_t c = 0; c < ch; ++c) {
+                        const auto v = src[i + c];
+                        if (::is_alpha(c, ch))
+                            ::encode_unorm8(out + i + c, &v, 1);
+                        else
+                            out[i + c] = tables.encode(v);
+                    }
+                }
+                return;
+            }
+
+            if (srgb)
+                ::map_colors(src, pixels_, ch, ::linear_to_srgb);
+
+            switch (dst_format_.scalar_) {
+                case PixelScalar::unorm8:
+                    break;
+                case PixelScalar::unorm16: {
+                    const auto out = reinterpret_cast<uint16_t*>(dst);
+                    for (size_t i = 0; i < count; ++i) {
+                        const auto f = sung::clamp<float>(
+                            src[i] * 65535.f, 0, 65535
+                        );
+                        out[i] = static_cast<uint16_t>(std::nearbyint(f));
+                    }
+                    break;
+                }
+                case PixelScalar::float16: {
+                    const auto out = reinterpret_cast<uint16_t*>(dst);
+                    sung::convert_float32_to_float16(out, src, count);
+                    break;
+                }
+                case PixelScalar::float32:
+                    std::memmove(dst, src, count * sizeof(float));
+                    break;
+            }
+        }
+
+        ChannelSwizzle swizzle_;
+        PixelFormat dst_format_;
+        PixelFormat src_format_;
+        size_t dst_channels_;
+        size_t src_channels_;
+        size_t pixels_;
+        bool same_format_ = false;
+        bool identity_ = false;
+    };
+
+
+    bool check_channels(size_t channels) {
+        return channels >= 1 && channels <= MAX_CHANNELS;
+    }
+
+    bool check_swizzle(
+        const ChannelSwizzle& swizzle, size_t src_channels, size_t dst_channels
+    ) {
+        for (size_t c = 0; c < dst_channels; ++c) {
+            const auto s = swizzle.src_[c];
+            if (s >= static_cast<int>(src_channels))
+                return false;
+            if (s < 0 && s != ChannelSwizzle::SWIZZLE_ZERO &&
+                s != ChannelSwizzle::SWIZZLE_ONE)
+                return false;
+        }
+        return true;
+    }
+
+    bool check_image(const sung::Image2D& img, const PixelFormat& format) {
+        if (!::check_channels(img.channels()))
+            return false;
+        if (img.scalar_bytes() != sung::get_scalar_bytes(format.scalar_))
+            return false;
+        if (img.data_.size() < img.size_bytes())
+            return false;
+        return true;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    size_t get_scalar_bytes(PixelScalar scalar) {
+        switch (scalar) {
+            case PixelScalar::unorm8:
+                return 1;
+            case PixelScalar::unorm16:
+            case PixelScalar::float16:
+                return 2;
+            case PixelScalar::float32:
+                return 4;
+        }
+        return 0;
+    }
+
+
+    constexpr int ChannelSwizzle::SWIZZLE_ZERO;
+    constexpr int ChannelSwizzle::SWIZZLE_ONE;
+
+    ChannelSwizzle ChannelSwizzle::make_default(
+        size_t src_channels, size_t dst_channels
+    ) {
+        ChannelSwizzle out;
+        for (size_t c = 0; c < MAX_CHANNELS; ++c) {
+            const auto dst_alpha = ::is_alpha(c, dst_channels);
+            const auto src_alpha = src_channels == 2 || src_channels == 4;
+            if (dst_alpha) {
+                out.src_[c] = src_alpha ? static_cast<int>(src_channels - 1)
+                                        : SWIZZLE_ONE;
+            } else if (src_channels <= 2) {
+                // Gray
+                out.src_[c] = 0;
+            } else if (c < 3) {
+                out.src_[c] = static_cast<int>(c);
+            } else {
+                out.src_[c] = SWIZZLE_ZERO;
+            }
+        }
+        return out;
+    }
+
+    ChannelSwizzle ChannelSwizzle::make_swap_rb() {
+        ChannelSwizzle out;
+        out.src_ = { 2, 1, 0, 3 };
+        return out;
+    }
+
+
+    bool convert_image(
+        Image2D& dst,
+        const PixelFormat& dst_format,
+        const Image2D& src,
+        const PixelFormat& src_format,
+        const ChannelSwizzle& swizzle,
+        ITaskScheduler* sche
+    ) {
+        if (!::check_image(src, src_format))
+            return false;
+        if (!::check_image(dst, dst_format))
+            return false;
+        if (dst.x_size() != src.x_size() || dst.y_size() != src.y_size())
+            return false;
+        if (!::check_swizzle(swizzle, src.channels(), dst.channels()))
+            return false;
+
+        const ::RowConverter conv(
+            dst_format,
+            dst.channels(),
+            src_format,
+            src.channels(),
+            swizzle,
+            src.x_size()
+        );
+
+        parallel_for(
+            src.y_size(),
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                std::vector<float> a(conv.buffer_size());
+                std::vector<float> b(conv.buffer_size());
+                for (size_t y = begin; y < end; ++y) {
+                    const auto out = dst.pixel_ptr(0, y);
+                    const auto in = src.pixel_ptr(0, y);
+                    conv.convert(out, in, a.data(), b.data());
+                }
+            },
+            sche
+        );
+        return true;
+    }
+
+    bool convert_image(
+        Image2D& dst,
+        const PixelFormat& dst_format,
+        size_t dst_channels,
+        const Image2D& src,
+        const PixelFormat& src_format,
+        ITaskScheduler* sche
+    ) {
+        dst.set_metadata(
+            get_scalar_bytes(dst_format.scalar_),
+            dst_channels,
+            src.x_size(),
+            src.y_size()
+        );
+        dst.resize_data_to_fit();
+
+        const auto swizzle = ChannelSwizzle::make_default(
+            src.channels(), dst_channels
+        );
+        return convert_image(
+            dst, dst_format, src, src_format, swizzle, sche
+        );
+    }
+
+    bool convert_image_inplace(
+        Image2D& img,
+        const PixelFormat& dst_format,
+        size_t dst_channels,
+        const PixelFormat& src_format,
+        const ChannelSwizzle& swizzle,
+        ITaskScheduler* sche
+    ) {
+        if (!::check_image(img, src_format))
+            return false;
+        if (!::check_channels(dst_channels))
+            return false;
+        if (!::check_swizzle(swizzle, img.channels(), dst_channels))
+            return false;
+
+        const auto scalar_bytes = get_scalar_bytes(dst_format.scalar_);
+        const auto pixel_bytes = scalar_bytes * dst_channels;
+        if (pixel_bytes > img.pixel_bytes())
+            return false;
+
+        const ::RowConverter conv(
+            dst_format,
+            dst_channels,
+            src_format,
+            img.channels(),
+            swizzle,
+            img.x_size()
+        );
+
+        // A shrinking row overlaps the next source row unless done in order
+        const auto src_row = img.row_bytes();
+        const auto dst_row = pixel_bytes * img.x_size();
+        const auto base = img.data_.data();
+        parallel_for(
+            img.y_size(),
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                std::vector<float> a(conv.buffer_size());
+                std::vector<float> b(conv.buffer_size());
+                for (size_t y = begin; y < end; ++y) {
+                    const auto out = base + y * dst_row;
+                    const auto in = base + y * src_row;
+                    conv.convert(out, in, a.data(), b.data());
+                }
+            },
+            dst_row == src_row ? sche : nullptr
+        );
+
+        img.set_metadata(
+            scalar_bytes, dst_channels, img.x_size(), img.y_size()
+        );
+        img.data_.resize(img.size_bytes());
+        return true;
+    }
+
+}  // namespace sung
@@ -0,0 +1,323 @@
+#include "sung/basic/img_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "sung/basic/mamath.hpp"
+
+#include "img_internal.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SUNG_IMG_FILTER_SSE2
+#endif
+
+
+namespace {
+
+    constexpr size_t ROW_GRAIN = 16;
+
+
+    // acc[i] += w * row[i]
+    void axpy(float* acc, const float* row, float w, size_t count) {
+        size_t i = 0;
+#ifdef SUNG_IMG_FILTER_SSE2
+        const auto wv = _mm_set1_ps(w);
+        for (; i + 4 <= count; i += 4) {
+            const auto prod = _mm_mul_ps(_mm_loadu_ps(row + i), wv);
+            _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), prod));
+        }
+#endif
+        for (; i < count; ++i) acc[i] += w * row[i];
+    }
+
+    // acc[i] += add[i] - sub[i], with `sub` optional
+    void slide(double* acc, const float* add, const float* sub, size_t count) {
+        if (nullptr == sub) {
+            for (size_t i = 0; i < count; ++i) acc[i] += add[i];
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+            acc[i] += static_cast<double>(add[i]) - sub[i];
+    }
+
+
+    /*
+    Source rows converted to float with `radius` clamped pixels on both
+    sides, so the horizontal passes need no bound checks.
+    */
+    class PaddedRow {
+
+    public:
+        PaddedRow(size_t x, size_t channels, size_t radius)
+            : data_((x + 2 * radius) * channels)
+            , x_(x)
+            , channels_(channels)
+            , radius_(radius) {}
+
+        template <typename T>
+        void load(const T* src) {
+            const auto ch = channels_;
+            auto out = data_.data();
+            for (size_t i = 0; i < radius_; ++i, out += ch)
+                std::copy(src, src + ch, out);
+            for (size_t i = 0; i < x_ * ch; ++i) out[i] = src[i];
+            out += x_ * ch;
+            const auto last = src + (x_ - 1) * ch;
+            for (size_t i = 0; i < radius_; ++i, out += ch)
+                std::copy(last, last + ch, out);
+        }
+
+        const float* data() const { return data_.data(); }
+
+    private:
+        std::vector<float> data_;
+        size_t x_;
+        size_t channels_;
+        size_t radius_;
+    };
+
+
+    /*
+    Runs `horizontal(out_row, padded_row)` for every source row into a float
+    buffer, with rows padded by `radius` pixels. Then for every band,
+    `vertical(tmp, begin, end, acc, store)` fills `acc` for each output row
+    and calls `store(y)` to write it to `dst`.
+    */
+    template <typename T, typename HFunc, typename VFunc>
+    void run_separable(
+        sung::Image2D& dst,
+        const sung::TImageView2D<T>& src,
+        size_t radius,
+        HFunc&& horizontal,
+        VFunc&& vertical,
+        sung::ITaskScheduler* sche
+    ) {
+        const auto x = src.x_size();
+        const auto y = src.y_size();
+        const auto ch = src.channels();
+        const auto row_len = x * ch;
+
+        std::vector<float> tmp(y * row_len);
+        sung::parallel_for(
+            y,
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                ::PaddedRow padded(x, ch, radius);
+                for (size_t i = begin; i < end; ++i) {
+                    padded.load(src.pixel_ptr(0, i));
+                    horizontal(tmp.data() + i * row_len, padded.data());
+                }
+            },
+            sche
+        );
+
+        sung::parallel_for(
+            y,
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                std::vector<float> acc(row_len);
+                const auto store = [&](size_t i) {
+                    auto out = dst.pixel_ptr<T>(0, i);
+                    for (size_t j = 0; j < row_len; ++j)
+                        out[j] = sung::internal::to_scalar<T>(acc[j]);
+                };
+                vertical(tmp.data(), begin, end, acc.data(), store);
+            },
+            sche
+        );
+    }
+
+    template <typename T>
+    bool prepare_dst(sung::Image2D& dst, const sung::TImageView2D<T>& src) {
+        if (0 == src.x_size() || 0 == src.y_size() || 0 == src.channels())
+            return false;
+        dst.set_metadata<T>(src.channels(), src.x_size(), src.y_size());
+        dst.resize_data_to_fit();
+        return true;
+    }
+
+    bool check_kernel(const std::vector<float>& kernel) {
+        return 1 == kernel.size() % 2;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    std::vector<float> make_gaussian_kernel(double sigma, size_t radius) {
+        if (!(sigma > 0))
+            return { 1 };
+        if (0 == radius)
+            radius = static_cast<size_t>(std::ceil(3 * sigma));
+
+        std::vector<float> out(2 * radius + 1);
+        double sum = 0;
+        for (size_t i = 0; i < out.size(); ++i) {
+            const auto d = static_cast<double>(i) - static_cast<double>(radius);
+            const auto w = std::exp(-d * d / (2 * sigma * sigma));
+            out[i] = static_cast<float>(w);
+            sum += w;
+        }
+        for (auto& w : out) w = static_cast<float>(w / sum);
+        return out;
+    }
+
+
+    template <typename T>
+    bool convolve_separable(
+        Image2D& dst,
+        const TImageView2D<T>& src,
+        const std::vector<float>& kernel_x,
+        const std::vector<float>& kernel_y,
+        ITaskScheduler* sche
+    ) {
+        if (!::check_kernel(kernel_x) || !::check_kernel(kernel_y))
+            return false;
+        if (!::prepare_dst(dst, src))
+            return false;
+
+        const auto ch = src.channels();
+        const auto x = src.x_size();
+        const auto y = src.y_size();
+        const auto row_len = x * ch;
+        const auto rx = kernel_x.size() / 2;
+        const auto ry = kernel_y.size() / 2;
+
+        const auto horizontal = [&](float* out, const float* padded) {
+            // Every output scalar reads the same tap of its own channel, so
+            // the flat row is filtered as if it had one channel
+            std::fill(out, out + row_len, 0.f);
+            for (size_t t = 0; t < kernel_x.size(); ++t)
+                ::axpy(out, padded + t * ch, kernel_x[t], row_len);
+        };
+
+        const auto vertical = [&](const float* tmp,
+                                  size_t begin,
+                                  size_t end,
+                                  float* acc,
+                                  auto&& store) {
+            for (size_t i = begin; i < end; ++i) {
+                std::fill(acc, acc + row_len, 0.f);
+                for (size_t t = 0; t < kernel_y.size(); ++t) {
+                    const auto sy = sung::clamp<ptrdiff_t>(
+                        static_cast<ptrdiff_t>(i + t) -
+                            static_cast<ptrdiff_t>(ry),
+                        0,
+                        static_cast<ptrdiff_t>(y) - 1
+                    );
+                    ::axpy(acc, tmp + sy * row_len, kernel_y[t], row_len);
+                }
+                store(i);
+            }
+        };
+
+        ::run_separable(dst, src, rx, horizontal, vertical, sche);
+        return true;
+    }
+
+    template <typename T>
+    bool box_blur(
+        Image2D& dst,
+        const TImageView2D<T>& src,
+        size_t radius_x,
+        size_t radius_y,
+        ITaskScheduler* sche
+    ) {
+        if (!::prepare_dst(dst, src))
+            return false;
+
+        const auto ch = src.channels();
+        const auto x = src.x_size();
+        const auto y = src.y_size();
+        const auto row_len = x * ch;
+        const auto width_x = 2 * radius_x + 1;
+        const auto width_y = 2 * radius_y + 1;
+        const auto scale = 1.0 / static_cast<double>(width_x * width_y);
+
+        const auto horizontal = [&](float* out, const float* p) {
+            // First pixel of each channel directly, then slide the window.
+            // The running sum is kept in double so rounding does not build
+            // up along the row.
+            const auto span = width_x * ch;
+            for (size_t c = 0; c < ch; ++c) {
+                double sum = 0;
+                for (size_t t = 0; t < width_x; ++t) sum += p[t * ch + c];
+                out[c] = static_cast<float>(sum);
+                for (size_t i = c + ch; i < row_len; i += ch) {
+                    sum += static_cast<double>(p[i - ch + span]) - p[i - ch];
+                    out[i] = static_cast<float>(sum);
+                }
+            }
+        };
+
+        const auto vertical = [&](const float* tmp,
+                                  size_t begin,
+                                  size_t end,
+                                  float* acc,
+                                  auto&& store) {
+            const auto row = [&](ptrdiff_t i) {
+                const auto last = static_cast<ptrdiff_t>(y) - 1;
+                return tmp + sung::clamp<ptrdiff_t>(i, 0, last) * row_len;
+            };
+            const auto ry = static_cast<ptrdiff_t>(radius_y);
+
+            // Each band starts its own window, summed in double like the
+            // horizontal pass
+            std::vector<double> sum(row_len, 0);
+            const auto first = static_cast<ptrdiff_t>(begin);
+            for (ptrdiff_t t = first - ry; t <= first + ry; ++t)
+                ::slide(sum.data(), row(t), nullptr, row_len);
+
+            for (size_t i = begin; i < end; ++i) {
+                const auto yi = static_cast<ptrdiff_t>(i);
+                if (i != begin) {
+                    const auto add = row(yi + ry);
+                    ::slide(sum.data(), add, row(yi - ry - 1), row_len);
+                }
+                for (size_t j = 0; j < row_len; ++j)
+                    acc[j] = static_cast<float>(sum[j] * scale);
+                store(i);
+            }
+        };
+
+        ::run_separable(dst, src, radius_x, horizontal, vertical, sche);
+        return true;
+    }
+
+
+    template bool convolve_separable<uint8_t>(
+        Image2D&,
+        const TImageView2D<uint8_t>&,
+        const std::vector<float>&,
+        const std::vector<float>&,
+        ITaskScheduler*
+    );
+    template bool convolve_separable<uint16_t>(
+        Image2D&,
+        const TImageView2D<uint16_t>&,
+        const std::vector<float>&,
+        const std::vector<float>&,
+        ITaskScheduler*
+    );
+    template bool convolve_separable<float>(
+        Image2D&,
+        const TImageView2D<float>&,
+        const std::vector<float>&,
+        const std::vector<float>&,
+        ITaskScheduler*
+    );
+
+    template bool box_blur<uint8_t>(
+        Image2D&, const TImageView2D<uint8_t>&, size_t, size_t, ITaskScheduler*
+    );
+    template bool box_blur<uint16_t>(
+        Image2D&, const TImageView2D<uint16_t>&, size_t, size_t, ITaskScheduler*
+    );
+    template bool box_blur<float>(
+        Image2D&, const TImageView2D<float>&, size_t, size_t, ITaskScheduler*
+    );
+
+}  // namespace sung
@@ -0,0 +1,168 @@
+#include "sung/basic/img_integral.hpp"
+
+#include <algorithm>
+
+#include "sung/basic/mamath.hpp"
+
+
+namespace {
+
+    constexpr size_t ROW_GRAIN = 16;
+    // Scalars per band in the column pass, a few cache lines of doubles
+    constexpr size_t COLUMN_GRAIN = 256;
+
+}  // namespace
+
+
+namespace sung {
+
+    template <typename Acc>
+    template <typename T>
+    bool TSummedAreaTable<Acc>::build(
+        const TImageView2D<T>& src, ITaskScheduler* sche
+    ) {
+        this->clear();
+        if (0 == src.x_size() || 0 == src.y_size() || 0 == src.channels())
+            return false;
+
+        channels_ = src.channels();
+        x_ = src.x_size();
+        y_ = src.y_size();
+        const auto ch = channels_;
+        const auto stride = (x_ + 1) * ch;
+        // Row and column 0 stay zero
+        data_.assign((y_ + 1) * stride, Acc{ 0 });
+
+        // Prefix sums along each row
+        parallel_for(
+            y_,
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; ++y) {
+                    const auto in = src.pixel_ptr(0, y);
+                    auto out = data_.data() + (y + 1) * stride + ch;
+                    for (size_t c = 0; c < ch; ++c)
+                        out[c] = static_cast<Acc>(in[c]);
+                    for (size_t i = ch; i < x_ * ch; ++i)
+                        out[i] = out[i - ch] + static_cast<Acc>(in[i]);
+                }
+            },
+            sche
+        );
+
+        // Then down the columns, each band of columns on its own. Whole
+        // row slices are added so the inner loop vectorizes.
+        parallel_for(
+            stride,
+            COLUMN_GRAIN,
+            [&](size_t begin, size_t end) {
+                for (size_t y = 2; y <= y_; ++y) {
+                    const auto above = data_.data() + (y - 1) * stride;
+                    auto row = data_.data() + y * stride;
+                    for (size_t i = begin; i < end; ++i) row[i] += above[i];
+                }
+            },
+            sche
+        );
+
+        return true;
+    }
+
+    template <typename Acc>
+    void TSummedAreaTable<Acc>::clear() {
+        data_.clear();
+        channels_ = 0;
+        x_ = 0;
+        y_ = 0;
+    }
+
+    template <typename Acc>
+    bool TSummedAreaTable<Acc>::empty() const {
+        return data_.empty();
+    }
+
+    template <typename Acc>
+    Acc TSummedAreaTable<Acc>::sum(const PixelRegion& region, size_t channel)
+        const {
+        size_t r[4];
+        if (!this->clip(region, r))
+            return Acc{ 0 };
+
+        return this->prefix(r[1], r[3], channel) -
+               this->prefix(r[0], r[3], channel) -
+               this->prefix(r[1], r[2], channel) +
+               this->prefix(r[0], r[2], channel);
+    }
+
+    template <typename Acc>
+    void TSummedAreaTable<Acc>::sum(Acc* out, const PixelRegion& region)
+        const {
+        size_t r[4];
+        if (!this->clip(region, r)) {
+            std::fill(out, out + channels_, Acc{ 0 });
+            return;
+        }
+
+        const auto stride = (x_ + 1) * channels_;
+        const auto a = data_.data() + r[2] * stride + r[0] * channels_;
+        const auto b = data_.data() + r[2] * stride + r[1] * channels_;
+        const auto c = data_.data() + r[3] * stride + r[0] * channels_;
+        const auto d = data_.data() + r[3] * stride + r[1] * channels_;
+        for (size_t i = 0; i < channels_; ++i)
+            out[i] = d[i] - c[i] - b[i] + a[i];
+    }
+
+    template <typename Acc>
+    double TSummedAreaTable<Acc>::mean(
+        const PixelRegion& region, size_t channel
+    ) const {
+        size_t r[4];
+        if (!this->clip(region, r))
+            return 0;
+
+        const auto count = (r[1] - r[0]) * (r[3] - r[2]);
+        const auto total = this->sum(region, channel);
+        return static_cast<double>(total) / static_cast<double>(count);
+    }
+
+    template <typename Acc>
+    bool TSummedAreaTable<Acc>::clip(
+        const PixelRegion& region, size_t (&out)[4]
+    ) const {
+        const auto x = static_cast<int64_t>(x_);
+        const auto y = static_cast<int64_t>(y_);
+        const auto x0 = sung::clamp<int64_t>(region.x_min(), 0, x);
+        const auto x1 = sung::clamp<int64_t>(region.x_max(), 0, x);
+        const auto y0 = sung::clamp<int64_t>(region.y_min(), 0, y);
+        const auto y1 = sung::clamp<int64_t>(region.y_max(), 0, y);
+        if (x0 >= x1 || y0 >= y1)
+            return false;
+
+        out[0] = static_cast<size_t>(x0);
+        out[1] = static_cast<size_t>(x1);
+        out[2] = static_cast<size_t>(y0);
+        out[3] = static_cast<size_t>(y1);
+        return true;
+    }
+
+
+    template class TSummedAreaTable<int64_t>;
+    template class TSummedAreaTable<double>;
+
+    template bool TSummedAreaTable<int64_t>::build<uint8_t>(
+        const TImageView2D<uint8_t>&, ITaskScheduler*
+    );
+    template bool TSummedAreaTable<int64_t>::build<uint16_t>(
+        const TImageView2D<uint16_t>&, ITaskScheduler*
+    );
+    template bool TSummedAreaTable<double>::build<uint8_t>(
+        const TImageView2D<uint8_t>&, ITaskScheduler*
+    );
+    template bool TSummedAreaTable<double>::build<uint16_t>(
+        const TImageView2D<uint16_t>&, ITaskScheduler*
+    );
+    template bool TSummedAreaTable<double>::build<float>(
+        const TImageView2D<float>&, ITaskScheduler*
+    );
+
+}  // namespace sung
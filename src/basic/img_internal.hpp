@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "sung/basic/mamath.hpp"
+
+
+// Helpers shared by the image sources, not part of the public headers
+namespace sung { namespace internal {
+
+    // Rounds and saturates a filtered value to the scalar type
+    template <typename T>
+    T to_scalar(float v) {
+        constexpr auto MAX_V = std::numeric_limits<T>::max();
+        const auto clamped = sung::clamp<float>(std::round(v), 0, MAX_V);
+        return static_cast<T>(clamped);
+    }
+
+    template <>
+    inline float to_scalar<float>(float v) {
+        return v;
+    }
+
+
+    // The sRGB transfer curve, on normalized values
+    inline float srgb_to_linear(float c) {
+        if (c <= 0.04045f)
+            return c / 12.92f;
+        return std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline float linear_to_srgb(float l) {
+        if (l <= 0)
+            return 0;
+        if (l <= 0.0031308f)
+            return l * 12.92f;
+        return 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+    }
+
+    // The last channel of 2 and 4 channel images is alpha, which is never
+    // sRGB encoded
+    inline bool is_alpha(size_t channel, size_t channels) {
+        if (channels != 2 && channels != 4)
+            return false;
+        return channel + 1 == channels;
+    }
+
+}}  // namespace sung::internal
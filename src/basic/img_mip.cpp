@@ -0,0 +1,305 @@
+#include "sung/basic/img_mip.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "sung/basic/mamath.hpp"
+
+#include "img_internal.hpp"
+
+
+namespace {
+
+    using sung::internal::is_alpha;
+    using sung::internal::linear_to_srgb;
+    using sung::internal::srgb_to_linear;
+
+    constexpr size_t ROW_GRAIN = 16;
+
+
+    // Converts between stored values and normalized floats
+    template <typename T>
+    struct Codec {
+        static constexpr float MAX_V = std::numeric_limits<T>::max();
+
+        static float decode(T v, bool srgb) {
+            const auto f = static_cast<float>(v) / MAX_V;
+            return srgb ? ::srgb_to_linear(f) : f;
+        }
+
+        static T encode(float f, bool srgb) {
+            if (srgb)
+                f = ::linear_to_srgb(f);
+            f = sung::clamp<float>(f, 0, 1);
+            return static_cast<T>(std::round(f * MAX_V));
+        }
+    };
+
+    template <>
+    struct Codec<uint8_t> {
+        static float decode(uint8_t v, bool srgb) {
+            static const auto lut = make_srgb_lut();
+            if (srgb)
+                return lut[v];
+            return static_cast<float>(v) / 255.f;
+        }
+
+        static uint8_t encode(float f, bool srgb) {
+            if (srgb)
+                f = ::linear_to_srgb(f);
+            f = sung::clamp<float>(f, 0, 1);
+            return static_cast<uint8_t>(std::round(f * 255.f));
+        }
+
+    private:
+        static std::array<float, 256> make_srgb_lut() {
+            std::array<float, 256> out;
+            for (size_t i = 0; i < 256; ++i)
+                out[i] = ::srgb_to_linear(static_cast<float>(i) / 255.f);
+            return out;
+        }
+    };
+
+    template <>
+    struct Codec<float> {
+        static float decode(float v, bool srgb) {
+            return srgb ? ::srgb_to_linear(v) : v;
+        }
+
+        static float encode(float f, bool srgb) {
+            return srgb ? ::linear_to_srgb(f) : f;
+        }
+    };
+
+}  // namespace
+
+
+namespace sung {
+
+    template <typename T>
+    bool TMipChain2D<T>::build(
+        const Image2D& src,
+        ResizeFilter filter,
+        bool srgb,
+        ITaskScheduler* sche
+    ) {
+        this->clear();
+        if (src.scalar_bytes() != sizeof(T) || 0 == src.channels())
+            return false;
+        if (0 == src.x_size() || 0 == src.y_size())
+            return false;
+        if (src.data_.size() < src.size_bytes())
+            return false;
+
+        channels_ = src.channels();
+        const auto ch = channels_;
+
+        size_t x = src.x_size(), y = src.y_size(), total = 0;
+        while (true) {
+            levels_.push_back(Level{ total, x, y });
+            total += x * y * ch;
+            if (1 == x && 1 == y)
+                break;
+            x = (std::max<size_t>)(1, x / 2);
+            y = (std::max<size_t>)(1, y / 2);
+        }
+        data_.resize(total);
+
+        // Level 0 is copied as is, and decoded for filtering
+        Image2D linear;
+        linear.set_metadata<float>(ch, src.x_size(), src.y_size());
+        linear.resize_data_to_fit();
+        parallel_for(
+            src.y_size(),
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                const auto row_len = src.x_size() * ch;
+                for (size_t yy = begin; yy < end; ++yy) {
+                    // Row padding may leave source rows misaligned for T,
+                    // so they are only read as T once copied
+                    const auto in = data_.data() + yy * row_len;
+                    std::memcpy(in, src.pixel_ptr(0, yy), row_len * sizeof(T));
+                    auto out = linear.pixel_ptr<float>(0, yy);
+                    for (size_t i = 0; i < row_len; ++i) {
+                        const auto decode_srgb = srgb &&
+                                                 !::is_alpha(i % ch, ch);
+                        out[i] = ::Codec<T>::decode(in[i], decode_srgb);
+                    }
+                }
+            },
+            sche
+        );
+
+        Image2D next;
+        for (size_t l = 1; l < levels_.size(); ++l) {
+            const auto& level = levels_[l];
+            resize_image<float>(next, linear, level.x_, level.y_, filter, sche);
+            std::swap(linear, next);
+
+            parallel_for(
+                level.y_,
+                ROW_GRAIN,
+                [&](size_t begin, size_t end) {
+                    const auto row_len = level.x_ * ch;
+                    for (size_t yy = begin; yy < end; ++yy) {
+                        const auto in = linear.pixel_ptr<float>(0, yy);
+                        auto out = data_.data() + level.offset_ +
+                                   yy * row_len;
+                        for (size_t i = 0; i < row_len; ++i) {
+                            const auto encode_srgb = srgb &&
+                                                     !::is_alpha(i % ch, ch);
+                            out[i] = ::Codec<T>::encode(in[i], encode_srgb);
+                        }
+                    }
+                },
+                sche
+            );
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    void TMipChain2D<T>::clear() {
+        data_.clear();
+        levels_.clear();
+        channels_ = 0;
+    }
+
+    template <typename T>
+    TImageView2D<T> TMipChain2D<T>::level(size_t i) const {
+        const auto& level = levels_.at(i);
+        TImageView2D<T> out;
+        out.set(data_.data() + level.offset_, channels_, level.x_, level.y_);
+        return out;
+    }
+
+    template <typename T>
+    double TMipChain2D<T>::calc_lod(
+        double dudx, double dvdx, double dudy, double dvdy
+    ) const {
+        if (levels_.empty())
+            return 0;
+
+        const auto w = static_cast<double>(levels_[0].x_);
+        const auto h = static_cast<double>(levels_[0].y_);
+        const auto px = std::hypot(dudx * w, dvdx * h);
+        const auto py = std::hypot(dudy * w, dvdy * h);
+        const auto longer = (std::max)(px, py);
+        if (longer <= 0)
+            return 0;
+        return std::log2(longer);
+    }
+
+    template <typename T>
+    void TMipChain2D<T>::sample_trilinear(
+        float* out, double u, double v, double lod
+    ) const {
+        std::fill(out, out + channels_, 0.f);
+        this->accum_trilinear(out, u, v, lod, 1);
+    }
+
+    template <typename T>
+    void TMipChain2D<T>::sample_aniso(
+        float* out,
+        double u,
+        double v,
+        double dudx,
+        double dvdx,
+        double dudy,
+        double dvdy,
+        size_t max_aniso
+    ) const {
+        std::fill(out, out + channels_, 0.f);
+        if (levels_.empty())
+            return;
+
+        const auto w = static_cast<double>(levels_[0].x_);
+        const auto h = static_cast<double>(levels_[0].y_);
+        const auto px = std::hypot(dudx * w, dvdx * h);
+        const auto py = std::hypot(dudy * w, dvdy * h);
+        const auto longer = (std::max)(px, py);
+        const auto shorter = (std::min)(px, py);
+
+        size_t count = 1;
+        if (shorter > 0 && max_aniso > 1) {
+            const auto ratio = std::ceil(longer / shorter);
+            count = static_cast<size_t>(
+                sung::clamp<double>(ratio, 1, static_cast<double>(max_aniso))
+            );
+        }
+        const auto lod = longer > 0 ? std::log2(longer / count) : 0.0;
+
+        // Spread the samples across the longer axis of the footprint
+        const auto du = px >= py ? dudx : dudy;
+        const auto dv = px >= py ? dvdx : dvdy;
+        const auto weight = 1.f / static_cast<float>(count);
+        for (size_t i = 0; i < count; ++i) {
+            const auto t = (i + 0.5) / count - 0.5;
+            this->accum_trilinear(out, u + du * t, v + dv * t, lod, weight);
+        }
+    }
+
+    template <typename T>
+    void TMipChain2D<T>::accum_bilinear(
+        float* out, size_t level, double u, double v, float weight
+    ) const {
+        const auto& lv = levels_[level];
+        const auto ch = channels_;
+
+        const auto x_texel = u * static_cast<double>(lv.x_);
+        const auto y_texel = v * static_cast<double>(lv.y_);
+        const auto x_floor = std::floor(x_texel);
+        const auto y_floor = std::floor(y_texel);
+        const auto x_frac = static_cast<float>(x_texel - x_floor);
+        const auto y_frac = static_cast<float>(y_texel - y_floor);
+
+        const auto x_last = static_cast<double>(lv.x_ - 1);
+        const auto y_last = static_cast<double>(lv.y_ - 1);
+        const auto x0 = static_cast<size_t>(clamp(x_floor, 0.0, x_last));
+        const auto x1 = static_cast<size_t>(clamp(x_floor + 1, 0.0, x_last));
+        const auto y0 = static_cast<size_t>(clamp(y_floor, 0.0, y_last));
+        const auto y1 = static_cast<size_t>(clamp(y_floor + 1, 0.0, y_last));
+
+        const auto base = data_.data() + lv.offset_;
+        const auto p00 = base + (y0 * lv.x_ + x0) * ch;
+        const auto p10 = base + (y0 * lv.x_ + x1) * ch;
+        const auto p01 = base + (y1 * lv.x_ + x0) * ch;
+        const auto p11 = base + (y1 * lv.x_ + x1) * ch;
+
+        const auto w00 = (1 - x_frac) * (1 - y_frac) * weight;
+        const auto w10 = x_frac * (1 - y_frac) * weight;
+        const auto w01 = (1 - x_frac) * y_frac * weight;
+        const auto w11 = x_frac * y_frac * weight;
+        for (size_t c = 0; c < ch; ++c) {
+            out[c] += w00 * p00[c] + w10 * p10[c] + w01 * p01[c] +
+                      w11 * p11[c];
+        }
+    }
+
+    template <typename T>
+    void TMipChain2D<T>::accum_trilinear(
+        float* out, double u, double v, double lod, float weight
+    ) const {
+        if (levels_.empty())
+            return;
+
+        const auto last = static_cast<double>(levels_.size() - 1);
+        lod = clamp(lod, 0.0, last);
+        const auto l0 = static_cast<size_t>(std::floor(lod));
+        const auto frac = static_cast<float>(lod - l0);
+
+        this->accum_bilinear(out, l0, u, v, weight * (1 - frac));
+        if (frac > 0)
+            this->accum_bilinear(out, l0 + 1, u, v, weight * frac);
+    }
+
+
+    template class TMipChain2D<uint8_t>;
+    template class TMipChain2D<uint16_t>;
+    template class TMipChain2D<float>;
+
+}  // namespace sung
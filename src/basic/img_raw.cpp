@@ -0,0 +1,230 @@
+#include "sung/basic/img_raw.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+
+namespace {
+
+    using sung::LEValue;
+
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t DATA_OFFSET = 64;
+    const std::array<char, 8> MAGIC = { 'S', 'U', 'N', 'G', 'R', 'A', 'W', 0 };
+
+
+    struct RawHeader {
+        std::array<char, 8> magic_;
+        LEValue<uint32_t> version_;
+        LEValue<uint32_t> scalar_;
+        LEValue<uint64_t> channels_;
+        LEValue<uint64_t> x_;
+        LEValue<uint64_t> y_;
+        LEValue<uint64_t> z_;
+        LEValue<uint64_t> data_offset_;
+        std::array<uint8_t, 8> reserved_;
+    };
+
+    static_assert(sizeof(RawHeader) == DATA_OFFSET, "");
+
+
+    bool is_valid_scalar(uint32_t value) {
+        return value <= static_cast<uint32_t>(sung::PixelScalar::float32);
+    }
+
+    // Returns 0 on overflow
+    uint64_t calc_payload_size(
+        uint64_t scalar_bytes,
+        uint64_t channels,
+        uint64_t x,
+        uint64_t y,
+        uint64_t z
+    ) {
+        uint64_t out = scalar_bytes;
+        for (auto v : { channels, x, y, z }) {
+            if (0 == v)
+                return 0;
+            if (out > std::numeric_limits<uint64_t>::max() / v)
+                return 0;
+            out *= v;
+        }
+        return out;
+    }
+
+    RawHeader make_header(
+        sung::PixelScalar scalar, size_t channels, size_t x, size_t y, size_t z
+    ) {
+        RawHeader out;
+        out.magic_ = MAGIC;
+        out.version_.set(VERSION);
+        out.scalar_.set(static_cast<uint32_t>(scalar));
+        out.channels_.set(channels);
+        out.x_.set(x);
+        out.y_.set(y);
+        out.z_.set(z);
+        out.data_offset_.set(DATA_OFFSET);
+        out.reserved_.fill(0);
+        return out;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    bool write_raw_image(
+        const std::string& path,
+        const byte8* data,
+        PixelScalar scalar,
+        size_t channels,
+        size_t x,
+        size_t y,
+        size_t z
+    ) {
+        const auto scalar_bytes = get_scalar_bytes(scalar);
+        const auto size = ::calc_payload_size(scalar_bytes, channels, x, y, z);
+        if (0 == size)
+            return false;
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        const auto header = ::make_header(scalar, channels, x, y, z);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(
+            reinterpret_cast<const char*>(data),
+            static_cast<std::streamsize>(size)
+        );
+        return static_cast<bool>(file);
+    }
+
+    bool write_raw_image(
+        const std::string& path, const Image2D& img, PixelScalar scalar
+    ) {
+        if (get_scalar_bytes(scalar) != img.scalar_bytes())
+            return false;
+        if (img.data_.size() < img.size_bytes())
+            return false;
+        const auto row_bytes = img.x_size() * img.pixel_bytes();
+        const auto size = ::calc_payload_size(
+            img.scalar_bytes(), img.channels(), img.x_size(), img.y_size(), 1
+        );
+        if (0 == size)
+            return false;
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        const auto header = ::make_header(
+            scalar, img.channels(), img.x_size(), img.y_size(), 1
+        );
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t y = 0; y < img.y_size(); ++y) {
+            file.write(
+                reinterpret_cast<const char*>(img.pixel_ptr(0, y)),
+                static_cast<std::streamsize>(row_bytes)
+            );
+        }
+        return static_cast<bool>(file);
+    }
+
+
+    bool MappedImage::open(const std::string& path) {
+        this->close();
+        if (!file_.open(path))
+            return false;
+
+        ::RawHeader header;
+        if (file_.size() < sizeof(header)) {
+            this->close();
+            return false;
+        }
+        std::memcpy(&header, file_.data(), sizeof(header));
+
+        const auto scalar = header.scalar_.get();
+        const auto valid = header.magic_ == MAGIC &&
+                           header.version_.get() == VERSION &&
+                           header.data_offset_.get() == DATA_OFFSET &&
+                           ::is_valid_scalar(scalar);
+        if (!valid) {
+            this->close();
+            return false;
+        }
+
+        scalar_ = static_cast<PixelScalar>(scalar);
+        const auto size = ::calc_payload_size(
+            get_scalar_bytes(scalar_),
+            header.channels_.get(),
+            header.x_.get(),
+            header.y_.get(),
+            header.z_.get()
+        );
+        if (0 == size || size > file_.size() - DATA_OFFSET) {
+            this->close();
+            return false;
+        }
+
+        channels_ = static_cast<size_t>(header.channels_.get());
+        x_ = static_cast<size_t>(header.x_.get());
+        y_ = static_cast<size_t>(header.y_.get());
+        z_ = static_cast<size_t>(header.z_.get());
+        return true;
+    }
+
+    void MappedImage::close() {
+        file_.close();
+        scalar_ = PixelScalar::unorm8;
+        channels_ = 0;
+        x_ = 0;
+        y_ = 0;
+        z_ = 0;
+    }
+
+    bool MappedImage::is_open() const { return file_.is_open(); }
+
+    const byte8* MappedImage::data() const {
+        if (!this->is_open())
+            return nullptr;
+        return file_.data() + DATA_OFFSET;
+    }
+
+    size_t MappedImage::size_bytes() const {
+        return this->slice_bytes() * z_;
+    }
+
+    void MappedImage::advise(AccessHint hint) const {
+        file_.advise(hint, DATA_OFFSET, this->size_bytes());
+    }
+
+    void MappedImage::prefetch_slices(size_t begin, size_t end) const {
+        // Rows of an image, slices of a volume
+        const auto row = get_scalar_bytes(scalar_) * channels_ * x_;
+        const auto slices = 1 == z_ ? y_ : z_;
+        const auto slice = 1 == z_ ? row : row * y_;
+        end = (std::min)(end, slices);
+        if (begin >= end)
+            return;
+
+        file_.advise(
+            AccessHint::willneed,
+            DATA_OFFSET + begin * slice,
+            (end - begin) * slice
+        );
+    }
+
+    bool MappedImage::check_view(size_t scalar_bytes) const {
+        if (!this->is_open())
+            return false;
+        return get_scalar_bytes(scalar_) == scalar_bytes;
+    }
+
+    size_t MappedImage::slice_bytes() const {
+        return get_scalar_bytes(scalar_) * channels_ * x_ * y_;
+    }
+
+}  // namespace sung
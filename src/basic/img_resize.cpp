@@ -0,0 +1,282 @@
+#include "sung/basic/img_resize.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sung/basic/mamath.hpp"
+
+#include "img_internal.hpp"
+
+
+namespace {
+
+    using sung::ResizeFilter;
+
+    // Source rows or destination rows per task
+    constexpr size_t ROW_GRAIN = 16;
+
+
+    double get_filter_radius(ResizeFilter filter) {
+        switch (filter) {
+            case ResizeFilter::box:
+                return 0.5;
+            case ResizeFilter::bilinear:
+                return 1;
+            case ResizeFilter::bicubic:
+                return 2;
+            case ResizeFilter::lanczos:
+            case ResizeFilter::kaiser:
+            default:
+                return 3;
+        }
+    }
+
+    double sinc(double x) {
+        if (x == 0)
+            return 1;
+        const auto px = SUNG_PI * x;
+        return std::sin(px) / px;
+    }
+
+    // Modified Bessel function of the first kind, order 0
+    double bessel_i0(double x) {
+        double sum = 1;
+        double term = 1;
+        const auto half_sqr = x * x / 4;
+        for (int k = 1; k < 32; ++k) {
+            term *= half_sqr / (k * k);
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    double kaiser(double x, double radius) {
+        constexpr double ALPHA = 4;
+        const auto t = x / radius;
+        if (t * t >= 1)
+            return 0;
+        return ::bessel_i0(ALPHA * std::sqrt(1 - t * t)) / ::bessel_i0(ALPHA);
+    }
+
+    double eval_filter(ResizeFilter filter, double x) {
+        const auto ax = std::abs(x);
+        switch (filter) {
+            case ResizeFilter::box:
+                return (x >= -0.5 && x < 0.5) ? 1 : 0;
+            case ResizeFilter::bilinear:
+                return ax < 1 ? 1 - ax : 0;
+            case ResizeFilter::bicubic: {
+                constexpr double A = -0.5;
+                if (ax < 1)
+                    return ((A + 2) * ax - (A + 3)) * ax * ax + 1;
+                if (ax < 2)
+                    return ((A * ax - 5 * A) * ax + 8 * A) * ax - 4 * A;
+                return 0;
+            }
+            case ResizeFilter::kaiser:
+                return ::sinc(x) * ::kaiser(x, 3);
+            case ResizeFilter::lanczos:
+            default:
+                return ax < 3 ? ::sinc(x) * ::sinc(x / 3) : 0;
+        }
+    }
+
+
+    /*
+    Filter taps of one axis. Every destination index has `taps_` slots, unused
+    ones have zero weights, so the inner loops have a fixed trip count.
+    */
+    class WeightTable {
+
+    public:
+        void build(ResizeFilter filter, size_t src_size, size_t dst_size) {
+            const auto scale = static_cast<double>(src_size) / dst_size;
+            // Widen the filter when minifying
+            const auto filter_scale = (std::max)(1.0, scale);
+            const auto support = ::get_filter_radius(filter) * filter_scale;
+            const auto last = static_cast<double>(src_size - 1);
+
+            taps_ = static_cast<size_t>(std::ceil(support * 2)) + 1;
+            src_idx_.assign(dst_size * taps_, 0);
+            weights_.assign(dst_size * taps_, 0);
+
+            std::vector<double> w(taps_);
+            for (size_t i = 0; i < dst_size; ++i) {
+                const auto center = (i + 0.5) * scale;
+                const auto lo = std::floor(center - support);
+                auto idx = src_idx_.data() + i * taps_;
+                std::fill(w.begin(), w.end(), 0);
+
+                // Taps past the edges are merged into the edge texel
+                size_t used = 0;
+                double sum = 0;
+                for (size_t t = 0; t < taps_; ++t) {
+                    const auto j = lo + t;
+                    const auto x = (j + 0.5 - center) / filter_scale;
+                    const auto weight = ::eval_filter(filter, x);
+                    if (weight == 0)
+                        continue;
+
+                    const auto src_i = static_cast<uint32_t>(
+                        sung::clamp<double>(j, 0, last)
+                    );
+                    if (used > 0 && idx[used - 1] == src_i) {
+                        w[used - 1] += weight;
+                    } else {
+                        idx[used] = src_i;
+                        w[used] = weight;
+                        ++used;
+                    }
+                    sum += weight;
+                }
+
+                auto out = weights_.data() + i * taps_;
+                if (0 == used || sum == 0) {
+                    idx[0] = static_cast<uint32_t>(
+                        sung::clamp<double>(std::floor(center), 0, last)
+                    );
+                    out[0] = 1;
+                    continue;
+                }
+                for (size_t t = 0; t < used; ++t)
+                    out[t] = static_cast<float>(w[t] / sum);
+            }
+        }
+
+        size_t taps() const { return taps_; }
+        const uint32_t* src_idx(size_t i) const {
+            return src_idx_.data() + i * taps_;
+        }
+        const float* weights(size_t i) const {
+            return weights_.data() + i * taps_;
+        }
+
+    private:
+        std::vector<uint32_t> src_idx_;
+        std::vector<float> weights_;
+        size_t taps_ = 0;
+    };
+
+
+    template <typename T>
+    bool check_image(const sung::Image2D& img, size_t channels) {
+        if (img.scalar_bytes() != sizeof(T))
+            return false;
+        if (img.channels() != channels || 0 == channels)
+            return false;
+        if (0 == img.x_size() || 0 == img.y_size())
+            return false;
+        if (img.data_.size() < img.size_bytes())
+            return false;
+        return true;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    template <typename T>
+    bool resize_image(
+        Image2D& dst,
+        const Image2D& src,
+        ResizeFilter filter,
+        ITaskScheduler* sche
+    ) {
+        const auto channels = src.channels();
+        if (!::check_image<T>(src, channels))
+            return false;
+        if (!::check_image<T>(dst, channels))
+            return false;
+
+        const auto src_x = src.x_size();
+        const auto src_y = src.y_size();
+        const auto dst_x = dst.x_size();
+        const auto dst_y = dst.y_size();
+        const auto row_len = dst_x * channels;
+
+        ::WeightTable x_table, y_table;
+        x_table.build(filter, src_x, dst_x);
+        y_table.build(filter, src_y, dst_y);
+
+        // Horizontal pass, src_y rows of dst_x pixels
+        std::vector<float> tmp(src_y * row_len);
+        parallel_for(
+            src_y,
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                const auto taps = x_table.taps();
+                for (size_t y = begin; y < end; ++y) {
+                    const auto in = src.pixel_ptr<T>(0, y);
+                    auto out = tmp.data() + y * row_len;
+                    for (size_t x = 0; x < dst_x; ++x) {
+                        const auto idx = x_table.src_idx(x);
+                        const auto w = x_table.weights(x);
+                        if (4 == channels) {
+                            // Fixed width so the pixel is one vector
+                            float sum[4] = { 0, 0, 0, 0 };
+                            for (size_t t = 0; t < taps; ++t) {
+                                const auto p = in + idx[t] * 4;
+                                for (size_t c = 0; c < 4; ++c)
+                                    sum[c] += w[t] * p[c];
+                            }
+                            std::copy(sum, sum + 4, out + x * 4);
+                            continue;
+                        }
+                        for (size_t c = 0; c < channels; ++c) {
+                            float sum = 0;
+                            for (size_t t = 0; t < taps; ++t)
+                                sum += w[t] * in[idx[t] * channels + c];
+                            out[x * channels + c] = sum;
+                        }
+                    }
+                }
+            },
+            sche
+        );
+
+        // Vertical pass, whole rows at a time so the inner loop vectorizes
+        parallel_for(
+            dst_y,
+            ROW_GRAIN,
+            [&](size_t begin, size_t end) {
+                const auto taps = y_table.taps();
+                std::vector<float> acc(row_len);
+                for (size_t y = begin; y < end; ++y) {
+                    const auto idx = y_table.src_idx(y);
+                    const auto w = y_table.weights(y);
+                    std::fill(acc.begin(), acc.end(), 0.f);
+                    for (size_t t = 0; t < taps; ++t) {
+                        if (w[t] == 0)
+                            continue;
+                        const auto in = tmp.data() + idx[t] * row_len;
+                        const auto wt = w[t];
+                        for (size_t i = 0; i < row_len; ++i)
+                            acc[i] += wt * in[i];
+                    }
+
+                    auto out = dst.pixel_ptr<T>(0, y);
+                    for (size_t i = 0; i < row_len; ++i)
+                        out[i] = sung::internal::to_scalar<T>(acc[i]);
+                }
+            },
+            sche
+        );
+
+        return true;
+    }
+
+    template bool resize_image<uint8_t>(
+        Image2D&, const Image2D&, ResizeFilter, ITaskScheduler*
+    );
+    template bool resize_image<uint16_t>(
+        Image2D&, const Image2D&, ResizeFilter, ITaskScheduler*
+    );
+    template bool resize_image<float>(
+        Image2D&, const Image2D&, ResizeFilter, ITaskScheduler*
+    );
+
+}  // namespace sung
@@ -0,0 +1,97 @@
+#include "sung/basic/img_tiled.hpp"
+
+#include <algorithm>
+
+
+namespace sung {
+
+    constexpr size_t TiledImage2D::TILE_SIZE;
+
+
+    void TiledImage2D::clear() {
+        data_.clear();
+        this->clear_metadata();
+    }
+
+    void TiledImage2D::resize_data_to_fit() {
+        data_.resize(this->tiled_size_bytes());
+    }
+
+    byte8* TiledImage2D::pixel_ptr(size_t x, size_t y) {
+        return data_.data() + this->make_tiled_idx(x, y);
+    }
+
+    const byte8* TiledImage2D::pixel_ptr(size_t x, size_t y) const {
+        return data_.data() + this->make_tiled_idx(x, y);
+    }
+
+    size_t TiledImage2D::tile_count_x() const {
+        return (this->x_size() + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    size_t TiledImage2D::tile_count_y() const {
+        return (this->y_size() + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    size_t TiledImage2D::tile_bytes() const {
+        return TILE_SIZE * TILE_SIZE * this->pixel_bytes();
+    }
+
+    size_t TiledImage2D::tiled_size_bytes() const {
+        return this->tile_count_x() * this->tile_count_y() *
+               this->tile_bytes();
+    }
+
+    size_t TiledImage2D::padding_bytes() const { return 0; }
+
+    size_t TiledImage2D::size_bytes() const {
+        return this->tiled_size_bytes();
+    }
+
+    void TiledImage2D::copy_from(const Image2D& src) {
+        this->set_metadata(
+            src.scalar_bytes(), src.channels(), src.x_size(), src.y_size()
+        );
+        this->resize_data_to_fit();
+
+        // A row within a tile is contiguous in both layouts
+        const auto pixel_bytes = this->pixel_bytes();
+        for (size_t y = 0; y < this->y_size(); ++y) {
+            for (size_t x = 0; x < this->x_size(); x += TILE_SIZE) {
+                const auto len = std::min(TILE_SIZE, this->x_size() - x);
+                const auto from = src.pixel_ptr(x, y);
+                const auto to = this->pixel_ptr(x, y);
+                std::copy(from, from + len * pixel_bytes, to);
+            }
+        }
+    }
+
+    void TiledImage2D::copy_to(Image2D& dst) const {
+        dst.set_metadata(
+            this->scalar_bytes(),
+            this->channels(),
+            this->x_size(),
+            this->y_size()
+        );
+        dst.resize_data_to_fit();
+
+        const auto pixel_bytes = this->pixel_bytes();
+        for (size_t y = 0; y < this->y_size(); ++y) {
+            for (size_t x = 0; x < this->x_size(); x += TILE_SIZE) {
+                const auto len = std::min(TILE_SIZE, this->x_size() - x);
+                const auto from = this->pixel_ptr(x, y);
+                const auto to = dst.pixel_ptr(x, y);
+                std::copy(from, from + len * pixel_bytes, to);
+            }
+        }
+    }
+
+    size_t TiledImage2D::make_tiled_idx(size_t x, size_t y) const {
+        constexpr size_t MASK = TILE_SIZE - 1;
+        const auto tile = (y / TILE_SIZE) * this->tile_count_x() +
+                          x / TILE_SIZE;
+        const auto inner = (y & MASK) * TILE_SIZE + (x & MASK);
+        return (tile * TILE_SIZE * TILE_SIZE + inner) * this->pixel_bytes();
+    }
+
+}  // namespace sung
@@ -0,0 +1,223 @@
+#include "sung/basic/lz.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr size_t NIBBLE_MAX = 15;
+    constexpr int HASH_BITS = 14;
+
+
+    uint32_t read_u32(const sung::byte8* p) {
+        uint32_t out;
+        std::memcpy(&out, p, sizeof(out));
+        return out;
+    }
+
+    uint32_t hash_u32(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Bytes needed past the token for a length of `len`
+    size_t length_bytes(size_t len) {
+        return len < NIBBLE_MAX ? 0 : (len - NIBBLE_MAX) / 255 + 1;
+    }
+
+    sung::byte8* put_length(sung::byte8* op, size_t len) {
+        if (len < NIBBLE_MAX)
+            return op;
+        len -= NIBBLE_MAX;
+        for (; len >= 255; len -= 255) *op++ = 255;
+        *op++ = static_cast<sung::byte8>(len);
+        return op;
+    }
+
+    // Adds the extra length bytes to `len`. False if the input runs out.
+    bool get_length(
+        const sung::byte8*& ip, const sung::byte8* end, size_t& len
+    ) {
+        if (len != NIBBLE_MAX)
+            return true;
+        sung::byte8 b;
+        do {
+            if (ip >= end)
+                return false;
+            b = *ip++;
+            len += b;
+        } while (255 == b);
+        return true;
+    }
+
+
+    class SequenceWriter {
+
+    public:
+        SequenceWriter(sung::byte8* dst, size_t capacity)
+            : op_(dst), begin_(dst), end_(dst + capacity) {}
+
+        // `match_len` of 0 makes the last sequence, with no offset
+        bool put(
+            const sung::byte8* literals,
+            size_t lit_len,
+            size_t offset,
+            size_t match_len
+        ) {
+            const auto ml = match_len ? match_len - MIN_MATCH : 0;
+            const auto need = 1 + ::length_bytes(lit_len) + lit_len +
+                              (match_len ? 2 + ::length_bytes(ml) : 0);
+            if (need > static_cast<size_t>(end_ - op_))
+                return false;
+
+            const auto lit_nibble = (std::min)(lit_len, NIBBLE_MAX);
+            const auto ml_nibble = (std::min)(ml, NIBBLE_MAX);
+            *op_++ = static_cast<sung::byte8>(lit_nibble << 4 | ml_nibble);
+            op_ = ::put_length(op_, lit_len);
+            // Empty inputs come with null pointers, memcpy must not see them
+            if (lit_len > 0)
+                std::memcpy(op_, literals, lit_len);
+            op_ += lit_len;
+            if (0 == match_len)
+                return true;
+
+            *op_++ = static_cast<sung::byte8>(offset & 0xFF);
+            *op_++ = static_cast<sung::byte8>(offset >> 8);
+            op_ = ::put_length(op_, ml);
+            return true;
+        }
+
+        size_t size() const { return static_cast<size_t>(op_ - begin_); }
+
+    private:
+        sung::byte8* op_;
+        sung::byte8* begin_;
+        sung::byte8* end_;
+    };
+
+}  // namespace
+
+
+namespace sung {
+
+    size_t lz_compress_bound(size_t size) {
+        // One literal run with its token and length bytes
+        return size + size / 255 + 16;
+    }
+
+    size_t lz_compress(
+        byte8* dst, size_t dst_capacity, const byte8* src, size_t src_size
+    ) {
+        // Positions are stored in 32 bits
+        if (src_size > UINT32_MAX)
+            return 0;
+
+        ::SequenceWriter out(dst, dst_capacity);
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        size_t anchor = 0;
+        size_t ip = 1;
+
+        // Greedy matching, stepping faster through data that doesn't match
+        while (src_size >= MIN_MATCH && ip <= src_size - MIN_MATCH) {
+            const auto v = ::read_u32(src + ip);
+            auto& slot = table[::hash_u32(v)];
+            const size_t cand = slot;
+            slot = static_cast<uint32_t>(ip);
+
+            const auto found = ip - cand <= MAX_OFFSET &&
+                               ::read_u32(src + cand) == v;
+            if (!found) {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            size_t len = MIN_MATCH;
+            while (ip + len < src_size && src[cand + len] == src[ip + len])
+                ++len;
+
+            if (!out.put(src + anchor, ip - anchor, ip - cand, len))
+                return 0;
+            ip += len;
+            anchor = ip;
+        }
+
+        if (!out.put(src + anchor, src_size - anchor, 0, 0))
+            return 0;
+        return out.size();
+    }
+
+    bool lz_decompress(
+        byte8* dst, size_t dst_size, const byte8* src, size_t src_size
+    ) {
+        const auto iend = src + src_size;
+        const auto oend = dst + dst_size;
+        auto ip = src;
+        auto op = dst;
+
+        while (true) {
+            if (ip >= iend)
+                return false;
+            const auto token = *ip++;
+
+            size_t lit = token >> 4;
+            if (!::get_length(ip, iend, lit))
+                return false;
+            if (lit > static_cast<size_t>(iend - ip) ||
+                lit > static_cast<size_t>(oend - op))
+                return false;
+            if (lit > 0)
+                std::memcpy(op, ip, lit);
+            op += lit;
+            ip += lit;
+
+            if (ip == iend)
+                return op == oend;
+
+            if (iend - ip < 2)
+                return false;
+            const size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+            ip += 2;
+            if (0 == offset || offset > static_cast<size_t>(op - dst))
+                return false;
+
+            size_t len = token & 0x0F;
+            if (!::get_length(ip, iend, len))
+                return false;
+            len += MIN_MATCH;
+            if (len > static_cast<size_t>(oend - op))
+                return false;
+
+            // Overlapping matches repeat the last `offset` bytes
+            const auto match = op - offset;
+            if (offset >= len)
+                std::memcpy(op, match, len);
+            else
+                for (size_t i = 0; i < len; ++i) op[i] = match[i];
+            op += len;
+        }
+    }
+
+
+    void shuffle_bytes(
+        byte8* dst, const byte8* src, size_t count, size_t type_size
+    ) {
+        for (size_t b = 0; b < type_size; ++b) {
+            auto out = dst + b * count;
+            for (size_t i = 0; i < count; ++i) out[i] = src[i * type_size + b];
+        }
+    }
+
+    void unshuffle_bytes(
+        byte8* dst, const byte8* src, size_t count, size_t type_size
+    ) {
+        for (size_t b = 0; b < type_size; ++b) {
+            const auto in = src + b * count;
+            for (size_t i = 0; i < count; ++i) dst[i * type_size + b] = in[i];
+        }
+    }
+
+}  // namespace sung
@@ -0,0 +1,379 @@
+#include "sung/basic/mapped_file.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "sung/basic/os_detect.hpp"
+
+#ifdef SUNG_OS_WINDOWS
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace {
+
+    size_t get_page_size() {
+#ifdef SUNG_OS_WINDOWS
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+#ifndef SUNG_OS_WINDOWS
+    int to_madvise(sung::AccessHint hint) {
+        switch (hint) {
+            case sung::AccessHint::sequential:
+                return MADV_SEQUENTIAL;
+            case sung::AccessHint::random:
+                return MADV_RANDOM;
+            case sung::AccessHint::willneed:
+                return MADV_WILLNEED;
+            case sung::AccessHint::normal:
+                break;
+        }
+        return MADV_NORMAL;
+    }
+#endif
+
+    // Ranges are widened to page boundaries and clipped to the mapping
+    void advise_range(
+        const sung::byte8* data,
+        size_t data_size,
+        sung::AccessHint hint,
+        size_t offset,
+        size_t size
+    ) {
+        if (nullptr == data || offset >= data_size)
+            return;
+
+        static const auto page = ::get_page_size();
+        const auto end = offset + (std::min)(size, data_size - offset);
+        const auto begin = offset / page * page;
+
+#ifdef SUNG_OS_WINDOWS
+    // Only prefetching has an equivalent, from Windows 8
+    #if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+        if (sung::AccessHint::willneed != hint)
+            return;
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<sung::byte8*>(data + begin);
+        range.NumberOfBytes = end - begin;
+        ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+    #else
+        (void)hint;
+        (void)end;
+        (void)begin;
+    #endif
+#else
+        const auto addr = const_cast<sung::byte8*>(data + begin);
+        ::madvise(addr, end - begin, ::to_madvise(hint));
+#endif
+    }
+
+}  // namespace
+
+
+// MappedFile
+namespace sung {
+
+    MappedFile::~MappedFile() { this->close(); }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this == &other)
+            return *this;
+
+        this->close();
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(open_, other.open_);
+#ifdef SUNG_OS_WINDOWS
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#endif
+        return *this;
+    }
+
+#ifdef SUNG_OS_WINDOWS
+
+    bool MappedFile::open(const std::string& path) {
+        this->close();
+
+        const auto file = ::CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (INVALID_HANDLE_VALUE == file)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(file, &size)) {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        file_ = file;
+        size_ = static_cast<size_t>(size.QuadPart);
+        open_ = true;
+        if (0 == size_)
+            return true;
+
+        mapping_ = ::CreateFileMappingA(
+            file, nullptr, PAGE_READONLY, 0, 0, nullptr
+        );
+        if (nullptr == mapping_) {
+            this->close();
+            return false;
+        }
+
+        const auto view = ::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (nullptr == view) {
+            this->close();
+            return false;
+        }
+        data_ = static_cast<const byte8*>(view);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (nullptr != data_)
+            ::UnmapViewOfFile(data_);
+        if (nullptr != mapping_)
+            ::CloseHandle(mapping_);
+        if (nullptr != file_)
+            ::CloseHandle(file_);
+
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+#else
+
+    bool MappedFile::open(const std::string& path) {
+        this->close();
+
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (0 != ::fstat(fd, &st)) {
+            ::close(fd);
+            return false;
+        }
+
+        const auto size = static_cast<size_t>(st.st_size);
+        void* ptr = nullptr;
+        if (size > 0) {
+            ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (MAP_FAILED == ptr) {
+                ::close(fd);
+                return false;
+            }
+        }
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+        data_ = static_cast<const byte8*>(ptr);
+        size_ = size;
+        open_ = true;
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (nullptr != data_)
+            ::munmap(const_cast<byte8*>(data_), size_);
+
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+#endif
+
+    bool MappedFile::is_open() const { return open_; }
+
+    void MappedFile::advise(AccessHint hint) const {
+        this->advise(hint, 0, size_);
+    }
+
+    void MappedFile::advise(AccessHint hint, size_t offset, size_t size)
+        const {
+        ::advise_range(data_, size_, hint, offset, size);
+    }
+
+}  // namespace sung
+
+
+// MappedScratchFile
+namespace sung {
+
+    MappedScratchFile::~MappedScratchFile() { this->close(); }
+
+    MappedScratchFile::MappedScratchFile(MappedScratchFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedScratchFile& MappedScratchFile::operator=(
+        MappedScratchFile&& other
+    ) noexcept {
+        if (this == &other)
+            return *this;
+
+        this->close();
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(open_, other.open_);
+#ifdef SUNG_OS_WINDOWS
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#endif
+        return *this;
+    }
+
+#ifdef SUNG_OS_WINDOWS
+
+    bool MappedScratchFile::create(const std::string& path, size_t size) {
+        this->close();
+
+        const auto file = ::CreateFileA(
+            path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_DELETE,
+            nullptr,
+            CREATE_NEW,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+            nullptr
+        );
+        if (INVALID_HANDLE_VALUE == file)
+            return false;
+
+        file_ = file;
+        size_ = size;
+        open_ = true;
+        if (0 == size_)
+            return true;
+
+        // Mapping past the end grows the file, filled with zeros
+        const auto size64 = static_cast<uint64_t>(size);
+        mapping_ = ::CreateFileMappingA(
+            file,
+            nullptr,
+            PAGE_READWRITE,
+            static_cast<DWORD>(size64 >> 32),
+            static_cast<DWORD>(size64 & 0xFFFFFFFF),
+            nullptr
+        );
+        if (nullptr == mapping_) {
+            this->close();
+            return false;
+        }
+
+        const auto view = ::MapViewOfFile(
+            mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0
+        );
+        if (nullptr == view) {
+            this->close();
+            return false;
+        }
+        data_ = static_cast<byte8*>(view);
+        return true;
+    }
+
+    void MappedScratchFile::close() {
+        if (nullptr != data_)
+            ::UnmapViewOfFile(data_);
+        if (nullptr != mapping_)
+            ::CloseHandle(mapping_);
+        if (nullptr != file_)
+            ::CloseHandle(file_);
+
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+#else
+
+    bool MappedScratchFile::create(const std::string& path, size_t size) {
+        this->close();
+
+        // Only ever a new file, so the unlinks below can't hit a user's file
+        const auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+            return false;
+
+        // A sparse file of zeros, disk blocks come as pages are written
+        void* ptr = nullptr;
+        if (size > 0) {
+            if (0 != ::ftruncate(fd, static_cast<off_t>(size))) {
+                ::close(fd);
+                ::unlink(path.c_str());
+                return false;
+            }
+            const auto prot = PROT_READ | PROT_WRITE;
+            ptr = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+            if (MAP_FAILED == ptr) {
+                ::close(fd);
+                ::unlink(path.c_str());
+                return false;
+            }
+        }
+
+        // The mapping keeps the file alive without a name
+        ::close(fd);
+        ::unlink(path.c_str());
+        data_ = static_cast<byte8*>(ptr);
+        size_ = size;
+        open_ = true;
+        return true;
+    }
+
+    void MappedScratchFile::close() {
+        if (nullptr != data_)
+            ::munmap(data_, size_);
+
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+#endif
+
+    bool MappedScratchFile::is_open() const { return open_; }
+
+    void MappedScratchFile::advise(AccessHint hint) const {
+        this->advise(hint, 0, size_);
+    }
+
+    void MappedScratchFile::advise(
+        AccessHint hint, size_t offset, size_t size
+    ) const {
+        ::advise_range(data_, size_, hint, offset, size);
+    }
+
+}  // namespace sung
@@ -0,0 +1,91 @@
+#include "sung/basic/morton.hpp"
+
+
+namespace {
+
+    // Skilling's AxestoTranspose for 3 axes
+    void axes_to_transpose(uint32_t (&x)[3], uint32_t bits) {
+        const uint32_t m = uint32_t{ 1 } << (bits - 1);
+
+        // Inverse undo
+        for (uint32_t q = m; q > 1; q >>= 1) {
+            const uint32_t p = q - 1;
+            for (int i = 0; i < 3; ++i) {
+                if (x[i] & q) {
+                    x[0] ^= p;
+                } else {
+                    const uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+
+        // Gray encode
+        for (int i = 1; i < 3; ++i) x[i] ^= x[i - 1];
+        uint32_t t = 0;
+        for (uint32_t q = m; q > 1; q >>= 1) {
+            if (x[2] & q)
+                t ^= q - 1;
+        }
+        for (int i = 0; i < 3; ++i) x[i] ^= t;
+    }
+
+    // Skilling's TransposetoAxes for 3 axes
+    void transpose_to_axes(uint32_t (&x)[3], uint32_t bits) {
+        const uint64_t n = uint64_t{ 2 } << (bits - 1);
+
+        // Gray decode by H ^ (H / 2)
+        const uint32_t t = x[2] >> 1;
+        for (int i = 2; i > 0; --i) x[i] ^= x[i - 1];
+        x[0] ^= t;
+
+        // Undo excess work
+        for (uint64_t q = 2; q != n; q <<= 1) {
+            const auto p = static_cast<uint32_t>(q - 1);
+            for (int i = 2; i >= 0; --i) {
+                if (x[i] & q) {
+                    x[0] ^= p;
+                } else {
+                    const uint32_t t2 = (x[0] ^ x[i]) & p;
+                    x[0] ^= t2;
+                    x[i] ^= t2;
+                }
+            }
+        }
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    uint64_t hilbert_encode_3d(
+        uint32_t x, uint32_t y, uint32_t z, uint32_t bits
+    ) {
+        if (0 == bits)
+            return 0;
+
+        uint32_t axes[3] = { x, y, z };
+        ::axes_to_transpose(axes, bits);
+        return morton_encode_3d(axes[2], axes[1], axes[0]);
+    }
+
+    void hilbert_decode_3d(
+        uint64_t code, uint32_t bits, uint32_t& x, uint32_t& y, uint32_t& z
+    ) {
+        if (0 == bits) {
+            x = y = z = 0;
+            return;
+        }
+
+        uint32_t axes[3] = { morton_decode_3d_z(code),
+                             morton_decode_3d_y(code),
+                             morton_decode_3d_x(code) };
+        ::transpose_to_axes(axes, bits);
+        x = axes[0];
+        y = axes[1];
+        z = axes[2];
+    }
+
+}  // namespace sung
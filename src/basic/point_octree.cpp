@@ -0,0 +1,456 @@
+#include "sung/basic/point_octree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+
+
+namespace {
+
+    using Vec3 = sung::PointOctree::Vec3;
+    using Record = sung::PointOctree::Record;
+
+    constexpr auto MAX_LEVEL = sung::PointOctree::MAX_LEVEL;
+    constexpr uint64_t CELL_COUNT = uint64_t{ 1 } << MAX_LEVEL;
+
+    // Shared by all octrees so no two open scratch files get the same name
+    std::atomic<uint64_t> g_scratch_serial{ 0 };
+
+
+    // Stable, so points with the same code stay in insertion order
+    void sort_by_code(std::vector<Record>& records) {
+        std::stable_sort(
+            records.begin(),
+            records.end(),
+            [](const Record& a, const Record& b) { return a.code_ < b.code_; }
+        );
+    }
+
+    /*
+    Index of the run whose next record has the smallest code, or
+    `heads.size()` if all are used up. There are few runs, so a linear scan
+    does. Older runs win ties, which keeps insertion order.
+    */
+    size_t find_smallest_head(
+        const std::vector<const Record*>& heads,
+        const std::vector<const Record*>& ends
+    ) {
+        auto best = heads.size();
+        for (size_t i = 0; i < heads.size(); ++i) {
+            if (heads[i] == ends[i])
+                continue;
+            if (best == heads.size() || heads[i]->code_ < heads[best]->code_)
+                best = i;
+        }
+        return best;
+    }
+
+    double calc_dist(const sung::PointOctree::Aabb3& aabb, const Vec3& p) {
+        double out = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const auto mini = aabb.mini()[i];
+            const auto maxi = aabb.maxi()[i];
+            if (p[i] < mini)
+                out += (mini - p[i]) * (mini - p[i]);
+            else if (p[i] > maxi)
+                out += (p[i] - maxi) * (p[i] - maxi);
+        }
+        return std::sqrt(out);
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    constexpr uint32_t PointOctree::MAX_LEVEL;
+
+
+    bool PointOctree::build(
+        const Vec3* points, size_t count, const Aabb3& aabb
+    ) {
+        this->reset(aabb);
+
+        std::vector<Record> records(count);
+        for (size_t i = 0; i < count; ++i)
+            records[i] = Record{ this->calc_code(points[i]), points[i] };
+        ::sort_by_code(records);
+        return this->add_run(records);
+    }
+
+    bool PointOctree::build(const Vec3* points, size_t count) {
+        Aabb3DLazyInit<double> bounds;
+        for (size_t i = 0; i < count; ++i) {
+            bounds.set_or_expand(points[i]);
+        }
+        return this->build(
+            points, count, Aabb3{ bounds.mini(), bounds.maxi() }
+        );
+    }
+
+    void PointOctree::reset(const Aabb3& aabb) {
+        this->clear();
+        this->set_aabb(aabb);
+    }
+
+    void PointOctree::set_scratch_path(const std::string& path_prefix) {
+        scratch_prefix_ = path_prefix;
+    }
+
+    void PointOctree::set_buffer_size(size_t count) { buffer_size_ = count; }
+
+    bool PointOctree::insert(const Vec3* points, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pending_.push_back(Record{ this->calc_code(points[i]), points[i] });
+            const auto full = 0 != buffer_size_ &&
+                              pending_.size() >= buffer_size_;
+            if (full && !this->flush())
+                return false;
+        }
+        return true;
+    }
+
+    bool PointOctree::flush() {
+        if (pending_.empty())
+            return true;
+
+        ::sort_by_code(pending_);
+        if (!this->add_run(pending_))
+            return false;
+        pending_.clear();
+
+        // Runs stay ordered from the largest, like a binary counter
+        while (runs_.size() >= 2) {
+            const auto n = runs_.size();
+            if (runs_[n - 2].size() > runs_[n - 1].size())
+                break;
+            if (!this->merge_runs(n - 2))
+                return false;
+        }
+        return true;
+    }
+
+    bool PointOctree::compact() {
+        if (runs_.size() < 2)
+            return true;
+        return this->merge_runs(0);
+    }
+
+    void PointOctree::clear() {
+        runs_.clear();
+        pending_.clear();
+        size_ = 0;
+    }
+
+    size_t PointOctree::size() const { return size_; }
+
+    size_t PointOctree::pending_size() const { return pending_.size(); }
+
+    size_t PointOctree::run_count() const { return runs_.size(); }
+
+    const PointOctree::Aabb3& PointOctree::aabb() const { return aabb_; }
+
+    PointOctree::Node PointOctree::root() const {
+        return this->make_node(0, 0);
+    }
+
+    PointOctree::Node PointOctree::make_node(uint64_t code, uint32_t level)
+        const {
+        Node out;
+        out.code_ = code;
+        out.level_ = level;
+
+        const auto shift = 3 * (MAX_LEVEL - level);
+        const auto lo = code << shift;
+        const auto hi = (code + 1) << shift;
+        for (const auto& run : runs_)
+            out.count_ += run.lower_bound(hi) - run.lower_bound(lo);
+
+        const auto cell_count = uint64_t{ 1 } << level;
+        const uint32_t cell[3] = { morton_decode_3d_x(code),
+                                   morton_decode_3d_y(code),
+                                   morton_decode_3d_z(code) };
+        Vec3 mini, maxi;
+        for (size_t i = 0; i < 3; ++i) {
+            const auto a_min = aabb_.mini()[i];
+            const auto a_max = aabb_.maxi()[i];
+            const auto size = (a_max - a_min) / static_cast<double>(cell_count);
+            mini[i] = a_min + size * cell[i];
+            // Avoid rounding errors at the root's far boundary
+            if (cell[i] + 1 == cell_count)
+                maxi[i] = a_max;
+            else
+                maxi[i] = a_min + size * (cell[i] + 1);
+        }
+        out.aabb_.set(mini, maxi);
+        return out;
+    }
+
+    void PointOctree::get_children(std::vector<Node>& out, const Node& node)
+        const {
+        out.clear();
+        if (node.level_ >= MAX_LEVEL)
+            return;
+
+        for (uint64_t i = 0; i < 8; ++i) {
+            const auto child = this->make_node(
+                (node.code_ << 3) | i, node.level_ + 1
+            );
+            if (child.count_ > 0)
+                out.push_back(child);
+        }
+    }
+
+    void PointOctree::get_points(std::vector<Vec3>& out, const Node& node)
+        const {
+        out.clear();
+        out.reserve(node.count_);
+
+        const auto shift = 3 * (MAX_LEVEL - node.level_);
+        const auto lo = node.code_ << shift;
+        const auto hi = (node.code_ + 1) << shift;
+        std::vector<const Record*> heads, ends;
+        for (const auto& run : runs_) {
+            heads.push_back(run.data() + run.lower_bound(lo));
+            ends.push_back(run.data() + run.lower_bound(hi));
+        }
+
+        while (true) {
+            const auto i = ::find_smallest_head(heads, ends);
+            if (i == heads.size())
+                break;
+            out.push_back(heads[i]->point_);
+            ++heads[i];
+        }
+    }
+
+    void PointOctree::select_lod(
+        std::vector<Node>& out, const RefineFunc& refine, size_t leaf_size
+    ) const {
+        out.clear();
+
+        const auto root = this->root();
+        if (0 == root.count_)
+            return;
+
+        // Children are pushed in reverse so the output stays in Morton order
+        std::vector<Node> stack{ root };
+        std::vector<Node> children;
+        while (!stack.empty()) {
+            const auto node = stack.back();
+            stack.pop_back();
+
+            const auto can_refine = node.level_ < MAX_LEVEL &&
+                                    node.count_ > leaf_size;
+            if (can_refine && refine(node)) {
+                this->get_children(children, node);
+                stack.insert(stack.end(), children.rbegin(), children.rend());
+            } else {
+                out.push_back(node);
+            }
+        }
+    }
+
+    void PointOctree::select_lod(
+        std::vector<Node>& out,
+        const Vec3& eye,
+        double threshold,
+        size_t leaf_size
+    ) const {
+        const auto refine = [&](const Node& node) {
+            const auto diag = (node.aabb_.maxi() - node.aabb_.mini()).len();
+            const auto dist = ::calc_dist(node.aabb_, eye);
+            if (dist <= 0)
+                return true;
+            return diag / dist > threshold;
+        };
+        this->select_lod(out, refine, leaf_size);
+    }
+
+    void PointOctree::sample_node(
+        std::vector<Vec3>& out, const Node& node, size_t max_count
+    ) const {
+        if (node.count_ <= max_count) {
+            this->get_points(out, node);
+            return;
+        }
+
+        out.clear();
+        out.reserve(max_count);
+        const auto shift = 3 * (MAX_LEVEL - node.level_);
+        const auto lo = node.code_ << shift;
+        const auto hi = (node.code_ + 1) << shift;
+
+        // Each run gets its share of `max_count`, spread over its range
+        size_t seen = 0;
+        for (const auto& run : runs_) {
+            const auto first = run.lower_bound(lo);
+            const auto count = run.lower_bound(hi) - first;
+            const auto begin = seen * max_count / node.count_;
+            seen += count;
+            const auto take = seen * max_count / node.count_ - begin;
+            for (size_t i = 0; i < take; ++i) {
+                const auto offset = i * count / take;
+                out.push_back(run.data()[first + offset].point_);
+            }
+        }
+    }
+
+    uint64_t PointOctree::calc_code(const Vec3& p) const {
+        uint32_t cell[3];
+        for (size_t i = 0; i < 3; ++i) {
+            const auto t = (p[i] - aabb_.mini()[i]) * scale_[i];
+            const auto clamped = sung::clamp<double>(
+                std::floor(t), 0, static_cast<double>(CELL_COUNT - 1)
+            );
+            cell[i] = static_cast<uint32_t>(clamped);
+        }
+        return morton_encode_3d(cell[0], cell[1], cell[2]);
+    }
+
+    void PointOctree::set_aabb(const Aabb3& aabb) {
+        aabb_ = aabb;
+
+        const auto extent = aabb.maxi() - aabb.mini();
+        for (size_t i = 0; i < 3; ++i) {
+            if (extent[i] > 0)
+                scale_[i] = static_cast<double>(CELL_COUNT) / extent[i];
+            else
+                scale_[i] = 0;
+        }
+    }
+
+    bool PointOctree::add_run(std::vector<Record>& sorted) {
+        Run run;
+        if (!run.alloc(sorted.size(), this->make_scratch_path()))
+            return false;
+
+        std::copy(sorted.begin(), sorted.end(), run.data());
+        run.make_fences();
+        run.advise(AccessHint::random);
+        size_ += run.size();
+        runs_.push_back(std::move(run));
+        return true;
+    }
+
+    bool PointOctree::merge_runs(size_t first) {
+        size_t total = 0;
+        std::vector<const Record*> heads, ends;
+        for (size_t i = first; i < runs_.size(); ++i) {
+            runs_[i].advise(AccessHint::sequential);
+            heads.push_back(runs_[i].data());
+            ends.push_back(runs_[i].data() + runs_[i].size());
+            total += runs_[i].size();
+        }
+
+        Run merged;
+        if (!merged.alloc(total, this->make_scratch_path()))
+            return false;
+
+        auto out = merged.data();
+        while (true) {
+            const auto i = ::find_smallest_head(heads, ends);
+            if (i == heads.size())
+                break;
+            *out++ = *heads[i]++;
+        }
+
+        merged.make_fences();
+        merged.advise(AccessHint::random);
+        runs_.erase(runs_.begin() + first, runs_.end());
+        runs_.push_back(std::move(merged));
+        return true;
+    }
+
+    std::string PointOctree::make_scratch_path() const {
+        if (scratch_prefix_.empty())
+            return std::string{};
+        return scratch_prefix_ + std::to_string(g_scratch_serial++);
+    }
+
+}  // namespace sung
+
+
+// PointOctree::Run
+namespace sung {
+
+    constexpr size_t PointOctree::Run::FENCE_STRIDE;
+
+
+    PointOctree::Run::Run(const Run& other)
+        : memory_(other.data(), other.data() + other.size())
+        , fences_(other.fences_)
+        , size_(other.size_) {}
+
+    PointOctree::Run& PointOctree::Run::operator=(const Run& other) {
+        if (this == &other)
+            return *this;
+
+        scratch_.close();
+        memory_.assign(other.data(), other.data() + other.size());
+        fences_ = other.fences_;
+        size_ = other.size_;
+        return *this;
+    }
+
+    bool PointOctree::Run::alloc(size_t count, const std::string& path) {
+        memory_ = {};
+        scratch_.close();
+        fences_.clear();
+        size_ = 0;
+
+        if (path.empty()) {
+            memory_.resize(count);
+        } else if (!scratch_.create(path, count * sizeof(Record))) {
+            return false;
+        }
+        size_ = count;
+        return true;
+    }
+
+    void PointOctree::Run::make_fences() {
+        const auto records = this->data();
+        fences_.clear();
+        for (size_t i = 0; i < size_; i += FENCE_STRIDE)
+            fences_.push_back(records[i].code_);
+    }
+
+    PointOctree::Record* PointOctree::Run::data() {
+        if (scratch_.is_open())
+            return reinterpret_cast<Record*>(scratch_.data());
+        return memory_.data();
+    }
+
+    const PointOctree::Record* PointOctree::Run::data() const {
+        if (scratch_.is_open())
+            return reinterpret_cast<const Record*>(scratch_.data());
+        return memory_.data();
+    }
+
+    size_t PointOctree::Run::lower_bound(uint64_t code) const {
+        // fences_[f] is the first fence not below `code`, so the answer is
+        // after fence f - 1 and at or before fence f
+        const auto f = static_cast<size_t>(
+            std::lower_bound(fences_.begin(), fences_.end(), code) -
+            fences_.begin()
+        );
+        const auto lo = f > 0 ? (f - 1) * FENCE_STRIDE : 0;
+        const auto hi = (std::min)(f * FENCE_STRIDE, size_);
+
+        const auto records = this->data();
+        const auto found = std::lower_bound(
+            records + lo,
+            records + hi,
+            code,
+            [](const Record& r, uint64_t c) { return r.code_ < c; }
+        );
+        return static_cast<size_t>(found - records);
+    }
+
+    void PointOctree::Run::advise(AccessHint hint) const {
+        if (scratch_.is_open())
+            scratch_.advise(hint);
+    }
+
+}  // namespace sung
@@ -0,0 +1,311 @@
+#include "sung/basic/sample2d.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SUNG_SAMPLE2D_SSE2
+#endif
+
+
+namespace {
+
+    constexpr uint32_t WEIGHT_ONE = 256;
+
+
+    // Two neighboring texels along one axis and the weight of the second
+    struct Tap {
+        size_t i0_ = 0;
+        size_t i1_ = 0;
+        float weight_ = 0;
+        uint32_t weight_fixed_ = 0;
+    };
+
+    Tap make_tap(double coord, size_t size) {
+        const auto texel = coord * static_cast<double>(size);
+        const auto floored = std::floor(texel);
+        const auto frac = texel - floored;
+        const auto last = static_cast<double>(size - 1);
+
+        Tap out;
+        out.i0_ = static_cast<size_t>(sung::clamp<double>(floored, 0, last));
+        out.i1_ = static_cast<size_t>(
+            sung::clamp<double>(floored + 1, 0, last)
+        );
+        out.weight_ = static_cast<float>(frac);
+        out.weight_fixed_ = static_cast<uint32_t>(frac * WEIGHT_ONE + 0.5);
+        return out;
+    }
+
+
+#ifdef SUNG_SAMPLE2D_SSE2
+    // Two 4 byte pixels to 8 lanes of 16 bits
+    __m128i widen_u8x8(uint32_t a, uint32_t b) {
+        const auto packed = _mm_unpacklo_epi32(
+            _mm_cvtsi32_si128(static_cast<int>(a)),
+            _mm_cvtsi32_si128(static_cast<int>(b))
+        );
+        return _mm_unpacklo_epi8(packed, _mm_setzero_si128());
+    }
+#endif
+
+    // Blends the 2x2 texels of rows `r0` and `r1`
+    void blend_u8(
+        uint8_t* out,
+        const uint8_t* r0,
+        const uint8_t* r1,
+        const Tap& tx,
+        const Tap& ty,
+        size_t channels
+    ) {
+        const auto o0 = tx.i0_ * channels;
+        const auto o1 = tx.i1_ * channels;
+        const auto wx = tx.weight_fixed_;
+        const auto wy = ty.weight_fixed_;
+        for (size_t c = 0; c < channels; ++c) {
+            // Fits in 32 bits, 255 * 256 * 256 + 32768
+            const uint32_t top = r0[o0 + c] * (WEIGHT_ONE - wx) +
+                                 r0[o1 + c] * wx;
+            const uint32_t bottom = r1[o0 + c] * (WEIGHT_ONE - wx) +
+                                    r1[o1 + c] * wx;
+            const auto v = top * (WEIGHT_ONE - wy) + bottom * wy;
+            out[c] = static_cast<uint8_t>((v + 32768) >> 16);
+        }
+    }
+
+    void blend(
+        uint8_t* out,
+        const uint8_t* r0,
+        const uint8_t* r1,
+        const Tap& tx,
+        const Tap& ty,
+        size_t channels
+    ) {
+#ifdef SUNG_SAMPLE2D_SSE2
+        if (4 == channels) {
+            uint32_t p00, p10, p01, p11;
+            std::memcpy(&p00, r0 + tx.i0_ * 4, 4);
+            std::memcpy(&p10, r0 + tx.i1_ * 4, 4);
+            std::memcpy(&p01, r1 + tx.i0_ * 4, 4);
+            std::memcpy(&p11, r1 + tx.i1_ * 4, 4);
+
+            // Top row in the low 4 lanes, bottom row in the high 4 lanes
+            const auto left = ::widen_u8x8(p00, p01);
+            const auto right = ::widen_u8x8(p10, p11);
+
+            // Horizontal pass is exact, 255 * 256 still fits in 16 bits
+            const auto wx = static_cast<short>(tx.weight_fixed_);
+            const auto iwx = static_cast<short>(WEIGHT_ONE - wx);
+            const auto h = _mm_add_epi16(
+                _mm_mullo_epi16(left, _mm_set1_epi16(iwx)),
+                _mm_mullo_epi16(right, _mm_set1_epi16(wx))
+            );
+
+            // Vertical pass in 32 bits and a single rounding, like blend_u8
+            const auto wy = static_cast<short>(ty.weight_fixed_);
+            const auto iwy = static_cast<short>(WEIGHT_ONE - wy);
+            const auto w = _mm_set_epi16(wy, wy, wy, wy, iwy, iwy, iwy, iwy);
+            const auto lo = _mm_mullo_epi16(h, w);
+            const auto hi = _mm_mulhi_epu16(h, w);
+            auto v = _mm_add_epi32(
+                _mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi)
+            );
+            v = _mm_srli_epi32(_mm_add_epi32(v, _mm_set1_epi32(32768)), 16);
+            v = _mm_packs_epi32(v, v);
+
+            const auto packed = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+            std::memcpy(out, &packed, 4);
+            return;
+        }
+#endif
+        ::blend_u8(out, r0, r1, tx, ty, channels);
+    }
+
+    void blend(
+        uint16_t* out,
+        const uint16_t* r0,
+        const uint16_t* r1,
+        const Tap& tx,
+        const Tap& ty,
+        size_t channels
+    ) {
+        // In float, as 8 bit weights would be off by up to 256 steps. The
+        // 24 bit mantissa keeps the error within the final rounding.
+        const auto o0 = tx.i0_ * channels;
+        const auto o1 = tx.i1_ * channels;
+        const auto wx = tx.weight_;
+        const auto wy = ty.weight_;
+        for (size_t c = 0; c < channels; ++c) {
+            const float p00 = r0[o0 + c];
+            const float p01 = r1[o0 + c];
+            const auto top = p00 + (static_cast<float>(r0[o1 + c]) - p00) * wx;
+            const auto bottom = p01 +
+                                (static_cast<float>(r1[o1 + c]) - p01) * wx;
+            const auto v = top + (bottom - top) * wy;
+            out[c] = static_cast<uint16_t>(v + 0.5f);
+        }
+    }
+
+    void blend(
+        float* out,
+        const float* r0,
+        const float* r1,
+        const Tap& tx,
+        const Tap& ty,
+        size_t channels
+    ) {
+        const auto o0 = tx.i0_ * channels;
+        const auto o1 = tx.i1_ * channels;
+
+#ifdef SUNG_SAMPLE2D_SSE2
+        if (4 == channels) {
+            const auto wx = _mm_set1_ps(tx.weight_);
+            const auto wy = _mm_set1_ps(ty.weight_);
+            const auto p00 = _mm_loadu_ps(r0 + o0);
+            const auto p10 = _mm_loadu_ps(r0 + o1);
+            const auto p01 = _mm_loadu_ps(r1 + o0);
+            const auto p11 = _mm_loadu_ps(r1 + o1);
+            const auto top = _mm_add_ps(
+                p00, _mm_mul_ps(_mm_sub_ps(p10, p00), wx)
+            );
+            const auto bottom = _mm_add_ps(
+                p01, _mm_mul_ps(_mm_sub_ps(p11, p01), wx)
+            );
+            _mm_storeu_ps(
+                out, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy))
+            );
+            return;
+        }
+#endif
+
+        const auto wx = tx.weight_;
+        const auto wy = ty.weight_;
+        for (size_t c = 0; c < channels; ++c) {
+            const auto top = r0[o0 + c] + (r0[o1 + c] - r0[o0 + c]) * wx;
+            const auto bottom = r1[o0 + c] + (r1[o1 + c] - r1[o0 + c]) * wx;
+            out[c] = top + (bottom - top) * wy;
+        }
+    }
+
+
+    template <typename T>
+    void sample_batch(
+        T* out,
+        const sung::TImageView2D<T>& view,
+        const sung::TVec2<double>* uvs,
+        size_t count
+    ) {
+        const auto channels = view.channels();
+        if (0 == view.x_size() || 0 == view.y_size()) {
+            std::fill(out, out + count * channels, T{ 0 });
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const auto tx = ::make_tap(uvs[i].x(), view.x_size());
+            const auto ty = ::make_tap(uvs[i].y(), view.y_size());
+            ::blend(
+                out + i * channels,
+                view.pixel_ptr(0, ty.i0_),
+                view.pixel_ptr(0, ty.i1_),
+                tx,
+                ty,
+                channels
+            );
+        }
+    }
+
+    template <typename T>
+    void sample_row(
+        T* out,
+        const sung::TImageView2D<T>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    ) {
+        const auto channels = view.channels();
+        if (0 == view.x_size() || 0 == view.y_size()) {
+            std::fill(out, out + count * channels, T{ 0 });
+            return;
+        }
+
+        const auto ty = ::make_tap(v, view.y_size());
+        const auto r0 = view.pixel_ptr(0, ty.i0_);
+        const auto r1 = view.pixel_ptr(0, ty.i1_);
+        for (size_t i = 0; i < count; ++i) {
+            const auto u = u0 + static_cast<double>(i) * du;
+            const auto tx = ::make_tap(u, view.x_size());
+            ::blend(out + i * channels, r0, r1, tx, ty, channels);
+        }
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    void sample_bilinear_clamp_batch(
+        uint8_t* out,
+        const TImageView2D<uint8_t>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    ) {
+        ::sample_batch(out, view, uvs, count);
+    }
+
+    void sample_bilinear_clamp_batch(
+        uint16_t* out,
+        const TImageView2D<uint16_t>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    ) {
+        ::sample_batch(out, view, uvs, count);
+    }
+
+    void sample_bilinear_clamp_batch(
+        float* out,
+        const TImageView2D<float>& view,
+        const TVec2<double>* uvs,
+        size_t count
+    ) {
+        ::sample_batch(out, view, uvs, count);
+    }
+
+    void sample_bilinear_clamp_row(
+        uint8_t* out,
+        const TImageView2D<uint8_t>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    ) {
+        ::sample_row(out, view, u0, du, v, count);
+    }
+
+    void sample_bilinear_clamp_row(
+        uint16_t* out,
+        const TImageView2D<uint16_t>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    ) {
+        ::sample_row(out, view, u0, du, v, count);
+    }
+
+    void sample_bilinear_clamp_row(
+        float* out,
+        const TImageView2D<float>& view,
+        double u0,
+        double du,
+        double v,
+        size_t count
+    ) {
+        ::sample_row(out, view, u0, du, v, count);
+    }
+
+}  // namespace sung
@@ -0,0 +1,145 @@
+#include "sung/basic/sample3d.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "img_internal.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SUNG_SAMPLE3D_SSE2
+#endif
+
+
+namespace {
+
+    // The 8 corners of a trilinear sample, as offsets and weights
+    struct Corners {
+        size_t offsets_[8];
+        float weights_[8];
+    };
+
+    template <typename T>
+    Corners make_corners(
+        const sung::TImageView3D<T>& view,
+        const sung::TVec3<double>& p,
+        sung::AddressMode mode
+    ) {
+        using sung::internal::make_axis_tap;
+        const auto tx = make_axis_tap(p.x(), view.width(), mode);
+        const auto ty = make_axis_tap(p.y(), view.height(), mode);
+        const auto tz = make_axis_tap(p.z(), view.depth(), mode);
+
+        const auto ch = view.channels();
+        const auto row = ch * view.width();
+        const auto slice = row * view.height();
+        const size_t xs[2] = { tx.i0_ * ch, tx.i1_ * ch };
+        const size_t ys[2] = { ty.i0_ * row, ty.i1_ * row };
+        const size_t zs[2] = { tz.i0_ * slice, tz.i1_ * slice };
+
+        const auto fx = static_cast<float>(tx.frac_);
+        const auto fy = static_cast<float>(ty.frac_);
+        const auto fz = static_cast<float>(tz.frac_);
+        const float wx[2] = { 1 - fx, fx };
+        const float wy[2] = { 1 - fy, fy };
+        const float wz[2] = { 1 - fz, fz };
+
+        Corners out;
+        for (size_t i = 0; i < 8; ++i) {
+            const auto dx = i & 1, dy = (i >> 1) & 1, dz = (i >> 2) & 1;
+            out.offsets_[i] = zs[dz] + ys[dy] + xs[dx];
+            out.weights_[i] = wz[dz] * wy[dy] * wx[dx];
+        }
+        return out;
+    }
+
+    template <typename T>
+    void blend(T* out, const T* data, const Corners& corners, size_t ch) {
+        for (size_t c = 0; c < ch; ++c) {
+            float sum = 0;
+            for (size_t i = 0; i < 8; ++i)
+                sum += corners.weights_[i] * data[corners.offsets_[i] + c];
+            out[c] = sung::internal::to_scalar<T>(sum);
+        }
+    }
+
+    void blend(
+        float* out, const float* data, const Corners& corners, size_t ch
+    ) {
+#ifdef SUNG_SAMPLE3D_SSE2
+        if (4 == ch) {
+            auto sum = _mm_setzero_ps();
+            for (size_t i = 0; i < 8; ++i) {
+                const auto texel = _mm_loadu_ps(data + corners.offsets_[i]);
+                const auto w = _mm_set1_ps(corners.weights_[i]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(texel, w));
+            }
+            _mm_storeu_ps(out, sum);
+            return;
+        }
+#endif
+        for (size_t c = 0; c < ch; ++c) {
+            float sum = 0;
+            for (size_t i = 0; i < 8; ++i)
+                sum += corners.weights_[i] * data[corners.offsets_[i] + c];
+            out[c] = sum;
+        }
+    }
+
+    template <typename T>
+    void sample_batch(
+        T* out,
+        const sung::TImageView3D<T>& view,
+        const sung::TVec3<double>* points,
+        size_t count,
+        sung::AddressMode mode
+    ) {
+        const auto ch = view.channels();
+        if (sung::internal::is_empty(view)) {
+            std::fill(out, out + count * ch, T{ 0 });
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const auto corners = ::make_corners(view, points[i], mode);
+            ::blend(out + i * ch, view.data_, corners, ch);
+        }
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    void sample_trilinear_batch(
+        uint8_t* out,
+        const TImageView3D<uint8_t>& view,
+        const TVec3<double>* points,
+        size_t count,
+        AddressMode mode
+    ) {
+        ::sample_batch(out, view, points, count, mode);
+    }
+
+    void sample_trilinear_batch(
+        uint16_t* out,
+        const TImageView3D<uint16_t>& view,
+        const TVec3<double>* points,
+        size_t count,
+        AddressMode mode
+    ) {
+        ::sample_batch(out, view, points, count, mode);
+    }
+
+    void sample_trilinear_batch(
+        float* out,
+        const TImageView3D<float>& view,
+        const TVec3<double>* points,
+        size_t count,
+        AddressMode mode
+    ) {
+        ::sample_batch(out, view, points, count, mode);
+    }
+
+}  // namespace sung
@@ -0,0 +1,151 @@
+#include "sung/basic/space_filling.hpp"
+
+#include <algorithm>
+
+
+namespace {
+
+    constexpr size_t RADIX = 256;
+    // Smallest block a thread sorts on its own
+    constexpr size_t MIN_BLOCK_SIZE = 1 << 16;
+    constexpr size_t MAX_BLOCK_COUNT = 64;
+
+}  // namespace
+
+
+namespace sung {
+
+    uint64_t calc_curve_code(
+        uint32_t x, uint32_t y, uint32_t z, SpaceCurve curve
+    ) {
+        switch (curve) {
+            case SpaceCurve::hilbert:
+                return hilbert_encode_3d(x, y, z, 21);
+            case SpaceCurve::morton:
+            default:
+                return morton_encode_3d_fast(x, y, z);
+        }
+    }
+
+    void radix_sort_pairs(
+        std::vector<uint64_t>& keys,
+        std::vector<uint32_t>& values,
+        ITaskScheduler* sche
+    ) {
+        const auto n = keys.size();
+        if (n < 2)
+            return;
+
+        size_t block_count = 1;
+        if (sche) {
+            block_count = (n + MIN_BLOCK_SIZE - 1) / MIN_BLOCK_SIZE;
+            block_count = (std::min)(block_count, MAX_BLOCK_COUNT);
+        }
+        const auto block_size = (n + block_count - 1) / block_count;
+
+        std::vector<uint64_t> tmp_keys(n);
+        std::vector<uint32_t> tmp_values(n);
+        // Per block histograms, turned into scatter offsets in place
+        std::vector<size_t> offsets(block_count * RADIX);
+
+        for (uint32_t shift = 0; shift < 64; shift += 8) {
+            std::fill(offsets.begin(), offsets.end(), 0);
+
+            parallel_for(
+                block_count,
+                1,
+                [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; ++b) {
+                        const auto lo = b * block_size;
+                        const auto hi = (std::min)(n, lo + block_size);
+                        auto hist = offsets.data() + b * RADIX;
+                        for (size_t i = lo; i < hi; ++i)
+                            ++hist[(keys[i] >> shift) & 0xff];
+                    }
+                },
+                sche
+            );
+
+            // Digit major, then block, so the scatter stays stable
+            size_t sum = 0;
+            bool all_same = false;
+            for (size_t d = 0; d < RADIX; ++d) {
+                size_t digit_count = 0;
+                for (size_t b = 0; b < block_count; ++b) {
+                    auto& slot = offsets[b * RADIX + d];
+                    const auto count = slot;
+                    slot = sum;
+                    sum += count;
+                    digit_count += count;
+                }
+                if (digit_count == n) {
+                    all_same = true;
+                    break;
+                }
+            }
+            if (all_same)
+                continue;
+
+            parallel_for(
+                block_count,
+                1,
+                [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; ++b) {
+                        const auto lo = b * block_size;
+                        const auto hi = (std::min)(n, lo + block_size);
+                        auto offset = offsets.data() + b * RADIX;
+                        for (size_t i = lo; i < hi; ++i) {
+                            const auto digit = (keys[i] >> shift) & 0xff;
+                            const auto dst = offset[digit]++;
+                            tmp_keys[dst] = keys[i];
+                            tmp_values[dst] = values[i];
+                        }
+                    }
+                },
+                sche
+            );
+
+            keys.swap(tmp_keys);
+            values.swap(tmp_values);
+        }
+    }
+
+    void reorder_along_curve(
+        MeshData& mesh, SpaceCurve curve, ITaskScheduler* sche
+    ) {
+        const auto vtx_count = mesh.vertices_.size();
+        std::vector<MeshData::Vec3> positions(vtx_count);
+        for (size_t i = 0; i < vtx_count; ++i)
+            positions[i] = mesh.vertices_[i].pos_;
+
+        std::vector<uint32_t> order;
+        sung::make_curve_order(order, positions, curve, sche);
+        sung::apply_order(mesh.vertices_, order);
+
+        std::vector<size_t> remap(vtx_count);
+        for (size_t i = 0; i < vtx_count; ++i) remap[order[i]] = i;
+        for (auto& idx : mesh.indices_) idx = remap[idx];
+
+        const auto tri_count = mesh.indices_.size() / 3;
+        std::vector<uint64_t> keys(tri_count);
+        std::vector<uint32_t> tris(tri_count);
+        for (size_t i = 0; i < tri_count; ++i) {
+            const auto idx = mesh.indices_.data() + i * 3;
+            keys[i] = (std::min)({ idx[0], idx[1], idx[2] });
+            tris[i] = static_cast<uint32_t>(i);
+        }
+        sung::radix_sort_pairs(keys, tris, sche);
+
+        std::vector<size_t> indices(mesh.indices_.size());
+        for (size_t i = 0; i < tri_count; ++i) {
+            const auto src = size_t{ tris[i] } * 3;
+            for (size_t j = 0; j < 3; ++j)
+                indices[i * 3 + j] = mesh.indices_[src + j];
+        }
+        // Leftover indices that don't make a whole triangle
+        for (size_t i = tri_count * 3; i < indices.size(); ++i)
+            indices[i] = mesh.indices_[i];
+        mesh.indices_.swap(indices);
+    }
+
+}  // namespace sung
@@ -0,0 +1,262 @@
+#include "sung/basic/spatial_hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+    size_t next_pow2(size_t x) {
+        size_t out = 1;
+        while (out < x) out <<= 1;
+        return out;
+    }
+
+    // Doubles have no fractions beyond this anyway. Clamping keeps the
+    // int64_t cast defined, and cell ranges from overflowing.
+    constexpr double MAX_CELL = 4503599627370496.0;  // 2^52
+
+    // Far out and NaN coordinates share the cells at the limits. Items there
+    // still pass the exact tests, they just collide more.
+    int64_t to_cell(double x, double inv_cell_size) {
+        const auto cell = std::floor(x * inv_cell_size);
+        if (!(cell > -MAX_CELL))
+            return static_cast<int64_t>(-MAX_CELL);
+        if (cell > MAX_CELL)
+            return static_cast<int64_t>(MAX_CELL);
+        return static_cast<int64_t>(cell);
+    }
+
+    double calc_dist_sqr(
+        const sung::Aabb3D<double>& aabb, const sung::TVec3<double>& p
+    ) {
+        double out = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const auto mini = aabb.mini()[i];
+            const auto maxi = aabb.maxi()[i];
+            if (p[i] < mini)
+                out += (mini - p[i]) * (mini - p[i]);
+            else if (p[i] > maxi)
+                out += (p[i] - maxi) * (p[i] - maxi);
+        }
+        return out;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    SpatialHashGrid3::SpatialHashGrid3(double cell_size) {
+        this->set_cell_size(cell_size);
+    }
+
+    bool SpatialHashGrid3::set_cell_size(double cell_size) {
+        const auto inv = 1.0 / cell_size;
+        if (!(cell_size > 0) || !std::isfinite(cell_size) ||
+            !std::isfinite(inv))
+            return false;
+
+        cell_size_ = cell_size;
+        inv_cell_size_ = inv;
+        return true;
+    }
+
+    double SpatialHashGrid3::cell_size() const { return cell_size_; }
+
+    void SpatialHashGrid3::build(const Vec3* points, size_t count) {
+        this->prepare_table(count);
+        for (size_t i = 0; i < count; ++i) {
+            const auto b = this->calc_bucket(points[i]);
+            item_bucket_[i] = static_cast<uint32_t>(b);
+            ++start_[b];
+        }
+        this->finish_counting(count);
+
+        pos_.resize(count);
+        idx_.resize(count);
+        radius_.clear();
+        max_radius_ = 0;
+
+        // Walking backwards keeps the input order within each bucket
+        for (size_t i = count; i-- > 0;) {
+            const auto dst = --start_[item_bucket_[i]];
+            pos_[dst] = points[i];
+            idx_[dst] = static_cast<uint32_t>(i);
+        }
+    }
+
+    void SpatialHashGrid3::build(const Sphere3* spheres, size_t count) {
+        this->prepare_table(count);
+        max_radius_ = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto b = this->calc_bucket(spheres[i].pos_);
+            item_bucket_[i] = static_cast<uint32_t>(b);
+            ++start_[b];
+            max_radius_ = (std::max)(max_radius_, spheres[i].radius_);
+        }
+        this->finish_counting(count);
+
+        pos_.resize(count);
+        idx_.resize(count);
+        radius_.resize(count);
+
+        for (size_t i = count; i-- > 0;) {
+            const auto dst = --start_[item_bucket_[i]];
+            pos_[dst] = spheres[i].pos_;
+            radius_[dst] = spheres[i].radius_;
+            idx_[dst] = static_cast<uint32_t>(i);
+        }
+    }
+
+    void SpatialHashGrid3::clear() {
+        pos_.clear();
+        radius_.clear();
+        idx_.clear();
+        start_.clear();
+        item_bucket_.clear();
+        max_radius_ = 0;
+    }
+
+    size_t SpatialHashGrid3::size() const { return idx_.size(); }
+
+    size_t SpatialHashGrid3::bucket_count() const {
+        return start_.empty() ? 0 : start_.size() - 1;
+    }
+
+    void SpatialHashGrid3::query_radius(
+        std::vector<uint32_t>& out, const Vec3& center, double radius
+    ) const {
+        out.clear();
+        if (this->size() == 0)
+            return;
+
+        const auto reach = radius + max_radius_;
+        const Vec3 reach_v{ reach, reach, reach };
+        const Aabb3 range{ center - reach_v, center + reach_v };
+
+        const auto test = [&](size_t i) {
+            const auto dist_sqr = pos_[i].distance_sqr(center);
+            if (radius_.empty())
+                return dist_sqr <= radius * radius;
+            const auto r = radius + radius_[i];
+            return dist_sqr <= r * r;
+        };
+
+        std::vector<size_t> buckets;
+        if (this->collect_buckets(buckets, range)) {
+            for (const auto b : buckets) {
+                for (auto i = start_[b]; i < start_[b + 1]; ++i) {
+                    if (test(i))
+                        out.push_back(idx_[i]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < pos_.size(); ++i) {
+                if (test(i))
+                    out.push_back(idx_[i]);
+            }
+        }
+    }
+
+    void SpatialHashGrid3::query_aabb(
+        std::vector<uint32_t>& out, const Aabb3& aabb
+    ) const {
+        out.clear();
+        if (this->size() == 0)
+            return;
+
+        const Vec3 reach_v{ max_radius_, max_radius_, max_radius_ };
+        const Aabb3 range{ aabb.mini() - reach_v, aabb.maxi() + reach_v };
+
+        const auto test = [&](size_t i) {
+            if (radius_.empty())
+                return aabb.is_inside_cl(pos_[i]);
+            const auto r = radius_[i];
+            return ::calc_dist_sqr(aabb, pos_[i]) <= r * r;
+        };
+
+        std::vector<size_t> buckets;
+        if (this->collect_buckets(buckets, range)) {
+            for (const auto b : buckets) {
+                for (auto i = start_[b]; i < start_[b + 1]; ++i) {
+                    if (test(i))
+                        out.push_back(idx_[i]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < pos_.size(); ++i) {
+                if (test(i))
+                    out.push_back(idx_[i]);
+            }
+        }
+    }
+
+    size_t SpatialHashGrid3::calc_bucket(int64_t x, int64_t y, int64_t z)
+        const {
+        const auto hx = static_cast<uint64_t>(x) * 73856093u;
+        const auto hy = static_cast<uint64_t>(y) * 19349663u;
+        const auto hz = static_cast<uint64_t>(z) * 83492791u;
+        const auto mask = static_cast<uint64_t>(this->bucket_count() - 1);
+        return static_cast<size_t>((hx ^ hy ^ hz) & mask);
+    }
+
+    size_t SpatialHashGrid3::calc_bucket(const Vec3& p) const {
+        return this->calc_bucket(
+            ::to_cell(p.x(), inv_cell_size_),
+            ::to_cell(p.y(), inv_cell_size_),
+            ::to_cell(p.z(), inv_cell_size_)
+        );
+    }
+
+    void SpatialHashGrid3::prepare_table(size_t item_count) {
+        const auto table_size = ::next_pow2(item_count);
+        start_.assign(table_size + 1, 0);
+        item_bucket_.resize(item_count);
+    }
+
+    void SpatialHashGrid3::finish_counting(size_t item_count) {
+        // Inclusive prefix sum so start_[b] points past the end of bucket b.
+        // Scattering decrements it down to the actual start.
+        uint32_t sum = 0;
+        for (size_t b = 0; b < this->bucket_count(); ++b) {
+            sum += start_[b];
+            start_[b] = sum;
+        }
+        start_.back() = static_cast<uint32_t>(item_count);
+    }
+
+    bool SpatialHashGrid3::collect_buckets(
+        std::vector<size_t>& out, const Aabb3& aabb
+    ) const {
+        const auto x0 = ::to_cell(aabb.x_min(), inv_cell_size_);
+        const auto x1 = ::to_cell(aabb.x_max(), inv_cell_size_);
+        const auto y0 = ::to_cell(aabb.y_min(), inv_cell_size_);
+        const auto y1 = ::to_cell(aabb.y_max(), inv_cell_size_);
+        const auto z0 = ::to_cell(aabb.z_min(), inv_cell_size_);
+        const auto z1 = ::to_cell(aabb.z_max(), inv_cell_size_);
+
+        // Visiting more cells than there are buckets is slower than a scan
+        const auto cell_count = static_cast<double>(x1 - x0 + 1) *
+                                static_cast<double>(y1 - y0 + 1) *
+                                static_cast<double>(z1 - z0 + 1);
+        if (cell_count > static_cast<double>(this->bucket_count()))
+            return false;
+
+        out.clear();
+        out.reserve(static_cast<size_t>(cell_count));
+        for (auto z = z0; z <= z1; ++z) {
+            for (auto y = y0; y <= y1; ++y) {
+                for (auto x = x0; x <= x1; ++x) {
+                    out.push_back(this->calc_bucket(x, y, z));
+                }
+            }
+        }
+
+        // Different cells may share a bucket
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return true;
+    }
+
+}  // namespace sung
@@ -1,5 +1,6 @@
 #include "sung/basic/threading.hpp"
 
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <mutex>
@@ -188,6 +189,64 @@ namespace {
         ::TaskList tasks_;
     };
 
+
+    class ParallelForState {
+
+    public:
+        ParallelForState(
+            size_t count, size_t grain, const sung::ParallelForFunc& func
+        )
+            : func_(func)
+            , count_(count)
+            , grain_(grain)
+            , chunk_count_((count + grain - 1) / grain) {}
+
+        size_t chunk_count() const { return chunk_count_; }
+
+        bool is_done() const { return done_ >= chunk_count_; }
+
+        // Returns false if there is no chunk left to take
+        bool run_one() {
+            const auto chunk = next_++;
+            if (chunk >= chunk_count_)
+                return false;
+
+            const auto begin = chunk * grain_;
+            const auto end = (std::min)(begin + grain_, count_);
+            func_(begin, end);
+            ++done_;
+            return true;
+        }
+
+    private:
+        // Not touched once every chunk has been taken, which is before the
+        // caller of parallel_for returns
+        const sung::ParallelForFunc& func_;
+        const size_t count_;
+        const size_t grain_;
+        const size_t chunk_count_;
+        std::atomic_size_t next_{ 0 };
+        std::atomic_size_t done_{ 0 };
+    };
+
+
+    class ParallelForTask : public sung::ITask {
+
+    public:
+        ParallelForTask(std::shared_ptr<ParallelForState> state)
+            : state_(state) {}
+
+        sung::TaskStatus tick() override {
+            if (state_->run_one())
+                return sung::TaskStatus::running;
+            else
+                return sung::TaskStatus::finished;
+        }
+
+    private:
+        std::shared_ptr<ParallelForState> state_;
+    };
+
 }  // namespace
 
 
@@ -268,4 +327,39 @@ namespace sung {
         return std::make_shared<TaskScheduler>(thread_count);
     }
 
+
+    void parallel_for(
+        size_t count,
+        size_t grain,
+        const ParallelForFunc& func,
+        ITaskScheduler* sche
+    ) {
+        if (0 == count)
+            return;
+        if (0 == grain)
+            grain = 1;
+
+        if (nullptr == sche || count <= grain) {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                func(begin, (std::min)(begin + grain, count));
+            }
+            return;
+        }
+
+        auto state = std::make_shared<::ParallelForState>(count, grain, func);
+        const size_t helper_count = (std::min<size_t>)(
+            state->chunk_count() - 1,
+            (std::max<size_t>)(1, std::thread::hardware_concurrency())
+        );
+        for (size_t i = 0; i < helper_count; ++i) {
+            sche->add_task(std::make_shared<::ParallelForTask>(state));
+        }
+
+        while (state->run_one()) {
+        }
+        while (!state->is_done()) {
+            std::this_thread::yield();
+        }
+    }
+
 }  // namespace sung
@@ -0,0 +1,335 @@
+#include "sung/basic/trisoup_bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "sung/basic/mamath.hpp"
+
+
+namespace {
+
+    using Vec3 = sung::TriSoupBvh3::Vec3;
+
+    constexpr uint32_t LEAF_SIZE = 4;
+
+
+    Vec3 normalize_safe(const Vec3& v) {
+        const auto len_sqr = v.len_sqr();
+        if (len_sqr <= 0)
+            return Vec3{ 0, 0, 0 };
+        return v / std::sqrt(len_sqr);
+    }
+
+    double calc_angle(const Vec3& a, const Vec3& b) {
+        const auto n = ::normalize_safe(a).dot(::normalize_safe(b));
+        return sung::acos_safe(n);
+    }
+
+    uint64_t make_edge_key(uint32_t v0, uint32_t v1) {
+        if (v0 > v1)
+            std::swap(v0, v1);
+        return (static_cast<uint64_t>(v0) << 32) | v1;
+    }
+
+    double calc_dist_sqr(const Vec3& mini, const Vec3& maxi, const Vec3& p) {
+        double out = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            if (p[i] < mini[i])
+                out += (mini[i] - p[i]) * (mini[i] - p[i]);
+            else if (p[i] > maxi[i])
+                out += (p[i] - maxi[i]) * (p[i] - maxi[i]);
+        }
+        return out;
+    }
+
+}  // namespace
+
+
+namespace sung {
+
+    void TriSoupBvh3::build(const TriSoup3& soup) {
+        this->clear();
+
+        const auto tri_count = static_cast<uint32_t>(soup.tri_count());
+        if (0 == tri_count)
+            return;
+
+        // Pseudo-normals in the soup's order first
+        std::vector<Vec3> face_normals(tri_count);
+        std::vector<Vec3> vtx_normals(soup.vtx_.size());
+        std::unordered_map<uint64_t, Vec3> edge_normals;
+        tris_.resize(tri_count);
+
+        for (uint32_t i = 0; i < tri_count; ++i) {
+            const auto i0 = soup.idx_[i * 3 + 0];
+            const auto i1 = soup.idx_[i * 3 + 1];
+            const auto i2 = soup.idx_[i * 3 + 2];
+            const auto& a = soup.vtx_[i0];
+            const auto& b = soup.vtx_[i1];
+            const auto& c = soup.vtx_[i2];
+            tris_[i] = Triangle3{ a, b, c };
+
+            const auto n = ::normalize_safe((b - a).cross(c - a));
+            face_normals[i] = n;
+
+            vtx_normals[i0] += n * ::calc_angle(b - a, c - a);
+            vtx_normals[i1] += n * ::calc_angle(c - b, a - b);
+            vtx_normals[i2] += n * ::calc_angle(a - c, b - c);
+
+            edge_normals[::make_edge_key(i0, i1)] += n;
+            edge_normals[::make_edge_key(i1, i2)] += n;
+            edge_normals[::make_edge_key(i2, i0)] += n;
+        }
+
+        tri_idx_.resize(tri_count);
+        for (uint32_t i = 0; i < tri_count; ++i) tri_idx_[i] = i;
+
+        nodes_.reserve(tri_count / LEAF_SIZE * 2 + 1);
+        nodes_.emplace_back();
+        this->build_rec(0, 0, tri_count);
+
+        // Rearrange everything into the leaf order
+        std::vector<Triangle3> soup_order_tris;
+        soup_order_tris.swap(tris_);
+        tris_.resize(tri_count);
+        face_normals_.resize(tri_count);
+        edge_normals_.resize(tri_count * 3);
+        vtx_normals_.resize(tri_count * 3);
+
+        for (uint32_t i = 0; i < tri_count; ++i) {
+            const auto src = tri_idx_[i];
+            const auto i0 = soup.idx_[src * 3 + 0];
+            const auto i1 = soup.idx_[src * 3 + 1];
+            const auto i2 = soup.idx_[src * 3 + 2];
+
+            tris_[i] = soup_order_tris[src];
+            face_normals_[i] = face_normals[src];
+            edge_normals_[i * 3 + 0] = edge_normals[::make_edge_key(i0, i1)];
+            edge_normals_[i * 3 + 1] = edge_normals[::make_edge_key(i1, i2)];
+            edge_normals_[i * 3 + 2] = edge_normals[::make_edge_key(i2, i0)];
+            vtx_normals_[i * 3 + 0] = vtx_normals[i0];
+            vtx_normals_[i * 3 + 1] = vtx_normals[i1];
+            vtx_normals_[i * 3 + 2] = vtx_normals[i2];
+        }
+    }
+
+    void TriSoupBvh3::clear() {
+        nodes_.clear();
+        tris_.clear();
+        tri_idx_.clear();
+        face_normals_.clear();
+        edge_normals_.clear();
+        vtx_normals_.clear();
+    }
+
+    bool TriSoupBvh3::empty() const { return tris_.empty(); }
+
+    size_t TriSoupBvh3::tri_count() const { return tris_.size(); }
+
+    bool TriSoupBvh3::find_closest(ClosestPointInfo& out, const Vec3& p) const {
+        uint32_t leaf_tri;
+        Vec3 barycentric;
+        return this->find_closest_impl(out, leaf_tri, barycentric, p);
+    }
+
+    double TriSoupBvh3::calc_signed_dist(const Vec3& p) const {
+        ClosestPointInfo info;
+        uint32_t leaf_tri;
+        Vec3 barycentric;
+        if (!this->find_closest_impl(info, leaf_tri, barycentric, p))
+            return 0;
+
+        const auto n = this->select_pseudo_normal(leaf_tri, barycentric);
+        if ((p - info.pos_).dot(n) < 0)
+            return -info.distance_;
+        else
+            return info.distance_;
+    }
+
+    void TriSoupBvh3::find_closest_batch(
+        std::vector<ClosestPointInfo>& out,
+        const Vec3* points,
+        size_t count,
+        ITaskScheduler* sche
+    ) const {
+        out.resize(count);
+        sung::parallel_for(
+            count,
+            1024,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (!this->find_closest(out[i], points[i])) {
+                        out[i] = ClosestPointInfo{};
+                        out[i].tri_idx_ = INVALID_TRI_IDX;
+                    }
+                }
+            },
+            sche
+        );
+    }
+
+    void TriSoupBvh3::calc_signed_dist_batch(
+        std::vector<double>& out,
+        const Vec3* points,
+        size_t count,
+        ITaskScheduler* sche
+    ) const {
+        out.resize(count);
+        sung::parallel_for(
+            count,
+            1024,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    out[i] = this->calc_signed_dist(points[i]);
+            },
+            sche
+        );
+    }
+
+    void TriSoupBvh3::build_rec(uint32_t node, uint32_t first, uint32_t count) {
+        Vec3 mini = tris_[tri_idx_[first]].a();
+        Vec3 maxi = mini;
+        Vec3 c_mini{ std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max() };
+        Vec3 c_maxi = -c_mini;
+
+        for (uint32_t i = first; i < first + count; ++i) {
+            const auto& tri = tris_[tri_idx_[i]];
+            const auto centroid = (tri.a() + tri.b() + tri.c()) / 3.0;
+            for (size_t a = 0; a < 3; ++a) {
+                const auto t_min = (std::min)(
+                    { tri.a()[a], tri.b()[a], tri.c()[a] }
+                );
+                const auto t_max = (std::max)(
+                    { tri.a()[a], tri.b()[a], tri.c()[a] }
+                );
+                mini[a] = (std::min)(mini[a], t_min);
+                maxi[a] = (std::max)(maxi[a], t_max);
+                c_mini[a] = (std::min)(c_mini[a], centroid[a]);
+                c_maxi[a] = (std::max)(c_maxi[a], centroid[a]);
+            }
+        }
+
+        nodes_[node].min_ = mini;
+        nodes_[node].max_ = maxi;
+        if (count <= LEAF_SIZE) {
+            nodes_[node].first_ = first;
+            nodes_[node].count_ = count;
+            return;
+        }
+
+        const auto extent = c_maxi - c_mini;
+        size_t axis = 0;
+        if (extent[1] > extent[axis])
+            axis = 1;
+        if (extent[2] > extent[axis])
+            axis = 2;
+
+        const auto half = count / 2;
+        const auto begin = tri_idx_.begin() + first;
+        std::nth_element(
+            begin, begin + half, begin + count, [&](uint32_t l, uint32_t r) {
+                const auto& tl = tris_[l];
+                const auto& tr = tris_[r];
+                return (tl.a()[axis] + tl.b()[axis] + tl.c()[axis]) <
+                       (tr.a()[axis] + tr.b()[axis] + tr.c()[axis]);
+            }
+        );
+
+        const auto child = static_cast<uint32_t>(nodes_.size());
+        nodes_.resize(nodes_.size() + 2);
+        nodes_[node].first_ = child;
+        nodes_[node].count_ = 0;
+        this->build_rec(child, first, half);
+        this->build_rec(child + 1, first + half, count - half);
+    }
+
+    bool TriSoupBvh3::find_closest_impl(
+        ClosestPointInfo& out,
+        uint32_t& leaf_tri,
+        Vec3& barycentric,
+        const Vec3& p
+    ) const {
+        if (nodes_.empty())
+            return false;
+        if (!std::isfinite(p.x()) || !std::isfinite(p.y()) ||
+            !std::isfinite(p.z()))
+            return false;
+
+        auto best = std::numeric_limits<double>::max();
+        leaf_tri = std::numeric_limits<uint32_t>::max();
+        std::array<uint32_t, 64> stack;
+        size_t stack_size = 0;
+        stack[stack_size++] = 0;
+
+        while (stack_size > 0) {
+            const auto& node = nodes_[stack[--stack_size]];
+            if (::calc_dist_sqr(node.min_, node.max_, p) >= best)
+                continue;
+
+            if (node.count_ > 0) {
+                for (auto i = node.first_; i < node.first_ + node.count_; ++i) {
+                    Vec3 bary;
+                    const auto closest = tris_[i].find_closest_point(p, bary);
+                    const auto dist_sqr = closest.distance_sqr(p);
+                    if (dist_sqr < best) {
+                        best = dist_sqr;
+                        out.pos_ = closest;
+                        leaf_tri = i;
+                        barycentric = bary;
+                    }
+                }
+                continue;
+            }
+
+            // Push the nearer child last so it gets visited first
+            const auto& c0 = nodes_[node.first_];
+            const auto& c1 = nodes_[node.first_ + 1];
+            const auto d0 = ::calc_dist_sqr(c0.min_, c0.max_, p);
+            const auto d1 = ::calc_dist_sqr(c1.min_, c1.max_, p);
+            if (d0 < d1) {
+                stack[stack_size++] = node.first_ + 1;
+                stack[stack_size++] = node.first_;
+            } else {
+                stack[stack_size++] = node.first_;
+                stack[stack_size++] = node.first_ + 1;
+            }
+        }
+
+        if (leaf_tri == std::numeric_limits<uint32_t>::max())
+            return false;
+
+        out.distance_ = std::sqrt(best);
+        out.tri_idx_ = tri_idx_[leaf_tri];
+        return true;
+    }
+
+    TriSoupBvh3::Vec3 TriSoupBvh3::select_pseudo_normal(
+        uint32_t tri, const Vec3& barycentric
+    ) const {
+        const auto u = barycentric.x();
+        const auto v = barycentric.y();
+        const auto w = barycentric.z();
+
+        if (v == 0 && w == 0)
+            return vtx_normals_[tri * 3 + 0];
+        if (w == 0 && u == 0)
+            return vtx_normals_[tri * 3 + 1];
+        if (u == 0 && v == 0)
+            return vtx_normals_[tri * 3 + 2];
+
+        if (w == 0)
+            return edge_normals_[tri * 3 + 0];
+        if (u == 0)
+            return edge_normals_[tri * 3 + 1];
+        if (v == 0)
+            return edge_normals_[tri * 3 + 2];
+
+        return face_normals_[tri];
+    }
+
+}  // namespace sung
@@ -0,0 +1,600 @@
+#include "sung/basic/aadd.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/float16.hpp"
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    // Removes the file when going out of scope
+    class TempFile {
+
+    public:
+        explicit TempFile(const char* name) : path_(name) {}
+        ~TempFile() { std::remove(path_.c_str()); }
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+
+    std::vector<char> read_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+
+    TEST(Aadd, Writer) {
+        const TempFile tmp{ "sungtest_aadd_writer.aadd" };
+        const std::string desc = "Streamed grid";
+
+        std::vector<float> data(10007);
+        sung::RandomRealNumGenerator<float> rng{ -1, 1 };
+        for (auto& x : data) x = rng.gen();
+
+        {
+            sung::AaddWriter writer;
+            // Buffer smaller than the header, so every path gets used
+            ASSERT_TRUE(writer.open(
+                tmp.path(), sung::AaddHeader::DataType::float32, 40
+            ));
+            ASSERT_TRUE(writer.add_dimension(0, 1, 97, "X Axis"));
+            ASSERT_TRUE(writer.add_dimension(-5, 5, 103, "Y Axis"));
+            ASSERT_TRUE(writer.set_description(desc));
+
+            sung::RandomIntegerGenerator<size_t> chunk{ 0, 300 };
+            size_t i = 0;
+            while (i < data.size()) {
+                const auto n = (std::min)(chunk.gen(), data.size() - i);
+                ASSERT_TRUE(writer.write_data(data.data() + i, n));
+                i += n;
+            }
+            ASSERT_EQ(writer.data_count(), data.size());
+            ASSERT_FALSE(writer.add_dimension(0, 1, 2, "Late"));
+            ASSERT_FALSE(writer.set_description("Late"));
+            ASSERT_TRUE(writer.close());
+            ASSERT_FALSE(writer.is_open());
+        }
+
+        const auto buffer = ::read_file(tmp.path());
+        const auto dims_size = 2 * sizeof(sung::AaddHeader::Dimension);
+        const auto data_offset = sizeof(sung::AaddHeader) + dims_size +
+                                 desc.size();
+        ASSERT_EQ(buffer.size(), data_offset + data.size() * sizeof(float));
+
+        const auto header = reinterpret_cast<const sung::AaddHeader*>(
+            buffer.data()
+        );
+        ASSERT_TRUE(header->is_magic_valid());
+        ASSERT_EQ(header->dim_count(), 2);
+        ASSERT_EQ(header->desc_len(), desc.size());
+        ASSERT_EQ(header->data_count(), data.size());
+        ASSERT_EQ(header->data_type(), sung::AaddHeader::DataType::float32);
+        ASSERT_EQ(header->comp_method(), sung::AaddHeader::CompMethod::none);
+
+        const auto dims = reinterpret_cast<const sung::AaddHeader::Dimension*>(
+            buffer.data() + sizeof(sung::AaddHeader)
+        );
+        ASSERT_EQ(dims[1].name(), "Y Axis");
+        ASSERT_EQ(dims[1].count(), 103);
+        ASSERT_EQ(dims[1].mini(), -5);
+        ASSERT_EQ(
+            std::string(buffer.data() + data_offset - desc.size(), desc.size()),
+            desc
+        );
+        ASSERT_EQ(
+            0,
+            std::memcmp(
+                buffer.data() + data_offset,
+                data.data(),
+                data.size() * sizeof(float)
+            )
+        );
+    }
+
+
+    TEST(Aadd, WriterNoData) {
+        const TempFile tmp{ "sungtest_aadd_empty.aadd" };
+        sung::AaddWriter writer;
+        ASSERT_FALSE(writer.write_data(nullptr, 0));
+        ASSERT_TRUE(
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float64)
+        );
+        ASSERT_TRUE(writer.close());
+        ASSERT_FALSE(writer.close());
+
+        const auto buffer = ::read_file(tmp.path());
+        ASSERT_EQ(buffer.size(), sizeof(sung::AaddHeader));
+        const auto header = reinterpret_cast<const sung::AaddHeader*>(
+            buffer.data()
+        );
+        ASSERT_TRUE(header->is_magic_valid());
+        ASSERT_EQ(header->data_count(), 0);
+    }
+
+
+    TEST(Aadd, Reader) {
+        const TempFile tmp{ "sungtest_aadd_reader.aadd" };
+        constexpr uint64_t X = 13, Y = 7, Z = 5;
+        std::vector<double> data(X * Y * Z);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<double>(i) * 0.5;
+
+        {
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float64);
+            writer.add_dimension(0, 1, X, "X");
+            writer.add_dimension(0, 2, Y, "Y");
+            writer.add_dimension(0, 3, Z, "Z");
+            // Odd length so the data is not aligned
+            writer.set_description("abc");
+            writer.write_data(data.data(), data.size());
+            ASSERT_TRUE(writer.close());
+        }
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        ASSERT_EQ(reader.header().dim_count(), 3);
+        ASSERT_EQ(reader.dimension(1).name(), "Y");
+        ASSERT_EQ(reader.dimension(2).maxi(), 3);
+        ASSERT_EQ(reader.description(), "abc");
+        ASSERT_EQ(reader.data_size(), data.size() * sizeof(double));
+        reader.advise(sung::AccessHint::random);
+
+        sung::AaddView<float> wrong;
+        ASSERT_FALSE(reader.make_view(wrong));
+        sung::AaddView<double> view;
+        ASSERT_TRUE(reader.make_view(view));
+        ASSERT_EQ(view.dim_count(), 3);
+        ASSERT_EQ(view.size(), data.size());
+        ASSERT_EQ(view.stride(2), X * Y);
+        ASSERT_EQ(nullptr, view.aligned_ptr());
+
+        sung::RandomIntegerGenerator<uint64_t> rng{ 0, 1000 };
+        for (int i = 0; i < 200; ++i) {
+            const uint64_t c[3] = {
+                rng.gen() % X, rng.gen() % Y, rng.gen() % Z
+            };
+            ASSERT_EQ(view.at(c), data[c[0] + X * (c[1] + Y * c[2])]);
+        }
+
+        // A row along Y at x = 4, z = 3
+        const auto row = view.slice(2, 3).slice(0, 4);
+        ASSERT_EQ(row.dim_count(), 1);
+        ASSERT_EQ(row.count(0), Y);
+        for (uint64_t y = 0; y < Y; ++y)
+            ASSERT_EQ(row[y], data[4 + X * (y + Y * 3)]);
+    }
+
+
+    TEST(Aadd, ReaderInvalid) {
+        const TempFile tmp{ "sungtest_aadd_invalid.aadd" };
+        std::vector<float> data(100, 1.f);
+        {
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+            writer.add_dimension(0, 1, 10, "X");
+            writer.add_dimension(0, 1, 11, "Y");
+            writer.write_data(data.data(), data.size());
+        }
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        // Dimensions multiply to 110 but there are 100 values
+        sung::AaddView<float> view;
+        ASSERT_FALSE(reader.make_view(view));
+        reader.close();
+
+        // Truncated
+        auto bytes = ::read_file(tmp.path());
+        {
+            std::ofstream file(tmp.path(), std::ios::binary);
+            file.write(bytes.data(), bytes.size() - 1);
+        }
+        ASSERT_FALSE(reader.open(tmp.path()));
+
+        // Bad magic
+        bytes[0] = 'X';
+        {
+            std::ofstream file(tmp.path(), std::ios::binary);
+            file.write(bytes.data(), bytes.size());
+        }
+        ASSERT_FALSE(reader.open(tmp.path()));
+        ASSERT_FALSE(reader.is_open());
+        ASSERT_EQ(reader.data(), nullptr);
+    }
+
+
+    TEST(Aadd, Compressed) {
+        const TempFile tmp{ "sungtest_aadd_z.aadd" };
+        constexpr size_t COUNT = 100003;
+        constexpr size_t CHUNK = 4096;
+        const auto sche = sung::create_task_scheduler();
+
+        std::vector<float> data(COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            data[i] = std::round(std::sin(i * 0.001f) * 100.f);
+
+        {
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+            writer.add_dimension(0, 1, COUNT, "X");
+            writer.set_description("z");
+            ASSERT_TRUE(writer.set_compression(
+                sung::AaddHeader::CompMethod::z, sche.get(), CHUNK
+            ));
+            for (size_t i = 0; i < COUNT; i += 1000)
+                writer.write_data(
+                    data.data() + i, (std::min<size_t>)(1000, COUNT - i)
+                );
+            ASSERT_TRUE(writer.close());
+        }
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        ASSERT_EQ(
+            reader.header().comp_method(), sung::AaddHeader::CompMethod::z
+        );
+        ASSERT_EQ(reader.description(), "z");
+        ASSERT_EQ(reader.data(), nullptr);
+        ASSERT_EQ(reader.data_size(), COUNT * sizeof(float));
+        ASSERT_EQ(reader.chunk_count(), (COUNT + CHUNK - 1) / CHUNK);
+        ASSERT_EQ(reader.chunk_size(reader.chunk_count() - 1), COUNT % CHUNK);
+        sung::AaddView<float> view;
+        ASSERT_FALSE(reader.make_view(view));
+
+        // Much smaller than the data
+        const auto file_size = ::read_file(tmp.path()).size();
+        ASSERT_LT(file_size, COUNT * sizeof(float) / 4);
+
+        std::vector<float> out(COUNT);
+        ASSERT_TRUE(reader.read_data(out.data(), sche.get()));
+        ASSERT_EQ(out, data);
+
+        std::vector<float> chunk(CHUNK);
+        ASSERT_TRUE(reader.read_chunk(7, chunk.data()));
+        ASSERT_EQ(0, std::memcmp(
+            chunk.data(), data.data() + 7 * CHUNK, CHUNK * sizeof(float)
+        ));
+        ASSERT_FALSE(reader.read_chunk(reader.chunk_count(), chunk.data()));
+        reader.close();
+
+        // Noisy data, where chunks may not shrink and get stored as is
+        {
+            sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+            std::vector<double> noise(1000);
+            for (auto& x : noise) x = rng.gen();
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float64);
+            writer.set_compression(
+                sung::AaddHeader::CompMethod::z, nullptr, 300
+            );
+            writer.write_data(noise.data(), noise.size());
+            ASSERT_TRUE(writer.close());
+
+            ASSERT_TRUE(reader.open(tmp.path()));
+            std::vector<double> back(noise.size());
+            ASSERT_TRUE(reader.read_data(back.data(), nullptr));
+            ASSERT_EQ(back, noise);
+        }
+    }
+
+
+    TEST(Aadd, CompressedCorrupt) {
+        const TempFile tmp{ "sungtest_aadd_z_bad.aadd" };
+        std::vector<double> data(5000);
+        for (size_t i = 0; i < data.size(); ++i) data[i] = double(i / 10);
+        {
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float64);
+            writer.set_compression(
+                sung::AaddHeader::CompMethod::z, nullptr, 512
+            );
+            writer.write_data(data.data(), data.size());
+        }
+        const auto bytes = ::read_file(tmp.path());
+        const auto write = [&](const std::vector<char>& b) {
+            std::ofstream file(tmp.path(), std::ios::binary);
+            file.write(b.data(), b.size());
+        };
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        reader.close();
+
+        // Index offset past the end
+        auto bad = bytes;
+        bad[sizeof(sung::AaddHeader) + 15] = 0x7F;
+        write(bad);
+        ASSERT_FALSE(reader.open(tmp.path()));
+
+        // Index entries out of order
+        bad = bytes;
+        bad[bad.size() - 9] = 0x7F;
+        write(bad);
+        ASSERT_FALSE(reader.open(tmp.path()));
+
+        // Broken chunk content opens but fails to decode. Chunk 0 follows
+        // chunk_elements and index_offset, and starts with a token byte.
+        // All ones there asks for more literals than the chunk holds.
+        bad = bytes;
+        const auto chunk0 = sizeof(sung::AaddHeader) + 16;
+        for (size_t i = 0; i < 8; ++i) bad[chunk0 + i] = char(0xFF);
+        write(bad);
+        ASSERT_TRUE(reader.open(tmp.path()));
+        ASSERT_GT(reader.chunk_count(), 1);
+        std::vector<double> out(data.size());
+        ASSERT_FALSE(reader.read_chunk(0, out.data()));
+        ASSERT_TRUE(reader.read_chunk(1, out.data()));
+        ASSERT_FALSE(reader.read_data(out.data(), nullptr));
+        reader.close();
+
+        // Data shorter than a chunk is written as one chunk of it all
+        {
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float64);
+            writer.set_compression(
+                sung::AaddHeader::CompMethod::z, nullptr, 512
+            );
+            writer.write_data(data.data(), 4);
+        }
+        ASSERT_TRUE(reader.open(tmp.path()));
+        ASSERT_EQ(reader.chunk_elements(), 4);
+        reader.close();
+
+        // 2^61 elements per chunk, bigger than the data and than size_t
+        // can count in bytes
+        bad = ::read_file(tmp.path());
+        bad[sizeof(sung::AaddHeader) + 7] = 0x20;
+        write(bad);
+        ASSERT_FALSE(reader.open(tmp.path()));
+    }
+
+
+    TEST(Aadd, DataTypes) {
+        using DataType = sung::AaddHeader::DataType;
+        const DataType types[] = {
+            DataType::int8,   DataType::int16,   DataType::int32,
+            DataType::int64,  DataType::uint8,   DataType::uint16,
+            DataType::uint32, DataType::uint64,  DataType::float16,
+            DataType::float32, DataType::float64,
+        };
+        const uint64_t sizes[] = { 1, 2, 4, 8, 1, 2, 4, 8, 2, 4, 8 };
+
+        // Exact in every type, along with out of range values to clamp
+        const std::vector<double> values = {
+            0, 1, 2, 100, 127, -3, 1e30, -1e30,
+        };
+        for (size_t t = 0; t < 11; ++t) {
+            const auto type = types[t];
+            ASSERT_EQ(sung::AaddHeader::get_data_type_size(type), sizes[t]);
+            sung::AaddHeader header;
+            header.init(0, 0, 10, type, sung::AaddHeader::CompMethod::none);
+            ASSERT_EQ(header.mem_size(), 10 * sizes[t]);
+
+            std::vector<sung::byte8> bytes(values.size() * sizes[t] + 1);
+            // Off by one byte to test unaligned access
+            ASSERT_TRUE(sung::encode_aadd_values(
+                bytes.data() + 1, type, values.data(), values.size()
+            ));
+            std::vector<double> back(values.size());
+            ASSERT_TRUE(sung::decode_aadd_values(
+                back.data(), bytes.data() + 1, values.size(), type
+            ));
+            for (size_t i = 0; i < 5; ++i) ASSERT_EQ(back[i], values[i]);
+
+            const auto is_unsigned = t >= 4 && t <= 7;
+            ASSERT_EQ(back[5], is_unsigned ? 0 : -3);
+            if (t < 8) {
+                ASSERT_LT(back[6], 1e30);
+                ASSERT_GT(back[7], -1e30);
+            }
+        }
+
+        // Saturation at the type limits
+        std::vector<sung::byte8> bytes(8);
+        const double big = 1e19;
+        sung::encode_aadd_values(bytes.data(), DataType::int64, &big, 1);
+        int64_t i64;
+        std::memcpy(&i64, bytes.data(), 8);
+        ASSERT_EQ(i64, INT64_MAX);
+        const float nan = std::nanf("");
+        sung::encode_aadd_values(bytes.data(), DataType::uint16, &nan, 1);
+        ASSERT_EQ(bytes[0] | bytes[1], 0);
+        const float f = 300.6f;
+        sung::encode_aadd_values(bytes.data(), DataType::uint8, &f, 1);
+        ASSERT_EQ(bytes[0], 255);
+        sung::encode_aadd_values(bytes.data(), DataType::int16, &f, 1);
+        int16_t i16;
+        std::memcpy(&i16, bytes.data(), 2);
+        ASSERT_EQ(i16, 301);
+    }
+
+
+    TEST(Aadd, Float16File) {
+        const TempFile tmp{ "sungtest_aadd_f16.aadd" };
+        const auto sche = sung::create_task_scheduler();
+        constexpr size_t COUNT = 50000;
+        std::vector<float> data(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) data[i] = std::sin(i * 0.01f);
+
+        for (auto method : { sung::AaddHeader::CompMethod::none,
+                             sung::AaddHeader::CompMethod::z }) {
+            {
+                sung::AaddWriter writer;
+                writer.open(tmp.path(), sung::AaddHeader::DataType::float16);
+                writer.set_compression(method, sche.get(), 5000);
+                ASSERT_TRUE(writer.write_values(data.data(), COUNT));
+                ASSERT_TRUE(writer.close());
+            }
+
+            sung::AaddReader reader;
+            ASSERT_TRUE(reader.open(tmp.path()));
+            ASSERT_EQ(reader.data_size(), COUNT * 2);
+            std::vector<float> back(COUNT);
+            ASSERT_TRUE(reader.read_values(back.data(), sche.get()));
+            std::vector<double> back64(COUNT);
+            ASSERT_TRUE(reader.read_values(back64.data(), nullptr));
+            for (size_t i = 0; i < COUNT; ++i) {
+                ASSERT_NEAR(back[i], data[i], 1e-3);
+                ASSERT_EQ(back64[i], back[i]);
+            }
+        }
+    }
+
+
+    TEST(Aadd, DISABLED_Float16Benchmark) {
+        constexpr size_t COUNT = 1 << 24;
+        std::vector<float> data(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) data[i] = std::sin(i * 0.001f);
+        std::vector<sung::byte8> bytes(COUNT * 2);
+        std::vector<float> back(COUNT);
+
+        // One value at a time with the scalar conversion
+        sung::MonotonicRealtimeTimer timer;
+        for (size_t i = 0; i < COUNT; ++i) {
+            const auto bits = sung::float32_to_float16(data[i]);
+            std::memcpy(bytes.data() + i * 2, &bits, 2);
+        }
+        for (size_t i = 0; i < COUNT; ++i) {
+            uint16_t bits;
+            std::memcpy(&bits, bytes.data() + i * 2, 2);
+            back[i] = sung::float16_to_float32(bits);
+        }
+        const auto scalar_time = timer.check_get_elapsed();
+
+        const auto f16 = sung::AaddHeader::DataType::float16;
+        sung::encode_aadd_values(bytes.data(), f16, data.data(), COUNT);
+        sung::decode_aadd_values(back.data(), bytes.data(), COUNT, f16);
+        const auto bulk_time = timer.elapsed();
+
+        std::cout << "float16 round trip of 16M values, scalar: "
+                  << scalar_time << " sec, bulk: " << bulk_time << " sec"
+                  << std::endl;
+    }
+
+
+    TEST(Aadd, DISABLED_ReaderBenchmark) {
+        constexpr size_t COUNT = 1 << 24;
+        constexpr int QUERIES = 100000;
+        const TempFile tmp{ "sungtest_aadd_reader_bench.aadd" };
+        {
+            std::vector<float> data(COUNT);
+            for (size_t i = 0; i < COUNT; ++i)
+                data[i] = static_cast<float>(i % 1000);
+            sung::AaddWriter writer;
+            writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+            writer.add_dimension(0, 1, 4096, "X");
+            writer.add_dimension(0, 1, COUNT / 4096, "Y");
+            writer.write_data(data.data(), data.size());
+        }
+
+        std::vector<uint64_t> indices(QUERIES);
+        sung::RandomIntegerGenerator<uint64_t> rng{ 0, COUNT - 1 };
+        for (auto& x : indices) x = rng.gen();
+
+        // Reading the whole file in first, as densify's test does
+        sung::MonotonicRealtimeTimer timer;
+        const auto bytes = ::read_file(tmp.path());
+        const auto offset = bytes.size() - COUNT * sizeof(float);
+        double sum_read = 0;
+        for (auto i : indices) {
+            float v;
+            std::memcpy(&v, bytes.data() + offset + i * sizeof(float), 4);
+            sum_read += v;
+        }
+        const auto read_time = timer.check_get_elapsed();
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        sung::AaddView<float> view;
+        ASSERT_TRUE(reader.make_view(view));
+        const auto open_time = timer.check_get_elapsed();
+        double sum_map = 0;
+        for (auto i : indices) sum_map += view[i];
+        const auto map_time = timer.elapsed();
+
+        ASSERT_EQ(sum_read, sum_map);
+        std::cout << QUERIES << " random reads from 64 MiB, read whole file: "
+                  << read_time << " sec, mapped: " << map_time
+                  << " sec (open " << open_time << " sec)" << std::endl;
+    }
+
+
+    TEST(Aadd, DISABLED_WriterBenchmark) {
+        constexpr size_t COUNT = 1 << 23;
+        constexpr size_t CHUNK = 64;
+        const TempFile tmp{ "sungtest_aadd_bench.aadd" };
+        std::vector<float> data(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) data[i] = static_cast<float>(i);
+
+        sung::MonotonicRealtimeTimer timer;
+        {
+            // What the writer replaces, with small writes straight to a
+            // stream
+            std::ofstream file(tmp.path(), std::ios::binary);
+            for (size_t i = 0; i < COUNT; i += CHUNK)
+                file.write(
+                    reinterpret_cast<const char*>(data.data() + i),
+                    CHUNK * sizeof(float)
+                );
+        }
+        const auto stream_time = timer.check_get_elapsed();
+
+        sung::AaddWriter writer;
+        writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+        writer.add_dimension(0, 1, COUNT, "X Axis");
+        for (size_t i = 0; i < COUNT; i += CHUNK)
+            writer.write_data(data.data() + i, CHUNK);
+        ASSERT_TRUE(writer.close());
+        const auto writer_time = timer.elapsed();
+
+        const auto sche = sung::create_task_scheduler();
+        timer.check();
+        writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+        writer.set_compression(sung::AaddHeader::CompMethod::z);
+        writer.write_data(data.data(), COUNT);
+        ASSERT_TRUE(writer.close());
+        const auto z_time = timer.check_get_elapsed();
+
+        writer.open(tmp.path(), sung::AaddHeader::DataType::float32);
+        writer.set_compression(sung::AaddHeader::CompMethod::z, sche.get());
+        writer.write_data(data.data(), COUNT);
+        ASSERT_TRUE(writer.close());
+        const auto z_parallel_time = timer.check_get_elapsed();
+
+        sung::AaddReader reader;
+        ASSERT_TRUE(reader.open(tmp.path()));
+        std::vector<float> back(COUNT);
+        ASSERT_TRUE(reader.read_data(back.data(), sche.get()));
+        const auto read_time = timer.elapsed();
+        ASSERT_EQ(back, data);
+
+        std::cout << "Writing 32 MiB in 256 byte chunks, ofstream: "
+                  << stream_time << " sec, AaddWriter: " << writer_time
+                  << " sec" << std::endl;
+        std::cout << "Compressed to " << ::read_file(tmp.path()).size()
+                  << " bytes: " << z_time << " sec, parallel: "
+                  << z_parallel_time << " sec, parallel decode: " << read_time
+                  << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
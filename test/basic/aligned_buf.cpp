@@ -0,0 +1,134 @@
+#include "sung/basic/aligned_buf.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/img.hpp"
+#include "sung/basic/img2d.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    bool is_aligned(const void* ptr, size_t align) {
+        return 0 == reinterpret_cast<uintptr_t>(ptr) % align;
+    }
+
+
+    TEST(AlignedBuf, Alloc) {
+        for (size_t bytes : { 0, 1, 63, 64, 1000, 1 << 20 }) {
+            for (size_t align : { 16, 64, 4096 }) {
+                const auto ptr = sung::alloc_aligned(bytes, align, false);
+                ASSERT_NE(ptr, nullptr);
+                ASSERT_TRUE(::is_aligned(ptr, align));
+                std::memset(ptr, 1, bytes);
+                sung::free_aligned(ptr);
+            }
+        }
+
+        // Not a power of two
+        ASSERT_EQ(sung::alloc_aligned(100, 48, false), nullptr);
+        sung::free_aligned(nullptr);
+
+        // Large allocations are aligned to huge pages
+        const auto huge = sung::alloc_aligned(
+            3 * sung::HUGE_PAGE_SIZE, 64, true
+        );
+        ASSERT_NE(huge, nullptr);
+        ASSERT_TRUE(::is_aligned(huge, sung::HUGE_PAGE_SIZE));
+        sung::free_aligned(huge);
+
+        // Sizes in between huge pages work too
+        const auto odd = sung::alloc_aligned(
+            sung::HUGE_PAGE_SIZE + 100, 64, true
+        );
+        ASSERT_NE(odd, nullptr);
+        std::memset(odd, 1, sung::HUGE_PAGE_SIZE + 100);
+        sung::free_aligned(odd);
+    }
+
+
+    TEST(AlignedBuf, Vector) {
+        sung::ImageBuffer<float> buf;
+        for (size_t i = 0; i < 1000; ++i) {
+            buf.push_back(static_cast<float>(i));
+            ASSERT_TRUE(::is_aligned(buf.data(), sung::SIMD_ALIGNMENT));
+        }
+
+        auto copied = buf;
+        ASSERT_TRUE(::is_aligned(copied.data(), sung::SIMD_ALIGNMENT));
+        ASSERT_EQ(copied, buf);
+
+        // Explicit value still initializes
+        copied.clear();
+        copied.resize(500, 3);
+        for (auto x : copied) ASSERT_EQ(x, 3);
+
+        std::vector<double, sung::AlignedAllocator<double, 256>> wide(10);
+        ASSERT_TRUE(::is_aligned(wide.data(), 256));
+    }
+
+
+    TEST(AlignedBuf, Images) {
+        sung::TAlignedImage3D<float> vol;
+        vol.alloc(4, 13, 7, 5);
+        ASSERT_TRUE(::is_aligned(vol.data_.data(), sung::SIMD_ALIGNMENT));
+        for (auto x : vol.data_) ASSERT_EQ(x, 0);
+
+        sung::TAlignedImage3D<float> uninit;
+        uninit.alloc_uninit(4, 13, 7, 5);
+        ASSERT_EQ(uninit.data_.size(), vol.data_.size());
+
+        // The default storage is a plain std::vector, always zero filled
+        sung::TImage3D<float> plain;
+        plain.alloc_uninit(4, 13, 7, 5);
+        for (auto x : plain.data_) ASSERT_EQ(x, 0);
+        const std::vector<float>& vec = plain.data_;
+        ASSERT_EQ(vec.size(), vol.data_.size());
+
+        sung::Image2D img;
+        img.set_metadata<uint8_t>(3, 17, 9, 5);
+        img.resize_data_to_fit();
+        for (auto x : img.data_) ASSERT_EQ(x, 0);
+    }
+
+
+    TEST(AlignedBuf, DISABLED_Benchmark) {
+        constexpr size_t SIZE = 256;
+        constexpr size_t COUNT = SIZE * SIZE * SIZE * 4;
+
+        // Allocating then writing every texel once
+        sung::MonotonicRealtimeTimer timer;
+        std::vector<float> vec(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) vec[i] = static_cast<float>(i);
+        const auto vec_time = timer.check_get_elapsed();
+
+        sung::TAlignedImage3D<float> zeroed;
+        zeroed.alloc(4, SIZE, SIZE, SIZE);
+        for (size_t i = 0; i < COUNT; ++i)
+            zeroed.data_[i] = static_cast<float>(i);
+        const auto zeroed_time = timer.check_get_elapsed();
+
+        sung::TAlignedImage3D<float> uninit;
+        uninit.alloc_uninit(4, SIZE, SIZE, SIZE);
+        for (size_t i = 0; i < COUNT; ++i)
+            uninit.data_[i] = static_cast<float>(i);
+        const auto uninit_time = timer.elapsed();
+
+        ASSERT_EQ(uninit.data_[COUNT - 1], vec[COUNT - 1]);
+        ASSERT_EQ(zeroed.data_[COUNT - 1], vec[COUNT - 1]);
+        std::cout << "Alloc and fill 256 MiB, std::vector: " << vec_time
+                  << " sec, alloc: " << zeroed_time
+                  << " sec, alloc_uninit: " << uninit_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
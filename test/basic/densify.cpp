@@ -1,10 +1,22 @@
 #include "sung/basic/densify.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
 #include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
 
 #include <gtest/gtest.h>
 
+#include "sung/basic/aadd.hpp"
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
 
 namespace {
 
@@ -82,6 +94,607 @@ namespace {
         std::cout << "Description: '" << description << "'" << std::endl;
     }
 
+
+
+    // Nearest samples on both sides of every record, then the gap rule
+    std::vector<double> reference_fill(
+        const std::vector<std::pair<size_t, double>>& samples, size_t size
+    ) {
+        constexpr auto NONE = SIZE_MAX;
+        std::vector<double> value(size, 0);
+        std::vector<size_t> prev(size, NONE), next(size, NONE);
+        for (const auto& x : samples) {
+            value[x.first] = x.second;
+            prev[x.first] = x.first;
+            next[x.first] = x.first;
+        }
+        for (size_t i = 1; i < size; ++i)
+            if (NONE == prev[i])
+                prev[i] = prev[i - 1];
+        for (size_t i = size - 1; i-- > 0;)
+            if (NONE == next[i])
+                next[i] = next[i + 1];
+
+        std::vector<double> out(size, 0);
+        for (size_t i = 0; i < size; ++i) {
+            const auto p = prev[i], n = next[i];
+            if (NONE == p && NONE == n)
+                continue;
+            else if (NONE == p)
+                out[i] = value[n];
+            else if (NONE == n || p == n)
+                out[i] = value[p];
+            else
+                out[i] = value[p] + (value[n] - value[p]) *
+                                        (double(i) - p) / double(n - p);
+        }
+        return out;
+    }
+
+
+    TEST(Densify, Finalize1D) {
+        const auto sche = sung::create_task_scheduler();
+
+        // No samples at all stays empty
+        sung::DenseDataBuilder none(100);
+        none.finalize_1d(sche.get());
+        std::vector<float> out;
+        none.copy(out);
+        ASSERT_EQ(out, std::vector<float>(100, 0));
+
+        // Spread over several parallel chunks, with whole chunks empty
+        constexpr size_t SIZE = (1 << 20) * 5 + 123;
+        const std::vector<std::pair<size_t, double>> samples = {
+            { 1500000, 10 }, { 1500001, 20 },   { 1700000, -5 },
+            { 4000000, 7 },  { SIZE - 3000, 1 },
+        };
+        for (auto s : { static_cast<sung::ITaskScheduler*>(nullptr),
+                        sche.get() }) {
+            sung::DenseDataBuilder builder(SIZE);
+            for (const auto& x : samples) builder.add_val(x.second, x.first);
+            builder.add_val(30, 1500001);
+            builder.finalize_1d(s);
+
+            auto expected = ::reference_fill(samples, SIZE);
+            // Average of the two values added at 1500001
+            for (size_t i = 1500001; i < 1700000; ++i) {
+                const auto t = (double(i) - 1500001) / (1700000 - 1500001);
+                expected[i] = 25 + (-5 - 25) * t;
+            }
+            std::vector<float> actual;
+            builder.copy(actual);
+            for (size_t i = 0; i < SIZE; ++i)
+                ASSERT_NEAR(actual[i], expected[i], 1e-4) << i;
+        }
+    }
+
+
+    TEST(Densify, DISABLED_Finalize1DBenchmark) {
+        constexpr size_t SIZE = 1 << 25;
+        const auto sche = sung::create_task_scheduler();
+        sung::RandomIntegerGenerator<size_t> rng{ 0, SIZE - 1 };
+        std::vector<size_t> indices(1000);
+        for (auto& x : indices) x = rng.gen();
+
+        double times[2];
+        for (int i = 0; i < 2; ++i) {
+            sung::DenseDataBuilder builder(SIZE);
+            for (auto x : indices) builder.add_val(double(x % 97), x);
+            sung::MonotonicRealtimeTimer timer;
+            builder.finalize_1d(0 == i ? nullptr : sche.get());
+            times[i] = timer.elapsed();
+        }
+
+        std::cout << "finalize_1d of 32M records with 1000 samples: "
+                  << times[0] << " sec, parallel: " << times[1] << " sec"
+                  << std::endl;
+    }
+
+
+    TEST(Densify, Concurrent) {
+        constexpr size_t SIZE = 1000;
+        constexpr size_t THREADS = 4;
+        constexpr size_t PER_THREAD = 20000;
+        const auto sche = sung::create_task_scheduler();
+
+        // Values are small integers so any order of adds sums exactly
+        const auto value = [](size_t t, size_t i) {
+            return static_cast<double>((t * 7 + i) % 13);
+        };
+
+        sung::DenseDataBuilder serial(SIZE), shared(SIZE), merged(SIZE);
+        std::vector<sung::DenseDataBuilder> locals(THREADS);
+        for (size_t t = 0; t < THREADS; ++t) {
+            locals[t].resize(SIZE);
+            for (size_t i = 0; i < PER_THREAD; ++i)
+                serial.add_val(value(t, i), i % SIZE);
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = 0; i < PER_THREAD; ++i) {
+                    shared.add_val_atomic(value(t, i), i % SIZE);
+                    locals[t].add_val(value(t, i), i % SIZE);
+                }
+            });
+        }
+        for (auto& x : threads) x.join();
+        for (const auto& x : locals) ASSERT_TRUE(merged.merge(x, sche.get()));
+        ASSERT_FALSE(merged.merge(sung::DenseDataBuilder(5), nullptr));
+
+        serial.finalize_1d();
+        shared.finalize_1d();
+        merged.finalize_1d();
+        std::vector<float> a, b, c;
+        serial.copy(a);
+        shared.copy(b);
+        merged.copy(c);
+        ASSERT_EQ(a, b);
+        ASSERT_EQ(a, c);
+    }
+
+
+    TEST(Densify, DISABLED_ConcurrentBenchmark) {
+        constexpr size_t SIZE = 1 << 20;
+        constexpr size_t THREADS = 4;
+        constexpr size_t PER_THREAD = 1 << 21;
+
+        const auto run = [&](auto&& func) {
+            sung::MonotonicRealtimeTimer timer;
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < THREADS; ++t) {
+                threads.emplace_back([&, t]() {
+                    size_t idx = t * 7919;
+                    for (size_t i = 0; i < PER_THREAD; ++i) {
+                        idx = (idx * 1103515245 + 12345) % SIZE;
+                        func(t, static_cast<double>(i), idx);
+                    }
+                });
+            }
+            for (auto& x : threads) x.join();
+            return timer.elapsed();
+        };
+
+        sung::DenseDataBuilder builder(SIZE);
+        std::mutex mut;
+        const auto locked_time = run([&](size_t, double v, size_t idx) {
+            std::lock_guard<std::mutex> lock(mut);
+            builder.add_val(v, idx);
+        });
+
+        builder.clear();
+        builder.resize(SIZE);
+        const auto atomic_time = run([&](size_t, double v, size_t idx) {
+            builder.add_val_atomic(v, idx);
+        });
+
+        std::vector<sung::DenseDataBuilder> locals(THREADS);
+        for (auto& x : locals) x.resize(SIZE);
+        const auto local_time = run([&](size_t t, double v, size_t idx) {
+            locals[t].add_val(v, idx);
+        });
+
+        std::cout << THREADS << " threads adding 8M samples, locked: "
+                  << locked_time << " sec, atomic: " << atomic_time
+                  << " sec, per thread: " << local_time << " sec"
+                  << std::endl;
+    }
+
+
+    void expect_same(
+        const sung::ValArrayAnalyzer& a, const sung::ValArrayAnalyzer& b
+    ) {
+        ASSERT_EQ(a.count(), b.count());
+        ASSERT_EQ(a.mini(), b.mini());
+        ASSERT_EQ(a.maxi(), b.maxi());
+        ASSERT_EQ(a.make_arr(), b.make_arr());
+    }
+
+
+    TEST(Densify, AnalyzeArray) {
+        constexpr size_t COUNT = 3000017;
+        const auto sche = sung::create_task_scheduler();
+        sung::RandomRealNumGenerator<double> rng{ -100, 100 };
+
+        struct Element {
+            sung::byte8 pad_[3];
+            double value_;
+        };
+        std::vector<double> values(COUNT);
+        std::vector<float> floats(COUNT);
+        std::vector<Element> elements(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) {
+            floats[i] = static_cast<float>(rng.gen());
+            values[i] = floats[i];
+            elements[i].value_ = floats[i];
+        }
+        values[5] = std::nan("");
+
+        for (const double threshold : { 0.0, 150.0, 1000.0 }) {
+            sung::ValArrayAnalyzer expected, actual;
+            expected.diff_theshold_ = threshold;
+            actual.diff_theshold_ = threshold;
+            for (const auto x : values) expected.notify(x);
+
+            actual.do_array(values.data(), COUNT);
+            ::expect_same(expected, actual);
+            actual.do_array(values.data(), COUNT, sche.get());
+            ::expect_same(expected, actual);
+        }
+
+        sung::ValArrayAnalyzer expected, actual;
+        for (const auto x : floats) expected.notify(x);
+        actual.do_array(floats.data(), COUNT, sche.get());
+        ::expect_same(expected, actual);
+        actual.do_array(
+            reinterpret_cast<const sung::byte8*>(elements.data()),
+            COUNT,
+            sizeof(Element),
+            offsetof(Element, value_),
+            sche.get()
+        );
+        ::expect_same(expected, actual);
+
+        actual.do_array(values.data(), 0);
+        ASSERT_EQ(0, actual.count());
+        actual.do_array(values.data(), 1);
+        ASSERT_EQ(values[0], actual.maxi());
+    }
+
+
+    TEST(Densify, DISABLED_AnalyzeArrayBenchmark) {
+        constexpr size_t COUNT = 1 << 25;
+        const auto sche = sung::create_task_scheduler();
+        std::vector<double> values(COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            values[i] = std::sin(static_cast<double>(i) * 0.001);
+
+        sung::ValArrayAnalyzer analyzer;
+        sung::MonotonicRealtimeTimer timer;
+        for (const auto x : values) analyzer.notify(x);
+        const auto notify_time = timer.check_get_elapsed();
+        analyzer.do_array(values.data(), COUNT);
+        const auto serial_time = timer.check_get_elapsed();
+        analyzer.do_array(values.data(), COUNT, sche.get());
+        const auto parallel_time = timer.elapsed();
+
+        std::cout << "Analyzing 32M doubles, notify: " << notify_time
+                  << " sec, do_array: " << serial_time
+                  << " sec, parallel: " << parallel_time << " sec"
+                  << std::endl;
+    }
+
+
+    TEST(Densify, Histogram) {
+        sung::FixedHistogram hist(0, 10, 5);
+        for (const double x : { -1.0, 0.0, 1.9, 2.0, 9.999, 10.0, 42.0 })
+            hist.notify(x);
+        hist.notify(std::nan(""));
+
+        ASSERT_EQ(1, hist.underflow());
+        ASSERT_EQ(2, hist.overflow());
+        ASSERT_EQ(7, hist.total());
+        ASSERT_EQ(2, hist.bin(0));
+        ASSERT_EQ(1, hist.bin(1));
+        ASSERT_EQ(1, hist.bin(4));
+        ASSERT_DOUBLE_EQ(8, hist.bin_mini(4));
+
+        sung::FixedHistogram other(0, 10, 5), different(0, 10, 4);
+        other.notify(5);
+        ASSERT_TRUE(hist.merge(other));
+        ASSERT_FALSE(hist.merge(different));
+        ASSERT_EQ(1, hist.bin(2));
+        ASSERT_EQ(8, hist.total());
+
+        sung::FixedHistogram uniform(0, 100, 100);
+        for (int i = 0; i < 100000; ++i) uniform.notify((i % 1000) * 0.1);
+        ASSERT_NEAR(50, uniform.quantile(0.5), 0.1);
+        ASSERT_NEAR(90, uniform.quantile(0.9), 0.1);
+    }
+
+
+    TEST(Densify, QuantileSketch) {
+        constexpr size_t COUNT = 1000000;
+        constexpr size_t THREADS = 4;
+        sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+        std::vector<double> values(COUNT);
+        for (auto& x : values) x = rng.gen();
+
+        // Sketches of parts of the stream, as each thread would build
+        sung::QuantileSketch whole, merged;
+        std::vector<sung::QuantileSketch> parts(THREADS);
+        for (size_t i = 0; i < COUNT; ++i) {
+            whole.notify(values[i]);
+            parts[i % THREADS].notify(values[i]);
+        }
+        for (const auto& x : parts) merged.merge(x);
+        whole.notify(std::nan(""));
+
+        std::sort(values.begin(), values.end());
+        for (const auto* sketch : { &whole, &merged }) {
+            ASSERT_EQ(COUNT, sketch->count());
+            ASSERT_EQ(values.front(), sketch->mini());
+            ASSERT_EQ(values.back(), sketch->maxi());
+            ASSERT_LT(sketch->retained(), 4 * sketch->k());
+
+            for (const double q : { 0.01, 0.1, 0.5, 0.9, 0.99 }) {
+                const auto exact = values[static_cast<size_t>(q * COUNT)];
+                ASSERT_NEAR(exact, sketch->quantile(q), 0.02);
+                ASSERT_NEAR(q, sketch->rank(exact), 0.02);
+            }
+        }
+        ASSERT_EQ(values.front(), whole.quantile(0));
+        ASSERT_EQ(values.back(), whole.quantile(1));
+
+        sung::QuantileSketch empty;
+        merged.merge(empty);
+        ASSERT_EQ(COUNT, merged.count());
+        ASSERT_EQ(0, empty.quantile(0.5));
+    }
+
+
+    TEST(Densify, Finalize2D) {
+        sung::DenseDataBuilder builder;
+        builder.resize_nd({ 5, 5 });
+        ASSERT_EQ(builder.size(), 25);
+        ASSERT_EQ(builder.dim_count(), 2);
+
+        const size_t a[] = { 0, 0 }, b[] = { 4, 0 }, c[] = { 0, 4 };
+        builder.add_val_nd(-1, a);
+        builder.add_val_nd(1, a);
+        builder.add_val_nd(4, b);
+        builder.add_val_nd(8, c);
+        const size_t outside[] = { 5, 0 };
+        builder.add_val_nd(100, outside);
+        ASSERT_TRUE(builder.finalize_2d());
+
+        std::vector<float> out;
+        builder.copy(out);
+        const auto at = [&](size_t x, size_t y) { return out[x + 5 * y]; };
+        // Row 0 between samples, row 4 from its one sample, then columns
+        ASSERT_FLOAT_EQ(at(0, 0), 0);
+        ASSERT_FLOAT_EQ(at(2, 0), 2);
+        ASSERT_FLOAT_EQ(at(3, 4), 8);
+        ASSERT_FLOAT_EQ(at(2, 2), 5);
+        ASSERT_FLOAT_EQ(at(4, 1), 5);
+
+        sung::DenseDataBuilder flat(10);
+        ASSERT_FALSE(flat.finalize_2d());
+    }
+
+
+    TEST(Densify, FinalizeND) {
+        const auto sche = sung::create_task_scheduler();
+        sung::DenseDataBuilder serial, parallel;
+        serial.resize_nd({ 17, 9, 13 });
+        parallel.resize_nd({ 17, 9, 13 });
+
+        sung::RandomIntegerGenerator<size_t> rng{ 0, 1000 };
+        for (int i = 0; i < 40; ++i) {
+            const size_t c[] = {
+                rng.gen() % 17, rng.gen() % 9, rng.gen() % 13
+            };
+            const auto v = static_cast<double>(rng.gen());
+            serial.add_val_nd(v, c);
+            parallel.add_val_nd(v, c);
+        }
+        serial.finalize_nd();
+        parallel.finalize_nd(sche.get());
+
+        std::vector<float> a, b;
+        serial.copy(a);
+        parallel.copy(b);
+        ASSERT_EQ(a, b);
+
+        // Same as 1D passes along each axis by hand
+        sung::DenseDataBuilder line(17);
+        line.add_val(3, 2);
+        line.add_val(7, 10);
+        line.finalize_1d();
+        sung::DenseDataBuilder grid;
+        grid.resize_nd({ 17, 1, 1 });
+        const size_t p[] = { 2, 0, 0 }, q[] = { 10, 0, 0 };
+        grid.add_val_nd(3, p);
+        grid.add_val_nd(7, q);
+        grid.finalize_nd(sche.get());
+        line.copy(a);
+        grid.copy(b);
+        ASSERT_EQ(a, b);
+    }
+
+
+    TEST(Densify, DISABLED_FinalizeNDBenchmark) {
+        constexpr size_t SIZE = 192;
+        const auto sche = sung::create_task_scheduler();
+        sung::DenseDataBuilder builder;
+        sung::RandomIntegerGenerator<size_t> rng{ 0, SIZE - 1 };
+        std::vector<size_t> coords(3 * 20000);
+        for (auto& x : coords) x = rng.gen();
+
+        double times[2];
+        for (int i = 0; i < 2; ++i) {
+            builder.resize_nd({ SIZE, SIZE, SIZE });
+            for (size_t j = 0; j < coords.size(); j += 3)
+                builder.add_val_nd(static_cast<double>(j), coords.data() + j);
+            sung::MonotonicRealtimeTimer timer;
+            builder.finalize_nd(0 == i ? nullptr : sche.get());
+            times[i] = timer.elapsed();
+            builder.clear();
+        }
+
+        std::cout << "finalize_nd of a 192^3 grid with 20000 samples: "
+                  << times[0] << " sec, parallel: " << times[1] << " sec"
+                  << std::endl;
+    }
+
+
+    TEST(Densify, Mapped) {
+        const char* const scratch = "sungtest_densify_scratch.bin";
+        const char* const output = "sungtest_densify_mapped.aadd";
+        const auto sche = sung::create_task_scheduler();
+        const std::vector<size_t> shape{ 300, 70, 11 };
+
+        sung::DenseDataBuilder memory, mapped;
+        memory.resize_nd(shape);
+        ASSERT_TRUE(mapped.resize_mapped(shape, scratch));
+        ASSERT_TRUE(mapped.is_mapped());
+        ASSERT_EQ(memory.size(), mapped.size());
+        ASSERT_EQ(shape, mapped.shape());
+
+        // The scratch file has no name once mapped
+        ASSERT_FALSE(std::ifstream(scratch).is_open());
+
+        sung::RandomIntegerGenerator<size_t> rng{ 0, 1000 };
+        for (int i = 0; i < 500; ++i) {
+            const size_t c[] = {
+                rng.gen() % shape[0], rng.gen() % shape[1], rng.gen() % shape[2]
+            };
+            const auto v = static_cast<double>(rng.gen());
+            memory.add_val_nd(v, c);
+            mapped.add_val_nd(v, c);
+        }
+        memory.finalize_nd();
+        mapped.finalize_nd(sche.get());
+
+        std::vector<float> a, b;
+        memory.copy(a);
+        mapped.copy(b);
+        ASSERT_EQ(a, b);
+
+        {
+            sung::AaddWriter writer;
+            const auto type = sung::AaddHeader::DataType::float32;
+            ASSERT_TRUE(writer.open(output, type));
+            for (const auto x : shape) writer.add_dimension(0, 1, x, "axis");
+            ASSERT_TRUE(mapped.write(writer));
+            ASSERT_TRUE(writer.close());
+        }
+        {
+            sung::AaddReader reader;
+            ASSERT_TRUE(reader.open(output));
+            ASSERT_EQ(a.size(), reader.header().data_count());
+            std::vector<float> values(a.size());
+            ASSERT_TRUE(reader.read_values(values.data(), nullptr));
+            ASSERT_EQ(a, values);
+        }
+        std::remove(output);
+
+        // Any other resize goes back to memory
+        mapped.resize(10);
+        ASSERT_FALSE(mapped.is_mapped());
+        ASSERT_EQ(10, mapped.size());
+        ASSERT_FALSE(mapped.resize_mapped({ 4 }, "no/such/dir/scratch.bin"));
+        ASSERT_TRUE(mapped.empty());
+
+        // An existing file is left alone
+        {
+            std::ofstream file(scratch);
+            file << "keep";
+        }
+        ASSERT_FALSE(mapped.resize_mapped({ 4 }, scratch));
+        {
+            std::ifstream file(scratch);
+            std::string content;
+            file >> content;
+            ASSERT_EQ(content, "keep");
+        }
+        std::remove(scratch);
+
+        // Byte size overflows
+        const auto big = (std::numeric_limits<size_t>::max)() / 4;
+        ASSERT_FALSE(mapped.resize_mapped({ big, 8 }, scratch));
+        ASSERT_FALSE(mapped.resize_mapped({ big }, scratch));
+        ASSERT_FALSE(std::ifstream(scratch).is_open());
+    }
+
+
+    TEST(Densify, Copy) {
+        sung::DenseDataBuilder a;
+        a.resize_nd({ 20, 5 });
+        const size_t c0[] = { 3, 1 };
+        const size_t c1[] = { 17, 4 };
+        a.add_val_nd(2, c0);
+        a.add_val_nd(6, c1);
+
+        // Copies are independent of the original
+        sung::DenseDataBuilder b = a;
+        ASSERT_EQ(a.shape(), b.shape());
+        b.add_val_nd(4, c0);
+        a.finalize_nd();
+        b.finalize_nd();
+        std::vector<float> va, vb;
+        a.copy(va);
+        b.copy(vb);
+        ASSERT_EQ(va.size(), vb.size());
+        ASSERT_FLOAT_EQ(va[1 * 20 + 3], 2);
+        ASSERT_FLOAT_EQ(vb[1 * 20 + 3], 3);
+
+        // A mapped builder copies into memory
+        const char* const scratch = "sungtest_densify_copy.bin";
+        sung::DenseDataBuilder mapped;
+        ASSERT_TRUE(mapped.resize_mapped({ 20, 5 }, scratch));
+        mapped.add_val_nd(2, c0);
+        mapped.add_val_nd(6, c1);
+        sung::DenseDataBuilder c{ mapped };
+        ASSERT_FALSE(c.is_mapped());
+        ASSERT_EQ(mapped.shape(), c.shape());
+        c.finalize_nd();
+        std::vector<float> vc;
+        c.copy(vc);
+        ASSERT_EQ(va, vc);
+
+        // Assigning over a mapped builder drops its scratch file
+        mapped = b;
+        ASSERT_FALSE(mapped.is_mapped());
+        std::vector<float> vm;
+        mapped.copy(vm);
+        ASSERT_EQ(vb, vm);
+
+        // Moves keep the mapping
+        ASSERT_TRUE(c.resize_mapped({ 8 }, scratch));
+        sung::DenseDataBuilder d = std::move(c);
+        ASSERT_TRUE(d.is_mapped());
+        ASSERT_EQ(8, d.size());
+    }
+
+
+    TEST(Densify, DISABLED_MappedBenchmark) {
+        constexpr size_t SIZE = 1 << 23;
+        const auto sche = sung::create_task_scheduler();
+        sung::RandomIntegerGenerator<size_t> rng{ 0, SIZE - 1 };
+        std::vector<size_t> indices(SIZE / 64);
+        for (auto& x : indices) x = rng.gen();
+
+        double times[2];
+        for (int i = 0; i < 2; ++i) {
+            sung::MonotonicRealtimeTimer timer;
+            sung::DenseDataBuilder builder;
+            if (0 == i)
+                builder.resize_nd({ SIZE });
+            else
+                builder.resize_mapped({ SIZE }, "sungtest_densify_bench.bin");
+            for (const auto x : indices)
+                builder.add_val(static_cast<double>(x), x);
+            builder.finalize_1d(sche.get());
+
+            sung::AaddWriter writer;
+            writer.open(
+                "sungtest_densify_bench.aadd",
+                sung::AaddHeader::DataType::float32
+            );
+            writer.add_dimension(0, 1, SIZE, "x");
+            builder.write(writer);
+            writer.close();
+            times[i] = timer.elapsed();
+        }
+        std::remove("sungtest_densify_bench.aadd");
+
+        std::cout << "Densifying 8M records to AADD in memory: " << times[0]
+                  << " sec, memory mapped: " << times[1] << " sec"
+                  << std::endl;
+    }
+
 }  // namespace
 
 
@@ -0,0 +1,329 @@
+#include "sung/basic/img_convert.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/float16.hpp"
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    using sung::ChannelSwizzle;
+    using sung::PixelFormat;
+    using sung::PixelScalar;
+
+
+    sung::Image2D make_image(
+        size_t channels, size_t x, size_t y, size_t padding = 0
+    ) {
+        sung::RandomIntegerGenerator<int> rng{ 0, 255 };
+        sung::Image2D img;
+        img.set_metadata<uint8_t>(channels, x, y, padding);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<uint8_t>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<uint8_t>(rng.gen());
+            }
+        }
+        return img;
+    }
+
+    bool same_pixels(const sung::Image2D& a, const sung::Image2D& b) {
+        if (a.x_size() != b.x_size() || a.y_size() != b.y_size())
+            return false;
+        if (a.pixel_bytes() != b.pixel_bytes())
+            return false;
+        const auto row = a.x_size() * a.pixel_bytes();
+        for (size_t y = 0; y < a.y_size(); ++y) {
+            if (0 != std::memcmp(a.pixel_ptr(0, y), b.pixel_ptr(0, y), row))
+                return false;
+        }
+        return true;
+    }
+
+    float srgb_to_linear(float c) {
+        if (c <= 0.04045f)
+            return c / 12.92f;
+        return std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linear_to_srgb(float l) {
+        if (l <= 0.0031308f)
+            return l * 12.92f;
+        return 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+    }
+
+    uint32_t to_bits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+
+    TEST(ImgConvert, Float16) {
+        ASSERT_EQ(sung::float32_to_float16(0.f), 0x0000);
+        ASSERT_EQ(sung::float32_to_float16(-0.f), 0x8000);
+        ASSERT_EQ(sung::float32_to_float16(1.f), 0x3C00);
+        ASSERT_EQ(sung::float32_to_float16(-2.f), 0xC000);
+        ASSERT_EQ(sung::float32_to_float16(0.1f), 0x2E66);
+        ASSERT_EQ(sung::float32_to_float16(65504.f), 0x7BFF);
+        ASSERT_EQ(sung::float32_to_float16(65519.f), 0x7BFF);
+        ASSERT_EQ(sung::float32_to_float16(65520.f), 0x7C00);
+        ASSERT_EQ(sung::float32_to_float16(std::ldexp(1.f, -24)), 0x0001);
+        ASSERT_EQ(sung::float32_to_float16(std::ldexp(1.f, -25)), 0x0000);
+        ASSERT_EQ(sung::float32_to_float16(std::ldexp(1.5f, -25)), 0x0001);
+        ASSERT_EQ(sung::float32_to_float16(INFINITY), 0x7C00);
+        ASSERT_EQ(sung::float16_to_float32(0x3555), 0.333251953125f);
+        ASSERT_TRUE(std::isnan(sung::float16_to_float32(0x7E00)));
+        ASSERT_EQ(sung::float32_to_float16(NAN) & 0x7E00, 0x7E00);
+
+        // Every finite half survives a round trip
+        std::vector<uint16_t> halves(65536);
+        for (size_t i = 0; i < halves.size(); ++i)
+            halves[i] = static_cast<uint16_t>(i);
+        std::vector<float> floats(halves.size());
+        sung::convert_float16_to_float32(
+            floats.data(), halves.data(), halves.size()
+        );
+        std::vector<uint16_t> back(halves.size());
+        sung::convert_float32_to_float16(
+            back.data(), floats.data(), floats.size()
+        );
+        for (size_t i = 0; i < halves.size(); ++i) {
+            const auto f = sung::float16_to_float32(halves[i]);
+            if (std::isnan(f)) {
+                ASSERT_TRUE(std::isnan(floats[i]));
+                continue;
+            }
+            ASSERT_EQ(::to_bits(f), ::to_bits(floats[i]));
+            ASSERT_EQ(back[i], halves[i]);
+        }
+
+        // Bulk rounding matches the scalar function
+        sung::RandomRealNumGenerator<float> rng{ -70000, 70000 };
+        std::vector<float> values(10001);
+        for (auto& v : values) v = rng.gen() * std::pow(2.f, rng.gen() / 3000);
+        std::vector<uint16_t> encoded(values.size());
+        sung::convert_float32_to_float16(
+            encoded.data(), values.data(), values.size()
+        );
+        for (size_t i = 0; i < values.size(); ++i)
+            ASSERT_EQ(encoded[i], sung::float32_to_float16(values[i]));
+    }
+
+
+    TEST(ImgConvert, Srgb) {
+        const PixelFormat srgb8{ PixelScalar::unorm8, true };
+        const PixelFormat linear32{ PixelScalar::float32, false };
+
+        // Every code on gray + alpha
+        sung::Image2D src;
+        src.set_metadata<uint8_t>(2, 256, 1);
+        src.resize_data_to_fit();
+        for (size_t i = 0; i < 256; ++i) {
+            src.pixel_ptr<uint8_t>(i, 0)[0] = static_cast<uint8_t>(i);
+            src.pixel_ptr<uint8_t>(i, 0)[1] = static_cast<uint8_t>(255 - i);
+        }
+
+        sung::Image2D lin;
+        ASSERT_TRUE(sung::convert_image(lin, linear32, 2, src, srgb8, nullptr));
+        for (size_t i = 0; i < 256; ++i) {
+            const auto p = lin.pixel_ptr<float>(i, 0);
+            ASSERT_NEAR(p[0], ::srgb_to_linear(i / 255.f), 1e-6);
+            // Alpha stays linear
+            ASSERT_NEAR(p[1], (255 - i) / 255.f, 1e-6);
+        }
+
+        sung::Image2D back;
+        ASSERT_TRUE(
+            sung::convert_image(back, srgb8, 2, lin, linear32, nullptr)
+        );
+        ASSERT_TRUE(::same_pixels(src, back));
+
+        // Encoding matches rounding the curve
+        sung::RandomRealNumGenerator<float> rng{ 0, 1 };
+        sung::Image2D values;
+        values.set_metadata<float>(1, 10000, 1);
+        values.resize_data_to_fit();
+        for (size_t i = 0; i < 10000; ++i)
+            values.pixel_ptr<float>(i, 0)[0] = rng.gen() * rng.gen();
+        sung::Image2D encoded;
+        ASSERT_TRUE(
+            sung::convert_image(encoded, srgb8, 1, values, linear32, nullptr)
+        );
+        for (size_t i = 0; i < 10000; ++i) {
+            const auto l = values.pixel_ptr<float>(i, 0)[0];
+            const auto expected = std::round(::linear_to_srgb(l) * 255);
+            ASSERT_NEAR(encoded.pixel_ptr<uint8_t>(i, 0)[0], expected, 1);
+        }
+    }
+
+
+    TEST(ImgConvert, Channels) {
+        const PixelFormat u8{ PixelScalar::unorm8, false };
+        const PixelFormat f16{ PixelScalar::float16, false };
+        const PixelFormat u16{ PixelScalar::unorm16, false };
+        const auto sche = sung::create_task_scheduler();
+
+        // RGB with padding to RGBA float16 and back
+        const auto rgb = ::make_image(3, 33, 21, 7);
+        sung::Image2D rgba;
+        ASSERT_TRUE(sung::convert_image(rgba, f16, 4, rgb, u8, sche.get()));
+        ASSERT_EQ(rgba.scalar_bytes(), 2);
+        for (size_t y = 0; y < 21; ++y) {
+            for (size_t x = 0; x < 33; ++x) {
+                const auto p = rgba.pixel_ptr<uint16_t>(x, y);
+                const auto q = rgb.pixel_ptr<uint8_t>(x, y);
+                ASSERT_NEAR(sung::float16_to_float32(p[1]), q[1] / 255.f, 1e-3);
+                ASSERT_EQ(p[3], 0x3C00);
+            }
+        }
+        sung::Image2D back;
+        ASSERT_TRUE(sung::convert_image(back, u8, 3, rgba, f16, sche.get()));
+        ASSERT_TRUE(::same_pixels(rgb, back));
+
+        // Gray expands and gets an opaque alpha
+        const auto gray = ::make_image(1, 9, 4);
+        sung::Image2D gray16;
+        ASSERT_TRUE(sung::convert_image(gray16, u16, 4, gray, u8, nullptr));
+        const auto g = gray.pixel_ptr<uint8_t>(5, 2)[0];
+        const auto p = gray16.pixel_ptr<uint16_t>(5, 2);
+        ASSERT_EQ(p[0], g * 257);
+        ASSERT_EQ(p[2], g * 257);
+        ASSERT_EQ(p[3], 65535);
+
+        // Same format only shuffles
+        sung::Image2D bgr;
+        bgr.set_metadata<uint8_t>(3, 33, 21);
+        bgr.resize_data_to_fit();
+        ASSERT_TRUE(sung::convert_image(
+            bgr, u8, rgb, u8, ChannelSwizzle::make_swap_rb(), nullptr
+        ));
+        const auto swapped = bgr.pixel_ptr<uint8_t>(3, 4);
+        ASSERT_EQ(swapped[0], rgb.pixel_ptr<uint8_t>(3, 4)[2]);
+        ASSERT_EQ(swapped[2], rgb.pixel_ptr<uint8_t>(3, 4)[0]);
+
+        // Size mismatch and bad swizzle
+        sung::Image2D small;
+        small.set_metadata<uint8_t>(3, 4, 4);
+        small.resize_data_to_fit();
+        ASSERT_FALSE(sung::convert_image(
+            small, u8, rgb, u8, ChannelSwizzle::make_swap_rb(), nullptr
+        ));
+        ChannelSwizzle bad;
+        bad.src_ = { 0, 1, 3, 3 };
+        ASSERT_FALSE(sung::convert_image(bgr, u8, rgb, u8, bad, nullptr));
+    }
+
+
+    TEST(ImgConvert, Inplace) {
+        const PixelFormat u8{ PixelScalar::unorm8, false };
+        const PixelFormat srgb8{ PixelScalar::unorm8, true };
+        const PixelFormat f32{ PixelScalar::float32, false };
+        const auto sche = sung::create_task_scheduler();
+        const auto src = ::make_image(4, 45, 37, 12);
+
+        // Same pixel size, in parallel
+        auto img = src;
+        const auto swap = ChannelSwizzle::make_swap_rb();
+        ASSERT_TRUE(
+            sung::convert_image_inplace(img, u8, 4, u8, swap, sche.get())
+        );
+        ASSERT_EQ(img.padding_bytes(), 0);
+        for (size_t y = 0; y < 37; ++y) {
+            for (size_t x = 0; x < 45; ++x) {
+                const auto p = img.pixel_ptr<uint8_t>(x, y);
+                const auto q = src.pixel_ptr<uint8_t>(x, y);
+                ASSERT_EQ(p[0], q[2]);
+                ASSERT_EQ(p[2], q[0]);
+                ASSERT_EQ(p[3], q[3]);
+            }
+        }
+
+        // Shrinking from float to sRGB, matches converting to another image
+        sung::Image2D lin;
+        ASSERT_TRUE(sung::convert_image(lin, f32, 4, src, srgb8, nullptr));
+        sung::Image2D expected;
+        ASSERT_TRUE(sung::convert_image(expected, srgb8, 3, lin, f32, nullptr));
+        const auto to_rgb = ChannelSwizzle::make_default(4, 3);
+        ASSERT_TRUE(
+            sung::convert_image_inplace(lin, srgb8, 3, f32, to_rgb, sche.get())
+        );
+        ASSERT_EQ(lin.data_.size(), 45 * 37 * 3);
+        ASSERT_TRUE(::same_pixels(lin, expected));
+
+        // Growing can't be done in place
+        auto gray = ::make_image(1, 8, 8);
+        ASSERT_FALSE(sung::convert_image_inplace(
+            gray, u8, 3, u8, ChannelSwizzle::make_default(1, 3), nullptr
+        ));
+    }
+
+
+    TEST(ImgConvert, DISABLED_Benchmark) {
+        constexpr size_t SIZE = 2048;
+        const PixelFormat srgb8{ PixelScalar::unorm8, true };
+        const PixelFormat f32{ PixelScalar::float32, false };
+        const auto src = ::make_image(4, SIZE, SIZE);
+
+        // Hand rolled loop with the curve evaluated per channel
+        sung::Image2D naive;
+        naive.set_metadata<float>(4, SIZE, SIZE);
+        naive.resize_data_to_fit();
+        sung::Image2D naive_back;
+        naive_back.set_metadata<uint8_t>(4, SIZE, SIZE);
+        naive_back.resize_data_to_fit();
+        sung::MonotonicRealtimeTimer timer;
+        for (size_t y = 0; y < SIZE; ++y) {
+            for (size_t x = 0; x < SIZE; ++x) {
+                const auto p = src.pixel_ptr<uint8_t>(x, y);
+                auto q = naive.pixel_ptr<float>(x, y);
+                for (size_t c = 0; c < 3; ++c)
+                    q[c] = ::srgb_to_linear(p[c] / 255.f);
+                q[3] = p[3] / 255.f;
+            }
+        }
+        for (size_t y = 0; y < SIZE; ++y) {
+            for (size_t x = 0; x < SIZE; ++x) {
+                const auto p = naive.pixel_ptr<float>(x, y);
+                auto q = naive_back.pixel_ptr<uint8_t>(x, y);
+                for (size_t c = 0; c < 3; ++c) {
+                    const auto s = ::linear_to_srgb(p[c]);
+                    q[c] = static_cast<uint8_t>(std::round(s * 255));
+                }
+                q[3] = static_cast<uint8_t>(std::round(p[3] * 255));
+            }
+        }
+        const auto naive_time = timer.check_get_elapsed();
+
+        sung::Image2D lin, back;
+        sung::convert_image(lin, f32, 4, src, srgb8, nullptr);
+        sung::convert_image(back, srgb8, 4, lin, f32, nullptr);
+        const auto serial_time = timer.check_get_elapsed();
+
+        const auto sche = sung::create_task_scheduler();
+        sung::convert_image(lin, f32, 4, src, srgb8, sche.get());
+        sung::convert_image(back, srgb8, 4, lin, f32, sche.get());
+        const auto parallel_time = timer.elapsed();
+
+        ASSERT_TRUE(::same_pixels(src, back));
+        ASSERT_TRUE(::same_pixels(src, naive_back));
+        std::cout << "sRGB8 -> float -> sRGB8 of 2048^2 RGBA, naive: "
+                  << naive_time << " sec, convert_image: " << serial_time
+                  << " sec, parallel: " << parallel_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
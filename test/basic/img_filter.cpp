@@ -0,0 +1,229 @@
+#include "sung/basic/img_filter.hpp"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    template <typename T>
+    sung::Image2D make_image(
+        size_t channels, size_t x, size_t y, double max_v, size_t padding = 0
+    ) {
+        sung::RandomRealNumGenerator<double> rng{ 0, max_v };
+        sung::Image2D img;
+        img.set_metadata<T>(channels, x, y, padding);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<T>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<T>(rng.gen());
+            }
+        }
+        return img;
+    }
+
+    // Direct 2D sum over the outer product of the kernels, clamped edges
+    template <typename T>
+    double reference(
+        const sung::Image2D& img,
+        const std::vector<float>& kx,
+        const std::vector<float>& ky,
+        int x,
+        int y,
+        size_t c
+    ) {
+        const auto rx = static_cast<int>(kx.size() / 2);
+        const auto ry = static_cast<int>(ky.size() / 2);
+        const auto last_x = static_cast<int>(img.x_size()) - 1;
+        const auto last_y = static_cast<int>(img.y_size()) - 1;
+        double out = 0;
+        for (int j = -ry; j <= ry; ++j) {
+            for (int i = -rx; i <= rx; ++i) {
+                const auto sx = (std::min)((std::max)(x + i, 0), last_x);
+                const auto sy = (std::min)((std::max)(y + j, 0), last_y);
+                const auto v = img.pixel_ptr<T>(sx, sy)[c];
+                out += kx[i + rx] * ky[j + ry] * static_cast<double>(v);
+            }
+        }
+        return out;
+    }
+
+    template <typename T>
+    void compare(
+        const sung::Image2D& dst,
+        const sung::Image2D& src,
+        const std::vector<float>& kx,
+        const std::vector<float>& ky,
+        double tolerance
+    ) {
+        ASSERT_EQ(dst.x_size(), src.x_size());
+        ASSERT_EQ(dst.y_size(), src.y_size());
+        ASSERT_EQ(dst.channels(), src.channels());
+        for (size_t y = 0; y < src.y_size(); ++y) {
+            for (size_t x = 0; x < src.x_size(); ++x) {
+                for (size_t c = 0; c < src.channels(); ++c) {
+                    const auto expected = ::reference<T>(src, kx, ky, x, y, c);
+                    ASSERT_NEAR(dst.pixel_ptr<T>(x, y)[c], expected, tolerance);
+                }
+            }
+        }
+    }
+
+    std::vector<float> make_box_kernel(size_t radius) {
+        const auto width = 2 * radius + 1;
+        return std::vector<float>(width, 1.f / width);
+    }
+
+
+    TEST(ImgFilter, GaussianKernel) {
+        const auto k = sung::make_gaussian_kernel(1.5);
+        ASSERT_EQ(k.size(), 11);
+        double sum = 0;
+        for (size_t i = 0; i < k.size(); ++i) {
+            sum += k[i];
+            ASSERT_FLOAT_EQ(k[i], k[k.size() - 1 - i]);
+        }
+        ASSERT_NEAR(sum, 1, 1e-6);
+        ASSERT_GT(k[5], k[4]);
+
+        ASSERT_EQ(sung::make_gaussian_kernel(2, 2).size(), 5);
+        ASSERT_EQ(sung::make_gaussian_kernel(0), std::vector<float>{ 1 });
+    }
+
+
+    TEST(ImgFilter, Convolve) {
+        const auto sche = sung::create_task_scheduler();
+        const std::vector<float> kx = { -1, 0, 1 };
+        const auto ky = sung::make_gaussian_kernel(1.2);
+
+        const auto f = ::make_image<float>(3, 37, 29, 1, 12);
+        sung::Image2D dst;
+        ASSERT_TRUE(sung::convolve_separable(
+            dst, f.make_view<float>(), kx, ky, sche.get()
+        ));
+        ::compare<float>(dst, f, kx, ky, 1e-5);
+
+        const auto u8 = ::make_image<uint8_t>(4, 41, 23, 255);
+        const auto gauss = sung::make_gaussian_kernel(0.8);
+        ASSERT_TRUE(sung::convolve_separable(
+            dst, u8.make_view<uint8_t>(), gauss, gauss, nullptr
+        ));
+        ::compare<uint8_t>(dst, u8, gauss, gauss, 0.51);
+
+        // Even length
+        ASSERT_FALSE(sung::convolve_separable(
+            dst, u8.make_view<uint8_t>(), { 1, 1 }, gauss, nullptr
+        ));
+    }
+
+
+    TEST(ImgFilter, BoxBlur) {
+        const auto sche = sung::create_task_scheduler();
+
+        const auto f = ::make_image<float>(2, 53, 47, 1, 8);
+        sung::Image2D dst;
+        ASSERT_TRUE(
+            sung::box_blur(dst, f.make_view<float>(), 3, 5, sche.get())
+        );
+        const auto kx = ::make_box_kernel(3);
+        const auto ky = ::make_box_kernel(5);
+        ::compare<float>(dst, f, kx, ky, 1e-4);
+
+        // Window wider than the image
+        const auto u16 = ::make_image<uint16_t>(1, 7, 5, 65535);
+        ASSERT_TRUE(
+            sung::box_blur(dst, u16.make_view<uint16_t>(), 9, 0, nullptr)
+        );
+        ::compare<uint16_t>(dst, u16, ::make_box_kernel(9), { 1 }, 0.51);
+
+        const auto u8 = ::make_image<uint8_t>(4, 64, 64, 255);
+        ASSERT_TRUE(
+            sung::box_blur(dst, u8.make_view<uint8_t>(), 2, 2, nullptr)
+        );
+        sung::Image2D conv;
+        const auto k = ::make_box_kernel(2);
+        ASSERT_TRUE(sung::convolve_separable(
+            conv, u8.make_view<uint8_t>(), k, k, nullptr
+        ));
+        for (size_t i = 0; i < dst.data_.size(); ++i)
+            ASSERT_NEAR(dst.data_[i], conv.data_[i], 1);
+    }
+
+
+    TEST(ImgFilter, BoxBlurLongRows) {
+        // Running sums carried along a long float row
+        const auto f = ::make_image<float>(1, 50000, 2, 1000);
+        sung::Image2D dst;
+        ASSERT_TRUE(sung::box_blur(dst, f.make_view<float>(), 3, 0, nullptr));
+        ::compare<float>(dst, f, ::make_box_kernel(3), { 1 }, 1e-3);
+
+        // Wide uint16 windows sum past 2^24
+        const auto u16 = ::make_image<uint16_t>(1, 3000, 3, 65535);
+        ASSERT_TRUE(
+            sung::box_blur(dst, u16.make_view<uint16_t>(), 200, 1, nullptr)
+        );
+        const auto kx = ::make_box_kernel(200);
+        ::compare<uint16_t>(dst, u16, kx, ::make_box_kernel(1), 0.51);
+    }
+
+
+    TEST(ImgFilter, DISABLED_Benchmark) {
+        constexpr size_t SIZE = 1024;
+        const auto src = ::make_image<uint8_t>(4, SIZE, SIZE, 255);
+        const auto view = src.make_view<uint8_t>();
+        const auto k = sung::make_gaussian_kernel(2);
+        const auto r = static_cast<int>(k.size() / 2);
+
+        // Per-pixel 2D loop with clamped fetches
+        sung::Image2D naive;
+        naive.set_metadata<uint8_t>(4, SIZE, SIZE);
+        naive.resize_data_to_fit();
+        sung::MonotonicRealtimeTimer timer;
+        for (int y = 0; y < static_cast<int>(SIZE); ++y) {
+            for (int x = 0; x < static_cast<int>(SIZE); ++x) {
+                float acc[4] = { 0, 0, 0, 0 };
+                for (int j = -r; j <= r; ++j) {
+                    for (int i = -r; i <= r; ++i) {
+                        const auto sx = (std::max)(x + i, 0);
+                        const auto sy = (std::max)(y + j, 0);
+                        const auto p = view.pixel_ptr(sx, sy);
+                        const auto w = k[i + r] * k[j + r];
+                        for (size_t c = 0; c < 4; ++c) acc[c] += w * p[c];
+                    }
+                }
+                auto out = naive.pixel_ptr<uint8_t>(x, y);
+                for (size_t c = 0; c < 4; ++c)
+                    out[c] = static_cast<uint8_t>(std::round(acc[c]));
+            }
+        }
+        const auto naive_time = timer.check_get_elapsed();
+
+        sung::Image2D dst;
+        sung::convolve_separable(dst, view, k, k, nullptr);
+        const auto sep_time = timer.check_get_elapsed();
+
+        sung::Image2D box;
+        sung::box_blur(box, view, 16, 16, nullptr);
+        const auto box_time = timer.elapsed();
+
+        for (size_t i = 0; i < dst.data_.size(); i += 97)
+            ASSERT_NEAR(dst.data_[i], naive.data_[i], 1);
+        std::cout << "Gaussian sigma 2 on 1024^2 RGBA8, naive 2D: "
+                  << naive_time << " sec, separable: " << sep_time
+                  << " sec, box blur radius 16: " << box_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
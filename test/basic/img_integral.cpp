@@ -0,0 +1,184 @@
+#include "sung/basic/img_integral.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    template <typename T>
+    sung::Image2D make_image(
+        size_t channels, size_t x, size_t y, double max_v, size_t padding = 0
+    ) {
+        sung::RandomRealNumGenerator<double> rng{ 0, max_v };
+        sung::Image2D img;
+        img.set_metadata<T>(channels, x, y, padding);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<T>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<T>(rng.gen());
+            }
+        }
+        return img;
+    }
+
+    // Loops over the region, clipped to the image
+    template <typename Acc, typename T>
+    Acc brute_sum(
+        const sung::TImageView2D<T>& view,
+        const sung::PixelRegion& r,
+        size_t c
+    ) {
+        const auto x = static_cast<int64_t>(view.x_size());
+        const auto y = static_cast<int64_t>(view.y_size());
+        Acc out = 0;
+        for (auto yy = (std::max<int64_t>)(r.y_min(), 0);
+             yy < (std::min)(r.y_max(), y);
+             ++yy) {
+            for (auto xx = (std::max<int64_t>)(r.x_min(), 0);
+                 xx < (std::min)(r.x_max(), x);
+                 ++xx) {
+                out += static_cast<Acc>(view.pixel_ptr(xx, yy)[c]);
+            }
+        }
+        return out;
+    }
+
+    sung::PixelRegion make_region(
+        int64_t x0, int64_t x1, int64_t y0, int64_t y1
+    ) {
+        sung::PixelRegion out;
+        out.set(x0, x1, y0, y1);
+        return out;
+    }
+
+
+    TEST(ImgIntegral, Exact) {
+        const auto sche = sung::create_task_scheduler();
+        const auto img = ::make_image<uint8_t>(3, 67, 45, 255, 9);
+        const auto view = img.make_view<uint8_t>();
+
+        sung::SummedAreaTableI64 sat;
+        ASSERT_TRUE(sat.empty());
+        ASSERT_TRUE(sat.build(view, sche.get()));
+        ASSERT_EQ(sat.width(), 67);
+        ASSERT_EQ(sat.height(), 45);
+        ASSERT_EQ(sat.channels(), 3);
+
+        sung::RandomIntegerGenerator<int64_t> rng{ -10, 80 };
+        int64_t out[3];
+        for (int i = 0; i < 500; ++i) {
+            const auto r = ::make_region(
+                rng.gen(), rng.gen(), rng.gen(), rng.gen()
+            );
+            sat.sum(out, r);
+            for (size_t c = 0; c < 3; ++c) {
+                const auto expected = ::brute_sum<int64_t>(view, r, c);
+                ASSERT_EQ(sat.sum(r, c), expected);
+                ASSERT_EQ(out[c], expected);
+            }
+        }
+
+        // Whole image, empty and fully outside regions
+        const auto all = ::make_region(0, 67, 0, 45);
+        ASSERT_EQ(sat.sum(all, 1), sat.prefix(67, 45, 1));
+        ASSERT_EQ(sat.sum(::make_region(5, 5, 0, 45), 0), 0);
+        ASSERT_EQ(sat.sum(::make_region(70, 90, 0, 45), 0), 0);
+        ASSERT_EQ(sat.mean(::make_region(-9, -1, 0, 45), 0), 0);
+
+        // Serial build gives the same table
+        sung::SummedAreaTableI64 serial;
+        ASSERT_TRUE(serial.build(view, nullptr));
+        ASSERT_EQ(serial.data(), sat.data());
+    }
+
+
+    TEST(ImgIntegral, Wide) {
+        // Full scale 16 bit sums past the 32 bit range
+        sung::Image2D img;
+        img.set_metadata<uint16_t>(1, 300, 300);
+        img.resize_data_to_fit();
+        auto data = reinterpret_cast<uint16_t*>(img.data_.data());
+        std::fill(data, data + 300 * 300, uint16_t(65535));
+
+        sung::SummedAreaTableI64 sat;
+        ASSERT_TRUE(sat.build(img.make_view<uint16_t>(), nullptr));
+        const auto all = ::make_region(0, 300, 0, 300);
+        ASSERT_EQ(sat.sum(all, 0), int64_t(65535) * 300 * 300);
+        ASSERT_DOUBLE_EQ(sat.mean(all, 0), 65535);
+        ASSERT_DOUBLE_EQ(sat.mean(::make_region(-5, 3, 290, 400), 0), 65535);
+    }
+
+
+    TEST(ImgIntegral, Float) {
+        const auto sche = sung::create_task_scheduler();
+        const auto img = ::make_image<float>(2, 129, 77, 1);
+        const auto view = img.make_view<float>();
+
+        sung::SummedAreaTableF64 sat;
+        ASSERT_TRUE(sat.build(view, sche.get()));
+
+        sung::RandomIntegerGenerator<int64_t> rng{ 0, 130 };
+        for (int i = 0; i < 300; ++i) {
+            const auto r = ::make_region(
+                rng.gen(), rng.gen(), rng.gen(), rng.gen()
+            );
+            for (size_t c = 0; c < 2; ++c) {
+                const auto expected = ::brute_sum<double>(view, r, c);
+                ASSERT_NEAR(sat.sum(r, c), expected, 1e-6);
+            }
+        }
+
+        sung::Image2D empty;
+        ASSERT_FALSE(sat.build(empty.make_view<float>(), nullptr));
+        ASSERT_TRUE(sat.empty());
+    }
+
+
+    TEST(ImgIntegral, DISABLED_Benchmark) {
+        constexpr size_t SIZE = 2048;
+        constexpr int QUERIES = 2000;
+        const auto sche = sung::create_task_scheduler();
+        const auto img = ::make_image<uint8_t>(4, SIZE, SIZE, 255);
+        const auto view = img.make_view<uint8_t>();
+
+        std::vector<sung::PixelRegion> regions;
+        sung::RandomIntegerGenerator<int64_t> rng{ 0, SIZE };
+        for (int i = 0; i < QUERIES; ++i)
+            regions.push_back(
+                ::make_region(rng.gen(), rng.gen(), rng.gen(), rng.gen())
+            );
+
+        sung::MonotonicRealtimeTimer timer;
+        int64_t naive = 0;
+        for (const auto& r : regions) naive += ::brute_sum<int64_t>(view, r, 0);
+        const auto naive_time = timer.check_get_elapsed();
+
+        sung::SummedAreaTableI64 sat;
+        sat.build(view, nullptr);
+        const auto serial_time = timer.check_get_elapsed();
+        sat.build(view, sche.get());
+        const auto parallel_time = timer.check_get_elapsed();
+
+        int64_t fast = 0;
+        for (const auto& r : regions) fast += sat.sum(r, 0);
+        const auto query_time = timer.elapsed();
+
+        ASSERT_EQ(naive, fast);
+        std::cout << QUERIES << " region sums on 2048^2 RGBA8, naive: "
+                  << naive_time << " sec, table build: " << serial_time
+                  << " sec (parallel " << parallel_time
+                  << " sec), queries: " << query_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,206 @@
+#include "sung/basic/img_mip.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/sample2d.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    template <typename T>
+    sung::Image2D make_image(size_t channels, size_t x, size_t y, T max_v) {
+        sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+        sung::Image2D img;
+        // Padded rows, kept aligned for T
+        img.set_metadata<T>(channels, x, y, 3 * sizeof(T));
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<T>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<T>(rng.gen() * max_v);
+            }
+        }
+        return img;
+    }
+
+
+    TEST(ImgMip, Layout) {
+        const auto src = ::make_image<uint8_t>(3, 37, 20, 255);
+        sung::TMipChain2D<uint8_t> mip;
+        ASSERT_TRUE(mip.build(src, sung::ResizeFilter::box, true, nullptr));
+
+        const size_t expected[][2] = { { 37, 20 }, { 18, 10 }, { 9, 5 },
+                                       { 4, 2 },   { 2, 1 },   { 1, 1 } };
+        ASSERT_EQ(mip.level_count(), 6);
+
+        const uint8_t* next = mip.data().data();
+        for (size_t i = 0; i < mip.level_count(); ++i) {
+            const auto level = mip.level(i);
+            ASSERT_EQ(level.x_size(), expected[i][0]);
+            ASSERT_EQ(level.y_size(), expected[i][1]);
+            ASSERT_EQ(level.pixel_ptr(0, 0), next);
+            next += level.x_size() * level.y_size() * 3;
+        }
+        ASSERT_EQ(next, mip.data().data() + mip.data().size());
+
+        // Level 0 is an exact copy
+        const auto level0 = mip.level(0);
+        for (size_t y = 0; y < 20; ++y) {
+            for (size_t x = 0; x < 37; ++x) {
+                for (size_t c = 0; c < 3; ++c) {
+                    ASSERT_EQ(
+                        level0.pixel_ptr(x, y)[c],
+                        src.pixel_ptr<uint8_t>(x, y)[c]
+                    );
+                }
+            }
+        }
+
+        ASSERT_FALSE(mip.build(
+            ::make_image<float>(1, 4, 4, 1),
+            sung::ResizeFilter::box,
+            false,
+            nullptr
+        ));
+        ASSERT_TRUE(mip.empty());
+    }
+
+
+    TEST(ImgMip, GammaCorrect) {
+        // Checkerboard of black and white, with alpha
+        sung::Image2D src;
+        src.set_metadata<uint8_t>(4, 16, 16);
+        src.resize_data_to_fit();
+        for (size_t y = 0; y < 16; ++y) {
+            for (size_t x = 0; x < 16; ++x) {
+                const uint8_t v = (x + y) % 2 ? 255 : 0;
+                auto p = src.pixel_ptr<uint8_t>(x, y);
+                p[0] = p[1] = p[2] = p[3] = v;
+            }
+        }
+
+        for (auto filter :
+             { sung::ResizeFilter::box, sung::ResizeFilter::kaiser }) {
+            sung::TMipChain2D<uint8_t> srgb, raw;
+            ASSERT_TRUE(srgb.build(src, filter, true, nullptr));
+            ASSERT_TRUE(raw.build(src, filter, false, nullptr));
+
+            // Kaiser doesn't cancel the checkerboard out exactly
+            const auto tolerance = filter == sung::ResizeFilter::box ? 1 : 8;
+            for (size_t l = 1; l < srgb.level_count(); ++l) {
+                const auto p = srgb.level(l).pixel_ptr(0, 0);
+                // Half the light is about 188 in sRGB, not 128
+                ASSERT_NEAR(p[0], 188, tolerance);
+                ASSERT_NEAR(p[2], 188, tolerance);
+                // Alpha is linear
+                ASSERT_NEAR(p[3], 128, tolerance);
+                ASSERT_NEAR(raw.level(l).pixel_ptr(0, 0)[0], 128, tolerance);
+            }
+        }
+    }
+
+
+    TEST(ImgMip, Sampling) {
+        const auto src = ::make_image<float>(4, 64, 32, 1);
+        sung::TMipChain2D<float> mip;
+        ASSERT_TRUE(mip.build(src, sung::ResizeFilter::box, false, nullptr));
+
+        ASSERT_DOUBLE_EQ(mip.calc_lod(1.0 / 64, 0, 0, 1.0 / 32), 0);
+        ASSERT_DOUBLE_EQ(mip.calc_lod(4.0 / 64, 0, 0, 1.0 / 32), 2);
+
+        sung::RandomRealNumGenerator<double> rng{ -0.1, 1.1 };
+        for (int i = 0; i < 100; ++i) {
+            const auto u = rng.gen(), v = rng.gen();
+            const auto s0 = sung::sample_bilinear_clamp<4, float>(
+                mip.level(0), u, v
+            );
+            const auto s1 = sung::sample_bilinear_clamp<4, float>(
+                mip.level(1), u, v
+            );
+
+            float out[4];
+            mip.sample_trilinear(out, u, v, 0);
+            for (size_t c = 0; c < 4; ++c) ASSERT_NEAR(out[c], s0[c], 1e-5);
+
+            mip.sample_trilinear(out, u, v, 0.25);
+            for (size_t c = 0; c < 4; ++c)
+                ASSERT_NEAR(out[c], s0[c] * 0.75 + s1[c] * 0.25, 1e-5);
+
+            // Isotropic footprint is a single trilinear sample
+            float aniso[4];
+            const auto lod = mip.calc_lod(0.03, 0, 0, 0.06);
+            mip.sample_trilinear(out, u, v, lod);
+            mip.sample_aniso(aniso, u, v, 0.03, 0, 0, 0.06, 16);
+            for (size_t c = 0; c < 4; ++c) ASSERT_NEAR(out[c], aniso[c], 1e-5);
+        }
+
+        // Huge lod is the average of the whole image
+        float out[4];
+        mip.sample_trilinear(out, 0.3, 0.6, 100);
+        const auto last = mip.level(mip.level_count() - 1);
+        for (size_t c = 0; c < 4; ++c)
+            ASSERT_NEAR(out[c], last.pixel_ptr(0, 0)[c], 1e-6);
+    }
+
+
+    TEST(ImgMip, DISABLED_Benchmark) {
+        const auto src = ::make_image<uint8_t>(4, 3840, 2160, 255);
+        auto sche = sung::create_task_scheduler();
+
+        for (auto filter :
+             { sung::ResizeFilter::box, sung::ResizeFilter::kaiser }) {
+            sung::TMipChain2D<uint8_t> mip;
+            sung::MonotonicRealtimeTimer timer;
+            mip.build(src, filter, true, nullptr);
+            const auto serial_time = timer.check_get_elapsed();
+            mip.build(src, filter, true, sche.get());
+            const auto parallel_time = timer.elapsed();
+            std::cout << "4K sRGB mip chain, filter "
+                      << static_cast<int>(filter) << ", serial: " << serial_time
+                      << " sec, parallel: " << parallel_time << " sec"
+                      << std::endl;
+        }
+
+        // Draw the whole texture into 256x256, minified by 15x
+        sung::TMipChain2D<uint8_t> mip;
+        mip.build(src, sung::ResizeFilter::box, true, sche.get());
+        const auto level0 = mip.level(0);
+        const auto d = 1.0 / 256;
+        const auto lod = mip.calc_lod(d, 0, 0, d);
+
+        float sum = 0;
+        sung::MonotonicRealtimeTimer timer;
+        for (size_t y = 0; y < 256; ++y) {
+            for (size_t x = 0; x < 256; ++x) {
+                const auto p = sung::sample_bilinear_clamp<4, uint8_t>(
+                    level0, (x + 0.5) * d, (y + 0.5) * d
+                );
+                sum += p[0];
+            }
+        }
+        const auto bilinear_time = timer.check_get_elapsed();
+        for (size_t y = 0; y < 256; ++y) {
+            for (size_t x = 0; x < 256; ++x) {
+                float p[4];
+                mip.sample_trilinear(p, (x + 0.5) * d, (y + 0.5) * d, lod);
+                sum += p[0];
+            }
+        }
+        const auto trilinear_time = timer.elapsed();
+
+        ASSERT_GT(sum, 0);
+        std::cout << "Minified lookups, bilinear on level 0: " << bilinear_time
+                  << " sec, trilinear: " << trilinear_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,206 @@
+#include "sung/basic/img_raw.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    // Removes the file when going out of scope
+    class TempFile {
+
+    public:
+        explicit TempFile(const char* name) : path_(name) {}
+        ~TempFile() { std::remove(path_.c_str()); }
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+
+    sung::TImage3D<float> make_volume(
+        size_t channels, size_t x, size_t y, size_t z
+    ) {
+        sung::RandomRealNumGenerator<float> rng{ 0, 1 };
+        sung::TImage3D<float> out;
+        out.alloc_uninit(channels, x, y, z);
+        for (auto& v : out.data_) v = rng.gen();
+        return out;
+    }
+
+
+    TEST(ImgRaw, MappedFile) {
+        const TempFile tmp{ "sungtest_img_raw_mapped.bin" };
+        {
+            std::ofstream file(tmp.path(), std::ios::binary);
+            file << "hello mapped file";
+        }
+
+        sung::MappedFile mapped;
+        ASSERT_TRUE(mapped.open(tmp.path()));
+        ASSERT_EQ(mapped.size(), 17);
+        ASSERT_EQ(std::string(mapped.data(), mapped.data() + 5), "hello");
+        mapped.advise(sung::AccessHint::sequential);
+        mapped.advise(sung::AccessHint::willneed, 6, 100);
+
+        // Moving keeps the mapping alive
+        auto moved = std::move(mapped);
+        ASSERT_FALSE(mapped.is_open());
+        ASSERT_TRUE(moved.is_open());
+        ASSERT_EQ(moved.data()[6], 'm');
+
+        {
+            std::ofstream file(tmp.path(), std::ios::binary | std::ios::trunc);
+        }
+        sung::MappedFile empty;
+        ASSERT_TRUE(empty.open(tmp.path()));
+        ASSERT_EQ(empty.size(), 0);
+        ASSERT_EQ(empty.data(), nullptr);
+
+        sung::MappedFile missing;
+        ASSERT_FALSE(missing.open("sungtest_img_raw_missing.bin"));
+        ASSERT_FALSE(missing.is_open());
+    }
+
+
+    TEST(ImgRaw, Image2D) {
+        const TempFile tmp{ "sungtest_img_raw_2d.bin" };
+        sung::RandomIntegerGenerator<int> rng{ 0, 255 };
+
+        sung::Image2D img;
+        img.set_metadata<uint8_t>(3, 31, 17, 5);
+        img.resize_data_to_fit();
+        for (auto& x : img.data_) x = static_cast<sung::byte8>(rng.gen());
+        ASSERT_TRUE(
+            sung::write_raw_image(tmp.path(), img, sung::PixelScalar::unorm8)
+        );
+        ASSERT_FALSE(
+            sung::write_raw_image(tmp.path(), img, sung::PixelScalar::float32)
+        );
+
+        sung::MappedImage mapped;
+        ASSERT_TRUE(mapped.open(tmp.path()));
+        ASSERT_EQ(mapped.width(), 31);
+        ASSERT_EQ(mapped.height(), 17);
+        ASSERT_EQ(mapped.depth(), 1);
+        ASSERT_EQ(mapped.size_bytes(), 31 * 17 * 3);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(mapped.data()) % 64, 0);
+
+        sung::TImageView2D<float> wrong;
+        ASSERT_FALSE(mapped.make_view(wrong));
+        sung::TImageView2D<uint8_t> view;
+        ASSERT_TRUE(mapped.make_view(view));
+        ASSERT_EQ(view.padding_bytes(), 0);
+        for (size_t y = 0; y < 17; ++y) {
+            for (size_t x = 0; x < 31; ++x) {
+                for (size_t c = 0; c < 3; ++c) {
+                    ASSERT_EQ(
+                        view.pixel_ptr(x, y)[c],
+                        img.pixel_ptr<uint8_t>(x, y)[c]
+                    );
+                }
+            }
+        }
+        mapped.prefetch_slices(3, 9);
+        mapped.prefetch_slices(10, 1000);
+    }
+
+
+    TEST(ImgRaw, Image3D) {
+        const TempFile tmp{ "sungtest_img_raw_3d.bin" };
+        const auto vol = ::make_volume(2, 13, 11, 7);
+        ASSERT_TRUE(
+            sung::write_raw_image(tmp.path(), vol, sung::PixelScalar::float32)
+        );
+
+        sung::MappedImage mapped;
+        ASSERT_TRUE(mapped.open(tmp.path()));
+        ASSERT_EQ(mapped.scalar(), sung::PixelScalar::float32);
+        ASSERT_EQ(mapped.channels(), 2);
+        mapped.advise(sung::AccessHint::random);
+
+        sung::TImageView2D<float> flat;
+        ASSERT_FALSE(mapped.make_view(flat));
+        sung::TImageView3D<float> view;
+        ASSERT_TRUE(mapped.make_view(view));
+        ASSERT_EQ(view.depth(), 7);
+        for (size_t z = 0; z < 7; ++z) {
+            for (size_t y = 0; y < 11; ++y) {
+                for (size_t x = 0; x < 13; ++x) {
+                    const auto a = view.texel_ptr(x, y, z);
+                    const auto b = vol.texel_ptr(x, y, z);
+                    ASSERT_EQ(a[0], b[0]);
+                    ASSERT_EQ(a[1], b[1]);
+                }
+            }
+        }
+        mapped.prefetch_slices(2, 4);
+
+        // Truncated payload
+        {
+            std::vector<char> bytes(64 + 100);
+            std::copy(mapped.data() - 64, mapped.data() + 100, bytes.begin());
+            mapped.close();
+            std::ofstream file(tmp.path(), std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), bytes.size());
+        }
+        ASSERT_FALSE(mapped.open(tmp.path()));
+
+        // Not a raw image
+        {
+            std::ofstream file(tmp.path(), std::ios::binary | std::ios::trunc);
+            file << std::string(200, 'x');
+        }
+        ASSERT_FALSE(mapped.open(tmp.path()));
+    }
+
+
+    TEST(ImgRaw, DISABLED_Benchmark) {
+        const TempFile tmp{ "sungtest_img_raw_bench.bin" };
+        const auto vol = ::make_volume(1, 256, 256, 256);
+        ASSERT_TRUE(
+            sung::write_raw_image(tmp.path(), vol, sung::PixelScalar::float32)
+        );
+
+        // Reading the whole payload into memory first
+        sung::MonotonicRealtimeTimer timer;
+        sung::TImage3D<float> loaded;
+        {
+            std::ifstream file(tmp.path(), std::ios::binary);
+            file.seekg(64);
+            loaded.alloc_uninit(1, 256, 256, 256);
+            file.read(
+                reinterpret_cast<char*>(loaded.data_.data()),
+                loaded.data_.size() * sizeof(float)
+            );
+        }
+        const auto read_val = loaded.texel_ptr(100, 200, 50)[0];
+        const auto read_time = timer.check_get_elapsed();
+
+        sung::MappedImage mapped;
+        sung::TImageView3D<float> view;
+        ASSERT_TRUE(mapped.open(tmp.path()));
+        ASSERT_TRUE(mapped.make_view(view));
+        const auto mapped_val = view.texel_ptr(100, 200, 50)[0];
+        const auto mapped_time = timer.elapsed();
+
+        ASSERT_EQ(read_val, mapped_val);
+        ASSERT_EQ(read_val, vol.texel_ptr(100, 200, 50)[0]);
+        std::cout << "First texel of a 64 MiB volume, read: " << read_time
+                  << " sec, mapped: " << mapped_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
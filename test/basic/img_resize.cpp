@@ -0,0 +1,184 @@
+#include "sung/basic/img_resize.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    constexpr sung::ResizeFilter FILTERS[] = {
+        sung::ResizeFilter::box,
+        sung::ResizeFilter::bilinear,
+        sung::ResizeFilter::bicubic,
+        sung::ResizeFilter::lanczos,
+        sung::ResizeFilter::kaiser,
+    };
+
+
+    template <typename T>
+    sung::Image2D make_image(
+        size_t channels, size_t x, size_t y, size_t padding, T max_v
+    ) {
+        sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+        sung::Image2D img;
+        img.set_metadata<T>(channels, x, y, padding);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<T>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<T>(rng.gen() * max_v);
+            }
+        }
+        return img;
+    }
+
+    template <typename T>
+    void assert_same_pixels(const sung::Image2D& a, const sung::Image2D& b) {
+        ASSERT_EQ(a.x_size(), b.x_size());
+        ASSERT_EQ(a.y_size(), b.y_size());
+        ASSERT_EQ(a.channels(), b.channels());
+        for (size_t y = 0; y < a.y_size(); ++y) {
+            for (size_t x = 0; x < a.x_size(); ++x) {
+                for (size_t c = 0; c < a.channels(); ++c) {
+                    ASSERT_EQ(
+                        a.pixel_ptr<T>(x, y)[c], b.pixel_ptr<T>(x, y)[c]
+                    );
+                }
+            }
+        }
+    }
+
+
+    TEST(ImgResize, Identity) {
+        const auto src = ::make_image<uint8_t>(3, 31, 17, 0, 255);
+        for (auto filter : FILTERS) {
+            sung::Image2D dst;
+            ASSERT_TRUE(sung::resize_image<uint8_t>(
+                dst, src, 31, 17, filter, nullptr
+            ));
+            ::assert_same_pixels<uint8_t>(src, dst);
+        }
+    }
+
+
+    TEST(ImgResize, Constant) {
+        sung::Image2D src;
+        src.set_metadata<uint16_t>(2, 40, 30);
+        src.resize_data_to_fit();
+        for (size_t y = 0; y < 30; ++y) {
+            for (size_t x = 0; x < 40; ++x) {
+                src.pixel_ptr<uint16_t>(x, y)[0] = 1234;
+                src.pixel_ptr<uint16_t>(x, y)[1] = 65535;
+            }
+        }
+
+        for (auto filter : FILTERS) {
+            for (size_t size : { 7, 40, 97 }) {
+                sung::Image2D dst;
+                ASSERT_TRUE(sung::resize_image<uint16_t>(
+                    dst, src, size, size / 2 + 1, filter, nullptr
+                ));
+                for (size_t y = 0; y < dst.y_size(); ++y) {
+                    for (size_t x = 0; x < dst.x_size(); ++x) {
+                        ASSERT_EQ(dst.pixel_ptr<uint16_t>(x, y)[0], 1234);
+                        ASSERT_EQ(dst.pixel_ptr<uint16_t>(x, y)[1], 65535);
+                    }
+                }
+            }
+        }
+    }
+
+
+    TEST(ImgResize, BoxHalf) {
+        const auto src = ::make_image<float>(1, 16, 8, 0, 1);
+        sung::Image2D dst;
+        ASSERT_TRUE(sung::resize_image<float>(
+            dst, src, 8, 4, sung::ResizeFilter::box, nullptr
+        ));
+        const auto at = [&](size_t x, size_t y) {
+            return src.pixel_ptr<float>(x, y)[0];
+        };
+        for (size_t y = 0; y < 4; ++y) {
+            for (size_t x = 0; x < 8; ++x) {
+                const auto expected = (at(x * 2, y * 2) + at(x * 2 + 1, y * 2) +
+                                       at(x * 2, y * 2 + 1) +
+                                       at(x * 2 + 1, y * 2 + 1)) /
+                                      4;
+                ASSERT_NEAR(dst.pixel_ptr<float>(x, y)[0], expected, 1e-5);
+            }
+        }
+    }
+
+
+    TEST(ImgResize, PaddingAndParallel) {
+        const auto src = ::make_image<uint8_t>(4, 300, 200, 0, 255);
+        const auto src_padded = ::make_image<uint8_t>(4, 300, 200, 13, 255);
+        for (size_t y = 0; y < 200; ++y) {
+            std::copy(
+                src.pixel_ptr<uint8_t>(0, y),
+                src.pixel_ptr<uint8_t>(0, y) + 300 * 4,
+                const_cast<uint8_t*>(src_padded.pixel_ptr<uint8_t>(0, y))
+            );
+        }
+
+        auto sche = sung::create_task_scheduler();
+        for (auto filter : FILTERS) {
+            sung::Image2D expected;
+            ASSERT_TRUE(sung::resize_image<uint8_t>(
+                expected, src, 123, 321, filter, nullptr
+            ));
+
+            sung::Image2D dst;
+            dst.set_metadata<uint8_t>(4, 123, 321, 7);
+            dst.resize_data_to_fit();
+            ASSERT_TRUE(
+                sung::resize_image<uint8_t>(dst, src_padded, filter, sche.get())
+            );
+            ::assert_same_pixels<uint8_t>(expected, dst);
+        }
+    }
+
+
+    TEST(ImgResize, Invalid) {
+        const auto src = ::make_image<uint8_t>(4, 10, 10, 0, 255);
+        sung::Image2D dst;
+        ASSERT_FALSE(sung::resize_image<float>(
+            dst, src, 5, 5, sung::ResizeFilter::box, nullptr
+        ));
+        ASSERT_FALSE(sung::resize_image<uint8_t>(
+            dst, src, 0, 5, sung::ResizeFilter::box, nullptr
+        ));
+    }
+
+
+    TEST(ImgResize, DISABLED_Benchmark) {
+        const auto src = ::make_image<uint8_t>(4, 3840, 2160, 0, 255);
+        auto sche = sung::create_task_scheduler();
+
+        for (auto filter : FILTERS) {
+            sung::Image2D dst;
+            sung::MonotonicRealtimeTimer timer;
+            sung::resize_image<uint8_t>(dst, src, 1920, 1080, filter, nullptr);
+            const auto serial_time = timer.check_get_elapsed();
+            sung::resize_image<uint8_t>(
+                dst, src, 1920, 1080, filter, sche.get()
+            );
+            const auto parallel_time = timer.elapsed();
+
+            std::cout << "4K to 1080p, filter " << static_cast<int>(filter)
+                      << ", serial: " << serial_time
+                      << " sec, parallel: " << parallel_time << " sec"
+                      << std::endl;
+        }
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+#include "sung/basic/img_tiled.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    sung::Image2D make_image(size_t channels, size_t x, size_t y) {
+        sung::RandomIntegerGenerator<int> rng{ 0, 65535 };
+        sung::Image2D img;
+        img.set_metadata<uint16_t>(channels, x, y, 6);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<uint16_t>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<uint16_t>(rng.gen());
+            }
+        }
+        return img;
+    }
+
+    sung::TImage3D<float> make_volume(
+        size_t channels, size_t x, size_t y, size_t z
+    ) {
+        sung::RandomRealNumGenerator<float> rng{ 0, 1 };
+        sung::TImage3D<float> out;
+        out.alloc(channels, x, y, z);
+        for (auto& v : out.data_) v = rng.gen();
+        return out;
+    }
+
+    template <typename Img>
+    float sample_trilinear(const Img& img, float x, float y, float z) {
+        const auto x0 = static_cast<size_t>(x);
+        const auto y0 = static_cast<size_t>(y);
+        const auto z0 = static_cast<size_t>(z);
+        const auto fx = x - x0, fy = y - y0, fz = z - z0;
+
+        float out = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            const auto dx = i & 1, dy = (i >> 1) & 1, dz = (i >> 2) & 1;
+            const auto w = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy) *
+                           (dz ? fz : 1 - fz);
+            out += w * img.texel_ptr(x0 + dx, y0 + dy, z0 + dz)[0];
+        }
+        return out;
+    }
+
+
+    TEST(ImgTiled, Image2D) {
+        const auto src = ::make_image(3, 37, 21);
+        sung::TiledImage2D tiled;
+        tiled.copy_from(src);
+        ASSERT_EQ(tiled.tile_count_x(), 5);
+        ASSERT_EQ(tiled.tile_count_y(), 3);
+        ASSERT_EQ(tiled.data_.size(), 5 * 3 * 64 * 3 * 2);
+        ASSERT_EQ(tiled.size_bytes(), tiled.data_.size());
+        ASSERT_EQ(tiled.padding_bytes(), 0);
+
+        for (size_t y = 0; y < 21; ++y) {
+            for (size_t x = 0; x < 37; ++x) {
+                for (size_t c = 0; c < 3; ++c) {
+                    ASSERT_EQ(
+                        tiled.pixel_ptr<uint16_t>(x, y)[c],
+                        src.pixel_ptr<uint16_t>(x, y)[c]
+                    );
+                }
+            }
+        }
+
+        // Pixels within a tile row are contiguous
+        ASSERT_EQ(tiled.pixel_ptr(9, 10) + 6, tiled.pixel_ptr(10, 10));
+        // Next row of the same tile
+        ASSERT_EQ(tiled.pixel_ptr(8, 10) + 8 * 6, tiled.pixel_ptr(8, 11));
+
+        sung::Image2D back;
+        tiled.copy_to(back);
+        ASSERT_EQ(back.x_size(), 37);
+        ASSERT_EQ(back.y_size(), 21);
+        for (size_t y = 0; y < 21; ++y) {
+            for (size_t x = 0; x < 37; ++x) {
+                for (size_t c = 0; c < 3; ++c) {
+                    ASSERT_EQ(
+                        back.pixel_ptr<uint16_t>(x, y)[c],
+                        src.pixel_ptr<uint16_t>(x, y)[c]
+                    );
+                }
+            }
+        }
+
+        // Row padding set by hand doesn't count either
+        tiled.set_metadata<uint8_t>(4, 10, 9, 7);
+        tiled.resize_data_to_fit();
+        ASSERT_EQ(tiled.padding_bytes(), 0);
+        ASSERT_EQ(tiled.size_bytes(), 2 * 2 * 64 * 4);
+        ASSERT_EQ(tiled.size_bytes(), tiled.data_.size());
+    }
+
+
+    TEST(ImgTiled, Image3D) {
+        const auto src = ::make_volume(2, 9, 6, 5);
+        sung::TTiledImage3D<float> tiled;
+        tiled.copy_from(src);
+        ASSERT_EQ(tiled.data_.size(), 3 * 2 * 2 * 64 * 2);
+
+        for (size_t z = 0; z < 5; ++z) {
+            for (size_t y = 0; y < 6; ++y) {
+                for (size_t x = 0; x < 9; ++x) {
+                    ASSERT_EQ(
+                        tiled.texel_ptr(x, y, z)[0], src.texel_ptr(x, y, z)[0]
+                    );
+                    ASSERT_EQ(
+                        tiled.texel_ptr(x, y, z)[1], src.texel_ptr(x, y, z)[1]
+                    );
+                }
+            }
+        }
+
+        // Clamped like TImage3D
+        ASSERT_EQ(tiled.texel_ptr(100, 100, 100), tiled.texel_ptr(8, 5, 4));
+
+        sung::TImage3D<float> back;
+        tiled.copy_to(back);
+        ASSERT_EQ(back.data_, src.data_);
+    }
+
+
+    TEST(ImgTiled, DISABLED_Benchmark2D) {
+        constexpr size_t SIZE = 4096;
+        const auto src = ::make_image(1, SIZE, SIZE);
+        sung::TiledImage2D tiled;
+        tiled.copy_from(src);
+
+        // Walk down the columns
+        uint64_t linear_sum = 0, tiled_sum = 0;
+        sung::MonotonicRealtimeTimer timer;
+        for (size_t x = 0; x < SIZE; ++x) {
+            for (size_t y = 0; y < SIZE; ++y)
+                linear_sum += src.pixel_ptr<uint16_t>(x, y)[0];
+        }
+        const auto linear_time = timer.check_get_elapsed();
+        for (size_t x = 0; x < SIZE; ++x) {
+            for (size_t y = 0; y < SIZE; ++y)
+                tiled_sum += tiled.pixel_ptr<uint16_t>(x, y)[0];
+        }
+        const auto tiled_time = timer.elapsed();
+
+        ASSERT_EQ(linear_sum, tiled_sum);
+        std::cout << "Column walk of 4096^2, row-major: " << linear_time
+                  << " sec, tiled: " << tiled_time << " sec" << std::endl;
+    }
+
+
+    TEST(ImgTiled, DISABLED_Benchmark3D) {
+        constexpr size_t SIZE = 256;
+        const auto src = ::make_volume(1, SIZE, SIZE, SIZE);
+        sung::TTiledImage3D<float> tiled;
+        tiled.copy_from(src);
+
+        // Rays marching along z, which is the worst axis for row-major
+        sung::RandomRealNumGenerator<float> rng{ 0, SIZE - 1 };
+        std::vector<std::pair<float, float>> rays(2000);
+        for (auto& r : rays) r = { rng.gen(), rng.gen() };
+
+        double linear_sum = 0, tiled_sum = 0;
+        sung::MonotonicRealtimeTimer timer;
+        for (const auto& r : rays) {
+            for (float z = 0; z < SIZE - 1; z += 0.5f)
+                linear_sum += ::sample_trilinear(src, r.first, r.second, z);
+        }
+        const auto linear_time = timer.check_get_elapsed();
+        for (const auto& r : rays) {
+            for (float z = 0; z < SIZE - 1; z += 0.5f)
+                tiled_sum += ::sample_trilinear(tiled, r.first, r.second, z);
+        }
+        const auto tiled_time = timer.elapsed();
+
+        ASSERT_DOUBLE_EQ(linear_sum, tiled_sum);
+        std::cout << "Trilinear along z in 256^3, row-major: " << linear_time
+                  << " sec, bricked: " << tiled_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
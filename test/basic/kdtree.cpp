@@ -0,0 +1,133 @@
+#include "sung/basic/kdtree.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    using Tree = sung::KdTree3<double>;
+    using Vec3 = Tree::Vec3;
+
+
+    std::vector<Vec3> make_points(size_t count, double range) {
+        sung::RandomRealNumGenerator<double> rng{ -range, range };
+        std::vector<Vec3> out(count);
+        for (auto& p : out) p = Vec3{ rng.gen(), rng.gen(), rng.gen() };
+        return out;
+    }
+
+    std::vector<Tree::Neighbor> brute_force(
+        const std::vector<Vec3>& points, const Vec3& q
+    ) {
+        std::vector<Tree::Neighbor> out(points.size());
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            out[i].idx_ = i;
+            out[i].dist_sqr_ = points[i].distance_sqr(q);
+        }
+        std::sort(out.begin(), out.end(), [](auto& a, auto& b) {
+            return a.dist_sqr_ < b.dist_sqr_;
+        });
+        return out;
+    }
+
+
+    TEST(KdTree, Nearest) {
+        const auto points = ::make_points(5000, 100);
+        Tree tree;
+        tree.build(points);
+        ASSERT_EQ(tree.size(), points.size());
+
+        for (auto& q : ::make_points(200, 120)) {
+            const auto expected = ::brute_force(points, q);
+            const auto found = tree.find_nearest(q);
+            ASSERT_TRUE(found.has_value());
+            ASSERT_EQ(found->dist_sqr_, expected[0].dist_sqr_);
+        }
+
+        for (uint32_t i = 0; i < 100; ++i) {
+            const auto found = tree.find_nearest(points[i]);
+            ASSERT_EQ(found->dist_sqr_, 0);
+        }
+    }
+
+
+    TEST(KdTree, Knn) {
+        const auto points = ::make_points(5000, 100);
+        auto sche = sung::create_task_scheduler(4);
+        Tree tree;
+        tree.build(points, sche.get());
+
+        std::vector<Tree::Neighbor> found;
+        for (auto& q : ::make_points(100, 100)) {
+            const auto expected = ::brute_force(points, q);
+            tree.find_knn(found, q, 10);
+            ASSERT_EQ(found.size(), 10);
+            for (size_t i = 0; i < found.size(); ++i) {
+                ASSERT_EQ(found[i].dist_sqr_, expected[i].dist_sqr_);
+            }
+        }
+
+        tree.find_knn(found, { 0, 0, 0 }, 10000);
+        ASSERT_EQ(found.size(), points.size());
+    }
+
+
+    TEST(KdTree, Radius) {
+        const auto points = ::make_points(5000, 100);
+        Tree tree;
+        tree.build(points);
+
+        std::vector<Tree::Neighbor> found;
+        for (auto& q : ::make_points(100, 100)) {
+            tree.find_in_radius(found, q, 15);
+            std::vector<uint32_t> found_idx;
+            for (auto& x : found) found_idx.push_back(x.idx_);
+            std::sort(found_idx.begin(), found_idx.end());
+
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < points.size(); ++i) {
+                if (points[i].distance_sqr(q) <= 15 * 15)
+                    expected.push_back(i);
+            }
+            ASSERT_EQ(found_idx, expected);
+        }
+    }
+
+
+    TEST(KdTree, DISABLED_Benchmark) {
+        const auto points = ::make_points(1000000, 1000);
+        auto sche = sung::create_task_scheduler();
+        Tree tree;
+
+        sung::MonotonicRealtimeTimer timer;
+        tree.build(points);
+        const auto serial_time = timer.check_get_elapsed();
+        tree.build(points, sche.get());
+        const auto parallel_time = timer.check_get_elapsed();
+
+        double sum = 0;
+        for (size_t i = 0; i < 100000; ++i) {
+            sum += tree.find_nearest(points[i] + Vec3{ 0.5, 0, 0 })->dist_sqr_;
+        }
+        const auto query_time = timer.elapsed();
+
+        ASSERT_LE(sum, 100000 * 0.25);
+        std::cout << "Build serial: " << serial_time
+                  << " sec, parallel: " << parallel_time
+                  << " sec, 100000 queries: " << query_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
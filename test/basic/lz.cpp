@@ -0,0 +1,140 @@
+#include "sung/basic/lz.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    std::vector<sung::byte8> compress(const std::vector<sung::byte8>& src) {
+        std::vector<sung::byte8> out(sung::lz_compress_bound(src.size()));
+        const auto size = sung::lz_compress(
+            out.data(), out.size(), src.data(), src.size()
+        );
+        EXPECT_NE(size, 0);
+        out.resize(size);
+        return out;
+    }
+
+    void round_trip(const std::vector<sung::byte8>& src) {
+        const auto packed = ::compress(src);
+        std::vector<sung::byte8> unpacked(src.size());
+        ASSERT_TRUE(sung::lz_decompress(
+            unpacked.data(), unpacked.size(), packed.data(), packed.size()
+        ));
+        ASSERT_EQ(unpacked, src);
+    }
+
+
+    TEST(Lz, RoundTrip) {
+        ::round_trip({});
+        ::round_trip({ 7 });
+        ::round_trip({ 1, 2, 3, 4, 1, 2, 3, 4, 1 });
+
+        // Long runs, which decode as overlapping matches
+        ::round_trip(std::vector<sung::byte8>(100000, 42));
+
+        sung::RandomIntegerGenerator<int> rng{ 0, 255 };
+        std::vector<sung::byte8> noise(70000);
+        for (auto& x : noise) x = static_cast<sung::byte8>(rng.gen());
+        ::round_trip(noise);
+
+        // Text-like data with repeats further than the offset limit
+        std::vector<sung::byte8> text;
+        for (int i = 0; i < 30000; ++i) {
+            const auto word = "word" + std::to_string(rng.gen() % 50) + " ";
+            text.insert(text.end(), word.begin(), word.end());
+        }
+        ::round_trip(text);
+        ASSERT_LT(::compress(text).size(), text.size() / 2);
+    }
+
+
+    TEST(Lz, Malformed) {
+        std::vector<sung::byte8> src(5000);
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<sung::byte8>(i % 13);
+        const auto packed = ::compress(src);
+
+        std::vector<sung::byte8> out(src.size());
+        // Wrong size, truncated, and corrupt bytes must all fail safely
+        ASSERT_FALSE(sung::lz_decompress(
+            out.data(), out.size() - 1, packed.data(), packed.size()
+        ));
+        ASSERT_FALSE(sung::lz_decompress(
+            out.data(), out.size(), packed.data(), packed.size() - 1
+        ));
+        sung::RandomIntegerGenerator<size_t> rng{ 0, packed.size() - 1 };
+        for (int i = 0; i < 1000; ++i) {
+            auto bad = packed;
+            bad[rng.gen()] ^= 0x5A;
+            sung::lz_decompress(out.data(), out.size(), bad.data(), bad.size());
+        }
+
+        // Too small a destination
+        std::vector<sung::byte8> small(10);
+        ASSERT_EQ(
+            0, sung::lz_compress(small.data(), 10, src.data(), src.size())
+        );
+    }
+
+
+    TEST(Lz, Shuffle) {
+        std::vector<float> values(1000);
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = std::sin(static_cast<float>(i) * 0.01f);
+
+        const auto src = reinterpret_cast<const sung::byte8*>(values.data());
+        const auto bytes = values.size() * sizeof(float);
+        std::vector<sung::byte8> shuffled(bytes), restored(bytes);
+        sung::shuffle_bytes(shuffled.data(), src, values.size(), 4);
+        ASSERT_EQ(shuffled[1], src[4]);
+        sung::unshuffle_bytes(restored.data(), shuffled.data(), 1000, 4);
+        ASSERT_EQ(0, std::memcmp(restored.data(), src, bytes));
+
+        // Smooth floats barely compress as is, but do once shuffled
+        const std::vector<sung::byte8> plain(src, src + bytes);
+        ASSERT_LT(::compress(shuffled).size(), ::compress(plain).size());
+    }
+
+
+    TEST(Lz, DISABLED_Benchmark) {
+        constexpr size_t COUNT = 1 << 22;
+        std::vector<float> values(COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            values[i] = std::round(std::sin(i * 0.001) * 1000) / 8;
+        const auto src = reinterpret_cast<const sung::byte8*>(values.data());
+        const auto bytes = COUNT * sizeof(float);
+
+        std::vector<sung::byte8> shuffled(bytes), packed(
+            sung::lz_compress_bound(bytes)
+        );
+        sung::MonotonicRealtimeTimer timer;
+        sung::shuffle_bytes(shuffled.data(), src, COUNT, 4);
+        const auto size = sung::lz_compress(
+            packed.data(), packed.size(), shuffled.data(), bytes
+        );
+        const auto comp_time = timer.check_get_elapsed();
+        ASSERT_TRUE(sung::lz_decompress(
+            shuffled.data(), bytes, packed.data(), size
+        ));
+        const auto decomp_time = timer.elapsed();
+
+        std::cout << "16 MiB of floats to " << size << " bytes, compress: "
+                  << comp_time << " sec, decompress: " << decomp_time
+                  << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
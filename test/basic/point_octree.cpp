@@ -0,0 +1,190 @@
+#include "sung/basic/point_octree.hpp"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+
+
+namespace {
+
+    using Octree = sung::PointOctree;
+    using Vec3 = Octree::Vec3;
+
+
+    std::vector<Vec3> make_points(size_t count) {
+        sung::RandomRealNumGenerator<double> rng{ -50, 50 };
+        std::vector<Vec3> out(count);
+        for (auto& p : out) p = Vec3{ rng.gen(), rng.gen() * 0.5, rng.gen() };
+        return out;
+    }
+
+    // Points are copied around, never recomputed, so they match exactly
+    void expect_same(const std::vector<Vec3>& a, const std::vector<Vec3>& b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_EQ(a[i].x(), b[i].x());
+            ASSERT_EQ(a[i].y(), b[i].y());
+            ASSERT_EQ(a[i].z(), b[i].z());
+        }
+    }
+
+
+    TEST(PointOctree, Nodes) {
+        const auto points = ::make_points(10000);
+        Octree octree;
+        ASSERT_TRUE(octree.build(points.data(), points.size()));
+        ASSERT_EQ(octree.size(), points.size());
+        ASSERT_EQ(octree.run_count(), 1);
+
+        const auto root = octree.root();
+        ASSERT_EQ(root.count_, points.size());
+
+        std::vector<Octree::Node> children, grand_children;
+        std::vector<Vec3> node_points;
+        octree.get_children(children, root);
+        size_t total = 0;
+        for (auto& child : children) {
+            total += child.count_;
+            octree.get_children(grand_children, child);
+            for (auto& node : grand_children) {
+                // Cell boundaries may be off by rounding errors
+                const Vec3 eps{ 1e-9, 1e-9, 1e-9 };
+                const sung::Aabb3D<double> box{ node.aabb_.mini() - eps,
+                                                node.aabb_.maxi() + eps };
+                octree.get_points(node_points, node);
+                ASSERT_EQ(node_points.size(), node.count_);
+                for (const auto& p : node_points)
+                    ASSERT_TRUE(box.is_inside_cl(p));
+            }
+        }
+        ASSERT_EQ(total, points.size());
+    }
+
+
+    TEST(PointOctree, Lod) {
+        const auto points = ::make_points(20000);
+        Octree octree;
+        octree.build(points.data(), points.size());
+
+        std::vector<Octree::Node> cut;
+        octree.select_lod(cut, Vec3{ 0, 0, 0 }, 0.5, 16);
+        ASSERT_FALSE(cut.empty());
+
+        // The cut must cover every point exactly once, in Morton order
+        size_t total = 0;
+        uint64_t next_code = 0;
+        uint32_t max_level = 0, min_level = Octree::MAX_LEVEL;
+        for (auto& node : cut) {
+            const auto shift = 3 * (Octree::MAX_LEVEL - node.level_);
+            ASSERT_GE(node.code_ << shift, next_code);
+            next_code = (node.code_ + 1) << shift;
+            total += node.count_;
+            max_level = (std::max)(max_level, node.level_);
+            min_level = (std::min)(min_level, node.level_);
+        }
+        ASSERT_EQ(total, points.size());
+        ASSERT_LT(min_level, max_level);
+
+        std::vector<Vec3> samples;
+        octree.sample_node(samples, octree.root(), 100);
+        ASSERT_EQ(samples.size(), 100);
+    }
+
+
+    TEST(PointOctree, Insert) {
+        const auto points = ::make_points(10000);
+        const sung::Aabb3D<double> aabb{ -50, 50, -25, 25, -50, 50 };
+
+        Octree whole;
+        whole.build(points.data(), points.size(), aabb);
+        std::vector<Vec3> expected;
+        whole.get_points(expected, whole.root());
+
+        Octree streamed;
+        streamed.reset(aabb);
+        for (size_t i = 0; i < points.size(); i += 100) {
+            ASSERT_TRUE(streamed.insert(points.data() + i, 100));
+            ASSERT_EQ(streamed.pending_size(), 100);
+            ASSERT_TRUE(streamed.flush());
+
+            // Runs shrink from the oldest, so there are only a few
+            const auto batches = i / 100 + 1;
+            ASSERT_LE(streamed.run_count(), std::log2(batches) + 1);
+        }
+        ASSERT_EQ(streamed.size(), points.size());
+
+        // Queries see every run
+        std::vector<Vec3> actual;
+        streamed.get_points(actual, streamed.root());
+        ::expect_same(actual, expected);
+
+        std::vector<Octree::Node> cut_a, cut_b;
+        whole.select_lod(cut_a, Vec3{ 10, 0, 0 }, 0.3, 8);
+        streamed.select_lod(cut_b, Vec3{ 10, 0, 0 }, 0.3, 8);
+        ASSERT_EQ(cut_a.size(), cut_b.size());
+        for (size_t i = 0; i < cut_a.size(); ++i) {
+            ASSERT_EQ(cut_a[i].code_, cut_b[i].code_);
+            ASSERT_EQ(cut_a[i].count_, cut_b[i].count_);
+        }
+
+        std::vector<Vec3> samples;
+        streamed.sample_node(samples, streamed.root(), 777);
+        ASSERT_EQ(samples.size(), 777);
+
+        ASSERT_TRUE(streamed.compact());
+        ASSERT_EQ(streamed.run_count(), 1);
+        streamed.get_points(actual, streamed.root());
+        ::expect_same(actual, expected);
+    }
+
+
+    TEST(PointOctree, Scratch) {
+        const auto points = ::make_points(30000);
+        const sung::Aabb3D<double> aabb{ -50, 50, -25, 25, -50, 50 };
+
+        Octree memory;
+        memory.build(points.data(), points.size(), aabb);
+        std::vector<Vec3> expected;
+        memory.get_points(expected, memory.root());
+
+        // Automatic flushes into scratch files
+        Octree mapped;
+        mapped.reset(aabb);
+        mapped.set_scratch_path("sungtest_point_octree_run_");
+        mapped.set_buffer_size(1000);
+        ASSERT_TRUE(mapped.insert(points.data(), 12345));
+        ASSERT_EQ(mapped.pending_size(), 345);
+        ASSERT_TRUE(mapped.insert(points.data() + 12345, 30000 - 12345));
+        ASSERT_TRUE(mapped.flush());
+        ASSERT_EQ(mapped.pending_size(), 0);
+        ASSERT_EQ(mapped.size(), points.size());
+
+        std::vector<Vec3> actual;
+        mapped.get_points(actual, mapped.root());
+        ::expect_same(actual, expected);
+
+        // Copies hold their runs in memory and don't share the files
+        const Octree copy = mapped;
+        mapped.clear();
+        copy.get_points(actual, copy.root());
+        ::expect_same(actual, expected);
+
+        // A scratch file that can't be made keeps the points buffered
+        Octree bad;
+        bad.reset(aabb);
+        bad.set_scratch_path("no/such/dir/run_");
+        ASSERT_TRUE(bad.insert(points.data(), 10));
+        ASSERT_FALSE(bad.flush());
+        ASSERT_EQ(bad.pending_size(), 10);
+        ASSERT_EQ(bad.size(), 0);
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
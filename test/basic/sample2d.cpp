@@ -0,0 +1,216 @@
+#include "sung/basic/sample2d.hpp"
+
+#include <array>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    template <typename T>
+    sung::Image2D make_image(size_t channels, size_t x, size_t y, T max_v) {
+        sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+        sung::Image2D img;
+        // Odd padding to make sure row strides are respected
+        img.set_metadata<T>(channels, x, y, sizeof(T) * 3);
+        img.resize_data_to_fit();
+        for (size_t yy = 0; yy < y; ++yy) {
+            for (size_t xx = 0; xx < x; ++xx) {
+                auto p = img.pixel_ptr<T>(xx, yy);
+                for (size_t c = 0; c < channels; ++c)
+                    p[c] = static_cast<T>(rng.gen() * max_v);
+            }
+        }
+        return img;
+    }
+
+    // Same addressing as sample_bilinear_clamp, blended in double without
+    // truncating in between
+    template <size_t Channels, typename T>
+    std::array<double, Channels> calc_exact(
+        const sung::TImageView2D<T>& view, double x, double y
+    ) {
+        const auto x_texel = x * static_cast<double>(view.x_size());
+        const auto y_texel = y * static_cast<double>(view.y_size());
+        const auto x_tex = std::floor(x_texel);
+        const auto y_tex = std::floor(y_texel);
+        const auto wx = x_texel - x_tex;
+        const auto wy = y_texel - y_tex;
+
+        const auto p00 = sung::fetch_clamp<Channels, T>(view, x_tex, y_tex);
+        const auto p10 = sung::fetch_clamp<Channels, T>(view, x_tex + 1, y_tex);
+        const auto p01 = sung::fetch_clamp<Channels, T>(view, x_tex, y_tex + 1);
+        const auto p11 = sung::fetch_clamp<Channels, T>(
+            view, x_tex + 1, y_tex + 1
+        );
+
+        std::array<double, Channels> out;
+        for (size_t c = 0; c < Channels; ++c) {
+            const auto top = p00[c] + (double(p10[c]) - p00[c]) * wx;
+            const auto bottom = p01[c] + (double(p11[c]) - p01[c]) * wx;
+            out[c] = top + (bottom - top) * wy;
+        }
+        return out;
+    }
+
+    template <size_t Channels, typename T>
+    void compare_with_exact(T max_v, double tolerance) {
+        const auto img = ::make_image<T>(Channels, 37, 23, max_v);
+        const auto view = img.template make_view<T>();
+
+        sung::RandomRealNumGenerator<double> rng{ -0.2, 1.2 };
+        std::vector<sung::TVec2<double>> uvs(2000);
+        for (auto& uv : uvs) uv = sung::TVec2<double>{ rng.gen(), rng.gen() };
+
+        std::vector<T> batch(uvs.size() * Channels);
+        sung::sample_bilinear_clamp_batch(
+            batch.data(), view, uvs.data(), uvs.size()
+        );
+        for (size_t i = 0; i < uvs.size(); ++i) {
+            const auto expected = ::calc_exact<Channels, T>(
+                view, uvs[i].x(), uvs[i].y()
+            );
+            for (size_t c = 0; c < Channels; ++c) {
+                ASSERT_NEAR(
+                    static_cast<double>(batch[i * Channels + c]),
+                    static_cast<double>(expected[c]),
+                    tolerance
+                );
+            }
+        }
+
+        // Same samples through the row interface
+        const double v = 0.37, u0 = -0.1, du = 0.013;
+        std::vector<T> row(100 * Channels);
+        sung::sample_bilinear_clamp_row(row.data(), view, u0, du, v, 100);
+        for (size_t i = 0; i < 100; ++i) {
+            const auto expected = ::calc_exact<Channels, T>(
+                view, u0 + static_cast<double>(i) * du, v
+            );
+            for (size_t c = 0; c < Channels; ++c) {
+                ASSERT_NEAR(
+                    static_cast<double>(row[i * Channels + c]),
+                    static_cast<double>(expected[c]),
+                    tolerance
+                );
+            }
+        }
+    }
+
+
+    TEST(Sample2D, BatchMatchesExact) {
+        // 8 bit weights are off by up to a step, plus rounding
+        ::compare_with_exact<1, uint8_t>(255, 2);
+        ::compare_with_exact<3, uint8_t>(255, 2);
+        ::compare_with_exact<4, uint8_t>(255, 2);
+        // uint16 is blended in float, so only the rounding is left
+        ::compare_with_exact<1, uint16_t>(65535, 1);
+        ::compare_with_exact<4, uint16_t>(65535, 1);
+        ::compare_with_exact<1, float>(1, 1e-5);
+        ::compare_with_exact<4, float>(1, 1e-5);
+    }
+
+
+    // The 4 channel uint8 path has its own SIMD blend, compare it against the
+    // generic integer blend by sampling each channel as a separate image
+    TEST(Sample2D, Rgba8MatchesPerChannel) {
+        const auto img = ::make_image<uint8_t>(4, 37, 23, 255);
+        const auto view = img.make_view<uint8_t>();
+
+        std::vector<sung::Image2D> planes(4);
+        for (size_t c = 0; c < 4; ++c) {
+            planes[c].set_metadata<uint8_t>(1, 37, 23);
+            planes[c].resize_data_to_fit();
+            for (size_t y = 0; y < 23; ++y) {
+                for (size_t x = 0; x < 37; ++x) {
+                    const auto src = view.pixel_ptr(x, y);
+                    *planes[c].pixel_ptr<uint8_t>(x, y) = src[c];
+                }
+            }
+        }
+
+        sung::RandomRealNumGenerator<double> rng{ -0.2, 1.2 };
+        std::vector<sung::TVec2<double>> uvs(5000);
+        for (auto& uv : uvs) uv = sung::TVec2<double>{ rng.gen(), rng.gen() };
+
+        std::vector<uint8_t> rgba(uvs.size() * 4);
+        sung::sample_bilinear_clamp_batch(
+            rgba.data(), view, uvs.data(), uvs.size()
+        );
+        std::vector<uint8_t> single(uvs.size());
+        for (size_t c = 0; c < 4; ++c) {
+            sung::sample_bilinear_clamp_batch(
+                single.data(),
+                planes[c].make_view<uint8_t>(),
+                uvs.data(),
+                uvs.size()
+            );
+            for (size_t i = 0; i < uvs.size(); ++i)
+                ASSERT_EQ(rgba[i * 4 + c], single[i]);
+        }
+    }
+
+
+    TEST(Sample2D, Exact) {
+        // Constant images must come back exactly
+        sung::Image2D img;
+        img.set_metadata<uint8_t>(4, 8, 8);
+        img.resize_data_to_fit();
+        for (auto& x : img.data_) x = 200;
+        const auto view = img.make_view<uint8_t>();
+
+        std::vector<sung::TVec2<double>> uvs;
+        for (int i = 0; i < 50; ++i)
+            uvs.push_back(sung::TVec2<double>{ i * 0.021, 1 - i * 0.017 });
+        std::vector<uint8_t> out(uvs.size() * 4);
+        sung::sample_bilinear_clamp_batch(
+            out.data(), view, uvs.data(), uvs.size()
+        );
+        for (auto x : out) ASSERT_EQ(x, 200);
+    }
+
+
+    TEST(Sample2D, DISABLED_Benchmark) {
+        constexpr size_t X = 3840, Y = 2160;
+        const auto img = ::make_image<uint8_t>(4, X, Y, 255);
+        const auto view = img.make_view<uint8_t>();
+
+        // Resample to the same size with a half texel offset
+        std::vector<uint8_t> scalar_out(X * Y * 4);
+        sung::MonotonicRealtimeTimer timer;
+        for (size_t y = 0; y < Y; ++y) {
+            const auto v = (y + 0.5) / Y;
+            for (size_t x = 0; x < X; ++x) {
+                const auto p = sung::sample_bilinear_clamp<4, uint8_t>(
+                    view, (x + 0.5) / X, v
+                );
+                std::copy(p.begin(), p.end(), &scalar_out[(y * X + x) * 4]);
+            }
+        }
+        const auto scalar_time = timer.check_get_elapsed();
+
+        std::vector<uint8_t> row_out(X * Y * 4);
+        for (size_t y = 0; y < Y; ++y) {
+            sung::sample_bilinear_clamp_row(
+                &row_out[y * X * 4], view, 0.5 / X, 1.0 / X, (y + 0.5) / Y, X
+            );
+        }
+        const auto row_time = timer.elapsed();
+
+        for (size_t i = 0; i < scalar_out.size(); ++i)
+            ASSERT_NEAR(scalar_out[i], row_out[i], 2);
+        std::cout << "Bilinear 4K RGBA8, scalar: " << scalar_time
+                  << " sec, row: " << row_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
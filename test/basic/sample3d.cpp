@@ -0,0 +1,250 @@
+#include "sung/basic/sample3d.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    using Vec3 = sung::TVec3<double>;
+
+
+    template <typename T>
+    sung::TImage3D<T> make_volume(
+        size_t channels, size_t x, size_t y, size_t z, T max_v
+    ) {
+        sung::RandomRealNumGenerator<double> rng{ 0, 1 };
+        sung::TImage3D<T> out;
+        out.alloc(channels, x, y, z);
+        for (auto& v : out.data_) v = static_cast<T>(rng.gen() * max_v);
+        return out;
+    }
+
+    std::vector<Vec3> make_points(size_t count, double lo, double hi) {
+        sung::RandomRealNumGenerator<double> rng{ lo, hi };
+        std::vector<Vec3> out(count);
+        for (auto& p : out) p = Vec3{ rng.gen(), rng.gen(), rng.gen() };
+        return out;
+    }
+
+    template <size_t Channels, typename T>
+    void compare_batch(T max_v, double tolerance) {
+        const auto img = ::make_volume<T>(Channels, 7, 5, 6, max_v);
+        const auto view = img.make_view();
+        const auto points = ::make_points(1000, -1.5, 2.5);
+
+        for (auto mode : { sung::AddressMode::clamp,
+                           sung::AddressMode::repeat }) {
+            std::vector<T> out(points.size() * Channels);
+            sung::sample_trilinear_batch(
+                out.data(), view, points.data(), points.size(), mode
+            );
+            for (size_t i = 0; i < points.size(); ++i) {
+                const auto& p = points[i];
+                const auto expected = sung::sample_trilinear<Channels, T>(
+                    view, p.x(), p.y(), p.z(), mode
+                );
+                for (size_t c = 0; c < Channels; ++c) {
+                    ASSERT_NEAR(
+                        static_cast<double>(out[i * Channels + c]),
+                        static_cast<double>(expected[c]),
+                        tolerance
+                    );
+                }
+            }
+        }
+    }
+
+
+    TEST(Sample3D, Nearest) {
+        const auto img = ::make_volume<uint8_t>(2, 4, 3, 5, 255);
+        const auto clamp = sung::AddressMode::clamp;
+        const auto repeat = sung::AddressMode::repeat;
+
+        for (size_t z = 0; z < 5; ++z) {
+            for (size_t y = 0; y < 3; ++y) {
+                for (size_t x = 0; x < 4; ++x) {
+                    const auto u = (x + 0.5) / 4;
+                    const auto v = (y + 0.5) / 3;
+                    const auto w = (z + 0.5) / 5;
+                    const auto a = sung::sample_nearest<2, uint8_t>(
+                        img, u, v, w, clamp
+                    );
+                    const auto b = sung::sample_nearest<2, uint8_t>(
+                        img, u - 3, v + 2, w + 1, repeat
+                    );
+                    ASSERT_EQ(a[0], img.texel_ptr(x, y, z)[0]);
+                    ASSERT_EQ(a[1], img.texel_ptr(x, y, z)[1]);
+                    ASSERT_EQ(a, b);
+                }
+            }
+        }
+
+        // Out of range
+        const auto lo = sung::sample_nearest<2, uint8_t>(
+            img, -0.3, -1, -5, clamp
+        );
+        ASSERT_EQ(lo[0], img.texel_ptr(0, 0, 0)[0]);
+        const auto hi = sung::sample_nearest<2, uint8_t>(img, 2, 3, 4, clamp);
+        ASSERT_EQ(hi[0], img.texel_ptr(3, 2, 4)[0]);
+        const auto wrapped = sung::sample_nearest<2, uint8_t>(
+            img, -0.1, 0.5, 0.5, repeat
+        );
+        ASSERT_EQ(wrapped[0], img.texel_ptr(3, 1, 2)[0]);
+    }
+
+
+    TEST(Sample3D, Trilinear) {
+        const auto img = ::make_volume<float>(1, 4, 4, 4, 1);
+
+        // Exactly on texels
+        for (size_t i = 0; i < 4; ++i) {
+            const auto s = sung::sample_trilinear<1, float>(
+                img, i / 4.0, (3 - i) / 4.0, i / 4.0, sung::AddressMode::clamp
+            );
+            ASSERT_FLOAT_EQ(s[0], img.texel_ptr(i, 3 - i, i)[0]);
+        }
+
+        // Halfway between the last texel and the first when repeating
+        const auto s = sung::sample_trilinear<1, float>(
+            img, 3.5 / 4, 0, 0, sung::AddressMode::repeat
+        );
+        const auto expected = (img.texel_ptr(3, 0, 0)[0] +
+                               img.texel_ptr(0, 0, 0)[0]) /
+                              2;
+        ASSERT_FLOAT_EQ(s[0], expected);
+
+        // Clamping holds the last texel instead
+        const auto c = sung::sample_trilinear<1, float>(
+            img, 3.5 / 4, 0, 0, sung::AddressMode::clamp
+        );
+        ASSERT_FLOAT_EQ(c[0], img.texel_ptr(3, 0, 0)[0]);
+    }
+
+
+    TEST(Sample3D, FewerChannelsThanView) {
+        const auto rgba = ::make_volume<float>(4, 5, 4, 3, 1);
+        const auto rgba_view = rgba.make_view();
+        const auto points = ::make_points(500, -0.5, 1.5);
+
+        std::vector<float> batch(points.size() * 4);
+        sung::sample_trilinear_batch(
+            batch.data(),
+            rgba_view,
+            points.data(),
+            points.size(),
+            sung::AddressMode::repeat
+        );
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            const auto& p = points[i];
+            const auto rgb = sung::sample_trilinear<3, float>(
+                rgba_view, p.x(), p.y(), p.z(), sung::AddressMode::repeat
+            );
+            for (size_t c = 0; c < 3; ++c)
+                ASSERT_NEAR(rgb[c], batch[i * 4 + c], 1e-5);
+
+            const auto nearest3 = sung::sample_nearest<3, float>(
+                rgba_view, p.x(), p.y(), p.z(), sung::AddressMode::repeat
+            );
+            const auto nearest4 = sung::sample_nearest<4, float>(
+                rgba_view, p.x(), p.y(), p.z(), sung::AddressMode::repeat
+            );
+            for (size_t c = 0; c < 3; ++c)
+                ASSERT_EQ(nearest3[c], nearest4[c]);
+        }
+    }
+
+
+    TEST(Sample3D, Batch) {
+        // The scalar path truncates after every lerp
+        ::compare_batch<1, uint8_t>(255, 4);
+        ::compare_batch<4, uint8_t>(255, 4);
+        ::compare_batch<3, uint16_t>(65535, 4);
+        ::compare_batch<1, float>(1, 1e-5);
+        ::compare_batch<4, float>(1, 1e-5);
+    }
+
+
+    TEST(Sample3D, Empty) {
+        const float dummy[2] = { 7, 7 };
+        for (size_t i = 0; i < 3; ++i) {
+            sung::TImageView3D<float> view;
+            view.set(dummy, 2, 0 == i ? 0 : 1, 1 == i ? 0 : 1, 2 == i ? 0 : 1);
+
+            for (auto mode : { sung::AddressMode::clamp,
+                               sung::AddressMode::repeat }) {
+                const auto n = sung::sample_nearest<2, float>(
+                    view, 0.3, -2, 5, mode
+                );
+                const auto t = sung::sample_trilinear<2, float>(
+                    view, 0.3, -2, 5, mode
+                );
+                ASSERT_EQ(n[0], 0);
+                ASSERT_EQ(n[1], 0);
+                ASSERT_EQ(t[0], 0);
+                ASSERT_EQ(t[1], 0);
+            }
+        }
+    }
+
+
+    TEST(Sample3D, DISABLED_Benchmark) {
+        const auto img = ::make_volume<float>(4, 128, 128, 128, 1);
+        const auto view = img.make_view();
+        const auto points = ::make_points(1000000, 0, 1);
+
+        // Naive trilinear going through texel_ptr for every corner
+        double naive_sum = 0;
+        sung::MonotonicRealtimeTimer timer;
+        for (const auto& p : points) {
+            const auto x = p.x() * 128, y = p.y() * 128, z = p.z() * 128;
+            const auto x0 = static_cast<size_t>(x);
+            const auto y0 = static_cast<size_t>(y);
+            const auto z0 = static_cast<size_t>(z);
+            const auto fx = x - x0, fy = y - y0, fz = z - z0;
+            for (size_t i = 0; i < 8; ++i) {
+                const auto dx = i & 1, dy = (i >> 1) & 1, dz = (i >> 2) & 1;
+                const auto w = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy) *
+                               (dz ? fz : 1 - fz);
+                naive_sum += w * img.texel_ptr(x0 + dx, y0 + dy, z0 + dz)[0];
+            }
+        }
+        const auto naive_time = timer.check_get_elapsed();
+
+        double scalar_sum = 0;
+        for (const auto& p : points) {
+            scalar_sum += sung::sample_trilinear<4, float>(
+                view, p.x(), p.y(), p.z(), sung::AddressMode::clamp
+            )[0];
+        }
+        const auto scalar_time = timer.check_get_elapsed();
+
+        std::vector<float> out(points.size() * 4);
+        sung::sample_trilinear_batch(
+            out.data(),
+            view,
+            points.data(),
+            points.size(),
+            sung::AddressMode::clamp
+        );
+        const auto batch_time = timer.elapsed();
+
+        double batch_sum = 0;
+        for (size_t i = 0; i < points.size(); ++i) batch_sum += out[i * 4];
+        ASSERT_NEAR(scalar_sum, batch_sum, 1e-2);
+        ASSERT_NEAR(naive_sum, batch_sum, 1e-2);
+        std::cout << "1M trilinear RGBA32F samples, texel_ptr: " << naive_time
+                  << " sec, scalar: " << scalar_time
+                  << " sec, batch: " << batch_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
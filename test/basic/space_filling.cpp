@@ -0,0 +1,304 @@
+#include "sung/basic/space_filling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    using Vec3 = sung::TVec3<double>;
+
+
+    std::vector<Vec3> make_points(size_t count) {
+        sung::RandomRealNumGenerator<double> rng{ -100, 100 };
+        std::vector<Vec3> out(count);
+        for (auto& p : out) p = Vec3{ rng.gen(), rng.gen(), rng.gen() };
+        return out;
+    }
+
+    uint32_t abs_diff(uint32_t a, uint32_t b) { return a > b ? a - b : b - a; }
+
+
+    TEST(SpaceFilling, Morton) {
+        static_assert(sung::morton_encode_2d(1, 0) == 1, "");
+        static_assert(sung::morton_encode_2d(0, 1) == 2, "");
+        static_assert(sung::morton_encode_2d(3, 3) == 15, "");
+        static_assert(sung::morton_encode_3d(1, 0, 0) == 1, "");
+        static_assert(sung::morton_encode_3d(0, 1, 0) == 2, "");
+        static_assert(sung::morton_encode_3d(0, 0, 1) == 4, "");
+        static_assert(sung::morton_encode_3d(3, 3, 3) == 63, "");
+
+        sung::RandomIntegerGenerator<uint32_t> rng32{ 0, 0xffffffff };
+        sung::RandomIntegerGenerator<uint32_t> rng21{ 0, (1 << 21) - 1 };
+        for (int i = 0; i < 1000; ++i) {
+            const auto x = rng32.gen(), y = rng32.gen();
+            const auto code = sung::morton_encode_2d(x, y);
+            ASSERT_EQ(sung::morton_encode_2d_fast(x, y), code);
+            uint32_t dx, dy;
+            sung::morton_decode_2d_fast(code, dx, dy);
+            ASSERT_EQ(dx, x);
+            ASSERT_EQ(dy, y);
+            ASSERT_EQ(sung::morton_decode_2d_x(code), x);
+            ASSERT_EQ(sung::morton_decode_2d_y(code), y);
+        }
+        for (int i = 0; i < 1000; ++i) {
+            const auto x = rng21.gen(), y = rng21.gen(), z = rng21.gen();
+            const auto code = sung::morton_encode_3d(x, y, z);
+            ASSERT_EQ(sung::morton_encode_3d_fast(x, y, z), code);
+            uint32_t dx, dy, dz;
+            sung::morton_decode_3d_fast(code, dx, dy, dz);
+            ASSERT_EQ(dx, x);
+            ASSERT_EQ(dy, y);
+            ASSERT_EQ(dz, z);
+            ASSERT_EQ(sung::morton_decode_3d_x(code), x);
+            ASSERT_EQ(sung::morton_decode_3d_y(code), y);
+            ASSERT_EQ(sung::morton_decode_3d_z(code), z);
+        }
+    }
+
+
+    TEST(SpaceFilling, Hilbert2D) {
+        static_assert(sung::hilbert_encode_2d(0, 0, 1) == 0, "");
+        static_assert(sung::hilbert_encode_2d(0, 1, 1) == 1, "");
+        static_assert(sung::hilbert_encode_2d(1, 1, 1) == 2, "");
+        static_assert(sung::hilbert_encode_2d(1, 0, 1) == 3, "");
+
+        // Consecutive codes are neighboring cells
+        constexpr uint32_t BITS = 6;
+        constexpr uint32_t SIZE = 1 << BITS;
+        uint32_t px = 0, py = 0;
+        for (uint64_t d = 0; d < SIZE * SIZE; ++d) {
+            uint32_t x, y;
+            sung::hilbert_decode_2d(d, BITS, x, y);
+            ASSERT_LT(x, SIZE);
+            ASSERT_LT(y, SIZE);
+            ASSERT_EQ(sung::hilbert_encode_2d(x, y, BITS), d);
+            if (d > 0) {
+                ASSERT_EQ(::abs_diff(x, px) + ::abs_diff(y, py), 1u);
+            }
+            px = x;
+            py = y;
+        }
+    }
+
+
+    TEST(SpaceFilling, Hilbert3D) {
+        constexpr uint32_t BITS = 4;
+        constexpr uint32_t SIZE = 1 << BITS;
+        std::vector<bool> visited(SIZE * SIZE * SIZE, false);
+        uint32_t px = 0, py = 0, pz = 0;
+        for (uint64_t d = 0; d < SIZE * SIZE * SIZE; ++d) {
+            uint32_t x, y, z;
+            sung::hilbert_decode_3d(d, BITS, x, y, z);
+            ASSERT_LT(x, SIZE);
+            ASSERT_LT(y, SIZE);
+            ASSERT_LT(z, SIZE);
+            ASSERT_EQ(sung::hilbert_encode_3d(x, y, z, BITS), d);
+
+            const auto cell = (z * SIZE + y) * SIZE + x;
+            ASSERT_FALSE(visited[cell]);
+            visited[cell] = true;
+
+            if (d > 0) {
+                const auto dist = ::abs_diff(x, px) + ::abs_diff(y, py) +
+                                  ::abs_diff(z, pz);
+                ASSERT_EQ(dist, 1u);
+            }
+            px = x;
+            py = y;
+            pz = z;
+        }
+
+        sung::RandomIntegerGenerator<uint32_t> rng{ 0, (1 << 21) - 1 };
+        for (int i = 0; i < 1000; ++i) {
+            const auto x = rng.gen(), y = rng.gen(), z = rng.gen();
+            const auto code = sung::hilbert_encode_3d(x, y, z, 21);
+            uint32_t dx, dy, dz;
+            sung::hilbert_decode_3d(code, 21, dx, dy, dz);
+            ASSERT_EQ(dx, x);
+            ASSERT_EQ(dy, y);
+            ASSERT_EQ(dz, z);
+        }
+    }
+
+
+    TEST(SpaceFilling, RadixSort) {
+        auto sche = sung::create_task_scheduler();
+        sung::RandomIntegerGenerator<uint64_t> rng{ 0, 0xffffffffffff };
+
+        for (size_t count : { 0, 1, 1000, 300000 }) {
+            std::vector<uint64_t> keys(count);
+            std::vector<uint32_t> values(count);
+            for (size_t i = 0; i < count; ++i) {
+                // Plenty of duplicates to check stability
+                keys[i] = rng.gen() % (count / 4 + 1);
+                values[i] = static_cast<uint32_t>(i);
+            }
+
+            std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+            for (size_t i = 0; i < count; ++i)
+                expected[i] = { keys[i], values[i] };
+            std::sort(expected.begin(), expected.end());
+
+            sung::radix_sort_pairs(keys, values, sche.get());
+            for (size_t i = 0; i < count; ++i) {
+                ASSERT_EQ(keys[i], expected[i].first);
+                ASSERT_EQ(values[i], expected[i].second);
+            }
+        }
+    }
+
+
+    TEST(SpaceFilling, PointOrder) {
+        const auto points = ::make_points(10000);
+
+        for (auto curve : { sung::SpaceCurve::morton,
+                            sung::SpaceCurve::hilbert }) {
+            std::vector<uint32_t> order;
+            sung::make_curve_order(order, points, curve, nullptr);
+            ASSERT_EQ(order.size(), points.size());
+
+            auto sorted = order;
+            std::sort(sorted.begin(), sorted.end());
+            for (size_t i = 0; i < sorted.size(); ++i) ASSERT_EQ(sorted[i], i);
+
+            // Walking along the curve is much shorter than the random order
+            double random_walk = 0, curve_walk = 0;
+            for (size_t i = 1; i < points.size(); ++i) {
+                random_walk += points[i].distance(points[i - 1]);
+                curve_walk += points[order[i]].distance(points[order[i - 1]]);
+            }
+            ASSERT_LT(curve_walk * 4, random_walk);
+        }
+    }
+
+
+    TEST(SpaceFilling, NonFinitePoints) {
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const auto inf = std::numeric_limits<double>::infinity();
+        const std::vector<Vec3> points{
+            { 0, 0, 0 }, { 1, 1, 1 }, { nan, 0, 0 }, { inf, -inf, nan },
+            { 0.25, 0.25, 0.25 },
+        };
+
+        std::vector<uint32_t> order;
+        const auto curve = sung::SpaceCurve::morton;
+        sung::make_curve_order(order, points, curve, nullptr);
+        auto sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        ASSERT_EQ(sorted, (std::vector<uint32_t>{ 0, 1, 2, 3, 4 }));
+
+        // The finite points still span the box
+        std::vector<uint32_t> finite;
+        for (auto i : order) {
+            if (0 == i || 1 == i || 4 == i)
+                finite.push_back(i);
+        }
+        ASSERT_EQ(finite, (std::vector<uint32_t>{ 0, 4, 1 }));
+    }
+
+
+    TEST(SpaceFilling, Mesh) {
+        sung::MeshData mesh;
+        sung::UvSphereBuilder{}.build(mesh);
+
+        std::vector<std::array<Vec3, 3>> before;
+        for (size_t i = 0; i + 2 < mesh.indices_.size(); i += 3) {
+            before.push_back({ mesh.vertices_[mesh.indices_[i]].pos_,
+                               mesh.vertices_[mesh.indices_[i + 1]].pos_,
+                               mesh.vertices_[mesh.indices_[i + 2]].pos_ });
+        }
+
+        const auto vtx_count = mesh.vertices_.size();
+        sung::reorder_along_curve(mesh, sung::SpaceCurve::hilbert, nullptr);
+        ASSERT_EQ(mesh.vertices_.size(), vtx_count);
+        ASSERT_EQ(mesh.indices_.size(), before.size() * 3);
+
+        std::vector<std::array<Vec3, 3>> after;
+        size_t prev_min = 0;
+        for (size_t i = 0; i + 2 < mesh.indices_.size(); i += 3) {
+            after.push_back({ mesh.vertices_[mesh.indices_[i]].pos_,
+                              mesh.vertices_[mesh.indices_[i + 1]].pos_,
+                              mesh.vertices_[mesh.indices_[i + 2]].pos_ });
+            const auto min_idx = (std::min)(
+                { mesh.indices_[i], mesh.indices_[i + 1], mesh.indices_[i + 2] }
+            );
+            ASSERT_LE(prev_min, min_idx);
+            prev_min = min_idx;
+        }
+
+        // Same triangles with the same winding, in another order
+        const auto less = [](const std::array<Vec3, 3>& a,
+                             const std::array<Vec3, 3>& b) {
+            for (size_t i = 0; i < 3; ++i) {
+                for (size_t j = 0; j < 3; ++j) {
+                    if (a[i][j] != b[i][j])
+                        return a[i][j] < b[i][j];
+                }
+            }
+            return false;
+        };
+        std::sort(before.begin(), before.end(), less);
+        std::sort(after.begin(), after.end(), less);
+        ASSERT_EQ(before.size(), after.size());
+        for (size_t i = 0; i < before.size(); ++i) {
+            for (size_t j = 0; j < 3; ++j)
+                ASSERT_EQ(before[i][j].distance_sqr(after[i][j]), 0);
+        }
+    }
+
+
+    // Cache misses are not measured directly. A random gather over an array
+    // much bigger than the caches shows the effect well enough.
+    TEST(SpaceFilling, DISABLED_LocalityBenchmark) {
+        constexpr size_t COUNT = 2000000;
+        auto points = ::make_points(COUNT);
+        auto sche = sung::create_task_scheduler();
+
+        sung::MonotonicRealtimeTimer timer;
+        std::vector<uint32_t> order;
+        sung::make_curve_order(
+            order, points, sung::SpaceCurve::hilbert, sche.get()
+        );
+        const auto order_time = timer.check_get_elapsed();
+
+        const auto walk = [&](const std::vector<Vec3>& pts,
+                              const std::vector<uint32_t>& visit) {
+            double sum = 0;
+            for (size_t i = 1; i < visit.size(); ++i)
+                sum += pts[visit[i]].distance_sqr(pts[visit[i - 1]]);
+            return sum;
+        };
+
+        // Visit in spatial order, once with the data shuffled and once sorted
+        timer.check();
+        const auto unsorted_sum = walk(points, order);
+        const auto unsorted_time = timer.check_get_elapsed();
+
+        sung::apply_order(points, order);
+        std::vector<uint32_t> identity(COUNT);
+        for (size_t i = 0; i < COUNT; ++i)
+            identity[i] = static_cast<uint32_t>(i);
+        timer.check();
+        const auto sorted_sum = walk(points, identity);
+        const auto sorted_time = timer.elapsed();
+
+        ASSERT_DOUBLE_EQ(unsorted_sum, sorted_sum);
+        std::cout << "Hilbert order of " << COUNT << " points: " << order_time
+                  << " sec, walk unsorted: " << unsorted_time
+                  << " sec, sorted: " << sorted_time << " sec" << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
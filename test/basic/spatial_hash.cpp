@@ -0,0 +1,151 @@
+#include "sung/basic/spatial_hash.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+#include "sung/basic/time.hpp"
+
+
+namespace {
+
+    using Vec3 = sung::SpatialHashGrid3::Vec3;
+
+
+    std::vector<Vec3> make_points(size_t count, double range) {
+        sung::RandomRealNumGenerator<double> rng{ -range, range };
+        std::vector<Vec3> out(count);
+        for (auto& p : out) p = Vec3{ rng.gen(), rng.gen(), rng.gen() };
+        return out;
+    }
+
+
+    TEST(SpatialHash, RadiusQuery) {
+        const auto points = ::make_points(10000, 50);
+        sung::SpatialHashGrid3 grid{ 2 };
+        grid.build(points);
+        ASSERT_EQ(grid.size(), points.size());
+
+        const auto queries = ::make_points(100, 60);
+        std::vector<uint32_t> found;
+        for (auto& q : queries) {
+            grid.query_radius(found, q, 3);
+            std::sort(found.begin(), found.end());
+
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < points.size(); ++i) {
+                if (points[i].distance_sqr(q) <= 9)
+                    expected.push_back(i);
+            }
+            ASSERT_EQ(found, expected);
+        }
+
+        // Larger than the table, so it falls back to a scan
+        grid.query_radius(found, { 0, 0, 0 }, 1000);
+        ASSERT_EQ(found.size(), points.size());
+    }
+
+
+    TEST(SpatialHash, AabbQuery) {
+        const auto points = ::make_points(10000, 50);
+        sung::SpatialHashGrid3 grid{ 4 };
+        grid.build(points);
+
+        const sung::Aabb3D<double> box{ -5, 7, 0, 10, -20, -3 };
+        std::vector<uint32_t> found;
+        grid.query_aabb(found, box);
+        std::sort(found.begin(), found.end());
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            if (box.is_inside_cl(points[i]))
+                expected.push_back(i);
+        }
+        ASSERT_EQ(found, expected);
+    }
+
+
+    TEST(SpatialHash, Spheres) {
+        std::vector<sung::Sphere3> spheres;
+        spheres.emplace_back(0, 0, 0, 1);
+        spheres.emplace_back(10, 0, 0, 5);
+        spheres.emplace_back(-10, 0, 0, 0.5);
+
+        sung::SpatialHashGrid3 grid{ 1 };
+        grid.build(spheres);
+
+        std::vector<uint32_t> found;
+        grid.query_sphere(found, sung::Sphere3{ 2.5, 0, 0, 2.6 });
+        std::sort(found.begin(), found.end());
+        ASSERT_EQ(found, (std::vector<uint32_t>{ 0, 1 }));
+
+        grid.query_aabb(found, { -9.7, -9.6, -1, 1, -1, 1 });
+        ASSERT_EQ(found, (std::vector<uint32_t>{ 2 }));
+    }
+
+
+    TEST(SpatialHash, Extremes) {
+        sung::SpatialHashGrid3 grid;
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const auto inf = std::numeric_limits<double>::infinity();
+        for (double bad : { 0.0, -1.0, nan, inf, 1e-320 }) {
+            ASSERT_FALSE(grid.set_cell_size(bad));
+            ASSERT_EQ(grid.cell_size(), 1);
+        }
+        ASSERT_TRUE(grid.set_cell_size(1e-3));
+        ASSERT_EQ(grid.cell_size(), 1e-3);
+
+        // Cells of these would not fit in int64_t
+        const std::vector<Vec3> points{
+            { 1e300, 0, 0 }, { -1e300, 5, 0 }, { 0, 0, 0 }, { 0, 0, 1e30 }
+        };
+        grid.build(points);
+
+        std::vector<uint32_t> found;
+        grid.query_radius(found, { 1e300, 0, 0 }, 1);
+        ASSERT_EQ(found, (std::vector<uint32_t>{ 0 }));
+        grid.query_radius(found, { 0, 0, 0 }, 1);
+        ASSERT_EQ(found, (std::vector<uint32_t>{ 2 }));
+
+        grid.query_aabb(found, { -1e308, 1e308, -1e308, 1e308, -1e308, 1e308 });
+        ASSERT_EQ(found.size(), points.size());
+        grid.query_aabb(found, { 0, 1e301, -1, 1, -1, 1 });
+        std::sort(found.begin(), found.end());
+        ASSERT_EQ(found, (std::vector<uint32_t>{ 0, 2 }));
+    }
+
+
+    TEST(SpatialHash, DISABLED_Benchmark) {
+        constexpr size_t COUNT = 1000000;
+        const auto points = ::make_points(COUNT, 100);
+        sung::SpatialHashGrid3 grid{ 1 };
+
+        sung::MonotonicRealtimeTimer timer;
+        for (int i = 0; i < 3; ++i) grid.build(points);
+        const auto build_time = timer.elapsed() / 3;
+
+        std::vector<uint32_t> found;
+        size_t found_count = 0;
+        timer.check();
+        for (size_t i = 0; i < 10000; ++i) {
+            grid.query_radius(found, points[i], 1);
+            found_count += found.size();
+        }
+        const auto query_time = timer.elapsed();
+
+        ASSERT_GE(found_count, 10000);
+        std::cout << "Build " << COUNT << " points: " << build_time
+                  << " sec, 10000 queries: " << query_time << " sec"
+                  << std::endl;
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -66,6 +67,33 @@ namespace {
         scheduler->join();
     }
 
+
+    TEST(Threading, ParallelFor) {
+        auto scheduler = sung::create_task_scheduler(4);
+        std::vector<uint64_t> data(100000);
+
+        sung::parallel_for(
+            data.size(),
+            1000,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) data[i] += i;
+            },
+            scheduler.get()
+        );
+        sung::parallel_for(
+            data.size(),
+            333,
+            [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) data[i] += i;
+            },
+            nullptr
+        );
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            ASSERT_EQ(data[i], i * 2);
+        }
+    }
+
 }  // namespace
 
 
@@ -0,0 +1,178 @@
+#include "sung/basic/trisoup_bvh.hpp"
+
+#include <gtest/gtest.h>
+
+#include "sung/basic/random.hpp"
+
+
+namespace {
+
+    using Vec3 = sung::TriSoupBvh3::Vec3;
+
+
+    // [-1, 1]^3 with normals pointing outwards
+    sung::TriSoup3 make_cube() {
+        const double tris[][3][3] = {
+            { { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 } },
+            { { -1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } },
+            { { -1, -1, -1 }, { 1, 1, -1 }, { 1, -1, -1 } },
+            { { -1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 } },
+            { { 1, -1, -1 }, { 1, 1, -1 }, { 1, 1, 1 } },
+            { { 1, -1, -1 }, { 1, 1, 1 }, { 1, -1, 1 } },
+            { { -1, -1, -1 }, { -1, 1, 1 }, { -1, 1, -1 } },
+            { { -1, -1, -1 }, { -1, -1, 1 }, { -1, 1, 1 } },
+            { { -1, 1, -1 }, { -1, 1, 1 }, { 1, 1, 1 } },
+            { { -1, 1, -1 }, { 1, 1, 1 }, { 1, 1, -1 } },
+            { { -1, -1, -1 }, { 1, -1, 1 }, { -1, -1, 1 } },
+            { { -1, -1, -1 }, { 1, -1, -1 }, { 1, -1, 1 } },
+        };
+
+        sung::TriSoup3 soup;
+        for (auto& tri : tris) {
+            for (auto& v : tri) soup.add_vtx(Vec3{ v[0], v[1], v[2] });
+        }
+        return soup;
+    }
+
+    double calc_cube_sdf(const Vec3& p) {
+        const Vec3 q{ std::abs(p.x()) - 1,
+                      std::abs(p.y()) - 1,
+                      std::abs(p.z()) - 1 };
+        const Vec3 q_pos{ (std::max)(q.x(), 0.0),
+                          (std::max)(q.y(), 0.0),
+                          (std::max)(q.z(), 0.0) };
+        const auto inner = (std::max)({ q.x(), q.y(), q.z() });
+        return q_pos.len() + (std::min)(inner, 0.0);
+    }
+
+
+    TEST(TriSoupBvh, ClosestPointTriangle) {
+        const sung::Triangle3 tri{ { 0, 0, 0 }, { 2, 0, 0 }, { 0, 2, 0 } };
+
+        // Face, edge and vertex regions
+        ASSERT_TRUE(tri.find_closest_point({ 0.5, 0.5, 3 }).are_similar(
+            { 0.5, 0.5, 0 }, 1e-12
+        ));
+        ASSERT_TRUE(tri.find_closest_point({ 1, -1, 1 }).are_similar(
+            { 1, 0, 0 }, 1e-12
+        ));
+        ASSERT_TRUE(tri.find_closest_point({ 2, 2, 0 }).are_similar(
+            { 1, 1, 0 }, 1e-12
+        ));
+        ASSERT_TRUE(tri.find_closest_point({ -1, -1, -1 }).are_similar(
+            { 0, 0, 0 }, 1e-12
+        ));
+        ASSERT_DOUBLE_EQ(tri.calc_dist({ 3, 0, 4 }), std::sqrt(1.0 + 16.0));
+
+        // Zero area triangles act like the segment or point they are
+        const sung::Triangle3 seg{ { 0, 0, 0 }, { 2, 0, 0 }, { 1, 0, 0 } };
+        sung::Triangle3::Vec3 bary;
+        const auto on_seg = seg.find_closest_point({ 1.5, 1, 0 }, bary);
+        ASSERT_TRUE(on_seg.are_similar({ 1.5, 0, 0 }, 1e-12));
+        ASSERT_NEAR(bary.x() + bary.y() + bary.z(), 1, 1e-12);
+
+        const sung::Triangle3 dup{ { 0, 0, 0 }, { 0, 0, 0 }, { 0, 3, 0 } };
+        const auto on_dup = dup.find_closest_point({ 1, 1, 0 }, bary);
+        ASSERT_TRUE(on_dup.are_similar({ 0, 1, 0 }, 1e-12));
+
+        const sung::Triangle3 dot{ { 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 } };
+        ASSERT_DOUBLE_EQ(dot.calc_dist({ 1, 1, 3 }), 2);
+    }
+
+
+    TEST(TriSoupBvh, CubeSignedDistance) {
+        const auto soup = ::make_cube();
+        sung::TriSoupBvh3 bvh;
+        bvh.build(soup);
+        ASSERT_EQ(bvh.tri_count(), 12);
+
+        sung::RandomRealNumGenerator<double> rng{ -3, 3 };
+        for (int i = 0; i < 1000; ++i) {
+            const Vec3 p{ rng.gen(), rng.gen(), rng.gen() };
+            ASSERT_NEAR(bvh.calc_signed_dist(p), ::calc_cube_sdf(p), 1e-9);
+        }
+
+        // Closest features are a vertex and an edge
+        ASSERT_NEAR(bvh.calc_signed_dist({ 2, 2, 2 }), std::sqrt(3.0), 1e-9);
+        ASSERT_NEAR(bvh.calc_signed_dist({ 2, 2, 0 }), std::sqrt(2.0), 1e-9);
+        ASSERT_NEAR(bvh.calc_signed_dist({ 0, 0, 0 }), -1, 1e-9);
+    }
+
+
+    TEST(TriSoupBvh, NonFiniteQuery) {
+        sung::TriSoupBvh3 bvh;
+        bvh.build(::make_cube());
+
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const auto inf = std::numeric_limits<double>::infinity();
+        sung::ClosestPointInfo info;
+        ASSERT_FALSE(bvh.find_closest(info, { nan, 0, 0 }));
+        ASSERT_FALSE(bvh.find_closest(info, { 0, inf, 0 }));
+        ASSERT_FALSE(bvh.find_closest({ 0, 0, -inf }).has_value());
+        ASSERT_EQ(bvh.calc_signed_dist({ nan, nan, nan }), 0);
+
+        const Vec3 points[] = { { 2, 0, 0 }, { nan, 0, 0 }, { 0, 0, inf } };
+        std::vector<sung::ClosestPointInfo> found;
+        bvh.find_closest_batch(found, points, 3, nullptr);
+        ASSERT_EQ(found.size(), 3);
+        ASSERT_TRUE(found[0].is_valid());
+        ASSERT_NEAR(found[0].distance_, 1, 1e-12);
+        ASSERT_FALSE(found[1].is_valid());
+        ASSERT_EQ(found[2].tri_idx_, sung::INVALID_TRI_IDX);
+
+        // Nothing is found in an empty BVH either
+        sung::TriSoupBvh3 empty;
+        empty.find_closest_batch(found, points, 1, nullptr);
+        ASSERT_FALSE(found[0].is_valid());
+    }
+
+
+    TEST(TriSoupBvh, RandomSoup) {
+        sung::RandomRealNumGenerator<double> rng{ -100, 100 };
+        sung::RandomRealNumGenerator<double> offset{ -3, 3 };
+
+        sung::TriSoup3 soup;
+        for (int i = 0; i < 3000; ++i) {
+            const Vec3 center{ rng.gen(), rng.gen(), rng.gen() };
+            for (int j = 0; j < 3; ++j) {
+                const Vec3 v{ offset.gen(), offset.gen(), offset.gen() };
+                soup.idx_.push_back(static_cast<uint32_t>(soup.vtx_.size()));
+                soup.vtx_.push_back(center + v);
+            }
+        }
+
+        sung::TriSoupBvh3 bvh;
+        bvh.build(soup);
+
+        std::vector<Vec3> points(2000);
+        for (auto& p : points) p = Vec3{ rng.gen(), rng.gen(), rng.gen() };
+
+        auto sche = sung::create_task_scheduler(4);
+        std::vector<sung::ClosestPointInfo> found;
+        bvh.find_closest_batch(found, points.data(), points.size(), sche.get());
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            double best = std::numeric_limits<double>::max();
+            for (size_t t = 0; t < soup.tri_count(); ++t) {
+                const sung::Triangle3 tri{ soup.vtx_[soup.idx_[t * 3 + 0]],
+                                           soup.vtx_[soup.idx_[t * 3 + 1]],
+                                           soup.vtx_[soup.idx_[t * 3 + 2]] };
+                best = (std::min)(best, tri.calc_dist(points[i]));
+            }
+            ASSERT_NEAR(found[i].distance_, best, 1e-9);
+
+            const auto t = found[i].tri_idx_;
+            const sung::Triangle3 tri{ soup.vtx_[soup.idx_[t * 3 + 0]],
+                                       soup.vtx_[soup.idx_[t * 3 + 1]],
+                                       soup.vtx_[soup.idx_[t * 3 + 2]] };
+            ASSERT_NEAR(tri.calc_dist(points[i]), best, 1e-9);
+        }
+    }
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}